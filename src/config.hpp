@@ -1,12 +1,39 @@
 #pragma once
-#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Note page pool placement: 0 = DTCM, 1 = OCRAM (DMAMEM), 2 = PSRAM (EXTMEM)
+#ifndef NOTE_POOL_REGION
+#define NOTE_POOL_REGION 1
+#endif
 
 namespace cfg {
     constexpr uint32_t TICK_HZ = 1000; // Tick frequency in Hz
     constexpr uint32_t TICK_US = 1000000UL / TICK_HZ; // Maximum microseconds per tick
     constexpr size_t RB_CAP = 1024; // Ring buffer capacity
     constexpr uint8_t PCF_ADDRESS = 0x20; // I2C address for PCF8575
-    
+
     // Encoder configuration
     constexpr uint32_t ENCODER_DEBOUNCE_US = 5000; // Encoder debounce time in microseconds
-}
\ No newline at end of file
+
+    // Note storage
+#if NOTE_POOL_REGION == 2
+    constexpr uint16_t NOTE_POOL_PAGES = 16384; // 32 notes per page (~6 MB of PSRAM)
+#else
+    constexpr uint16_t NOTE_POOL_PAGES = 512; // 32 notes per page (~195 KB)
+#endif
+    constexpr uint8_t TRACK_INDEX_PAGES = 10; // per-track index pages past the first 8 pages (61,696 notes)
+
+    // Song mode
+    constexpr uint8_t BANK_PATTERNS = 8;     // patterns a song chain can reference
+    constexpr uint8_t SONG_MAX_ENTRIES = 64; // chain length
+
+    // Undo history (copy-on-write pattern snapshots)
+    constexpr uint8_t UNDO_DEPTH = 8;           // snapshots kept (undo + redo)
+    constexpr uint16_t UNDO_RESERVE_PAGES = 64; // evict old snapshots when fewer pool pages are free
+
+    // Storage
+    constexpr const char *PATTERN_FILE = "/patterns.smq";
+    constexpr uint8_t STREAM_RING_BLOCKS = 32;       // 512 B each, read-ahead for streaming playback
+    constexpr uint32_t STREAM_LEAD_TICKS = 4 * 4 * 96; // read in bursts while less than 4 bars are buffered
+}
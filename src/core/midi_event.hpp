@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+
+struct MidiEvent
+{
+    uint8_t ch;
+    uint8_t pitch;
+    uint8_t vel;
+    bool on;
+    uint32_t delay_us;
+};
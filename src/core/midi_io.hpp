@@ -1,14 +1,6 @@
 #pragma once
 #include <Arduino.h>
-
-struct MidiEvent
-{
-    uint8_t ch;
-    uint8_t pitch;
-    uint8_t vel;
-    bool on;
-    uint32_t delay_us;
-};
+#include "midi_event.hpp"
 
 class MidiIO
 {
@@ -28,6 +20,11 @@ public:
     void sendStart() { Serial1.write(0xFA); }
     void sendContinue() { Serial1.write(0xFB); }
     void sendStop() { Serial1.write(0xFC); }
+    // Song Position Pointer in MIDI beats (1/16 notes), 14 bits
+    void sendSongPosition(uint16_t beats)
+    {
+        Serial1.write(0xF2); Serial1.write(beats & 0x7F); Serial1.write((beats >> 7) & 0x7F);
+    }
     // Send Note Off on all notes for a channel immediately
     void allNotesOff(uint8_t ch)
     {
@@ -1,5 +1,6 @@
 #pragma once
-#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <atomic>
 
 template <typename T, size_t N>
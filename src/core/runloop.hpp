@@ -2,7 +2,14 @@
 #include <vector>
 
 #include "model/pattern.hpp"
+#include "model/pattern_history.hpp"
 #include "engine/playback_engine.hpp"
+#include "engine/timeline.hpp"
+#include "engine/pattern_swap.hpp"
+#include "engine/song_player.hpp"
+#include "engine/stream_player.hpp"
+#include "engine/record_engine.hpp"
+#include "engine/evolve.hpp"
 
 #include "core/tick_scheduler.hpp"
 #include "core/transport.hpp"
@@ -10,7 +17,9 @@
 
 struct AppEvent
 {
-    enum class Type : uint8_t { Play, Stop, Pause, Resume } type;
+    static constexpr uint8_t ALL = 0xFF;
+    enum class Type : uint8_t { Play, Stop, Pause, Resume, Mute, Solo, Fill } type;
+    uint8_t arg{0}; // Mute/Solo: track to toggle (Solo ALL clears every solo); Fill: 1 on, 0 off
 };
 
 class RunLoop
@@ -23,8 +32,17 @@ public:
         eng_ = pe;
         midi_ = mi;
         pat_ = pa;
-        evs_.reserve(32);
+        swap_.begin(pa);
+        hist_.begin(pa);
+        evs_.reserve(128);
     }
+    // Song mode: chain of bank patterns, see SongPlayer
+    void attachSong(PatternBank *bank, Song *song) { song_.begin(bank, song); }
+    // Streaming playback from the card: read-ahead ring and lead target, see StreamPlayer
+    void attachStream(stream_file::Block *ring, uint8_t blocks, uint32_t leadTicks) { stream_.begin(ring, blocks, leadTicks); }
+    // Live recording: staged notes are merged into the pattern once per pass
+    void attachRecorder(RecordEngine *rec) { rec_ = rec; }
+    RecordEngine *recorder() { return rec_; }
     void post(const AppEvent &e) { if (evtN_ < MaxEvt) evtQ_[evtN_++] = e; }
     void service()
     {
@@ -34,20 +52,39 @@ public:
             const auto &e = evtQ_[i];
             switch (e.type)
             {
-            case AppEvent::Type::Play: tx_->resume(); midi_->sendContinue(); break;
+            case AppEvent::Type::Play: tx_->resume(); sendPosition(); midi_->sendContinue(); break;
             case AppEvent::Type::Stop:
+            {
                 tx_->stop();
-                // Proactively silence current pattern channel
+                song_.rewind(swap_);
+                // Release what the engine still holds, then CC-silence every channel in use
+                eng_->allOff(evs_);
+                stream_.allOff(evs_);
+                for (const auto &m : evs_)
+                    midi_->send(m);
+                evs_.clear();
+                stream_.locate(0); // read ahead now rather than on the first tick after Play
+                uint16_t used = stream_.channels();
                 if (pat_)
-                {
-                    uint8_t ch = pat_->track.channel;
-                    midi_->allNotesOff(ch);
-                    midi_->sendAllNotesOffCC(ch, true);
-                }
+                    for (uint8_t t = 0; t < pat_->trackCount; ++t)
+                        used |= 1u << ((pat_->tracks[t].channel - 1) & 0x0F);
+                for (uint8_t ch = 1; ch <= 16; ++ch)
+                    if (used & (1u << (ch - 1)))
+                        midi_->sendAllNotesOffCC(ch, true);
                 midi_->sendStop();
                 break;
+            }
             case AppEvent::Type::Pause: tx_->pause(); break;
-            case AppEvent::Type::Resume: tx_->resume(); midi_->sendContinue(); break;
+            case AppEvent::Type::Resume: tx_->resume(); sendPosition(); midi_->sendContinue(); break;
+            // Flag/mask flips only; the engine applies them on the next tick
+            case AppEvent::Type::Mute:
+                if (e.arg < Pattern::MAX_TRACKS)
+                    pat_->tracks[e.arg].mute = !pat_->tracks[e.arg].mute;
+                break;
+            case AppEvent::Type::Solo:
+                eng_->setSolo(e.arg == AppEvent::ALL ? 0 : (uint16_t)(eng_->solo() ^ (1u << (e.arg & 0x0F))));
+                break;
+            case AppEvent::Type::Fill: eng_->setFill(e.arg != 0); break;
             }
         }
         evtN_ = 0;
@@ -56,11 +93,60 @@ public:
         TickWindow w;
 
         while (sched_->fetch(e))
-            tx_->on1ms();
+            tx_->on1ms(e.tmicros);
+
+        // Staged patterns compile here, ahead of their boundary (song cues one track
+        // per pass); with the transport stopped they swap in at once
+        song_.idle(swap_);
+        if (swap_.pending())
+        {
+            if (!swap_.pendingCue())
+                swap_.prepare();
+            if (!tx_->isRunning() && !tx_->isPaused())
+            {
+                applySwap();
+                song_.flipped();
+                tx_->setSongBase(song_.base());
+            }
+        }
+
+        hist_.trim();
+        stream_.fill(tx_->playTick());
+
+        // Evolve mode plans its next edits a slice at a time
+        if (evo_.armed())
+        {
+            const uint32_t t0 = micros();
+            if (evo_.idle(*pat_))
+                evo_.noteSliceUs(micros() - t0);
+        }
+
+        // Recorded notes go in by the batch, spaced out further while a commit runs long
+        if (rec_)
+        {
+            const uint32_t t0 = micros();
+            if (rec_->idle(t0))
+                rec_->noteCommitUs(micros() - t0);
+        }
+        // Recompile tracks edited since the last pass (recording, serial, undo), a few
+        // per pass: a groove edit dirties them all, the rest follow on the next passes
+        Timeline &tl = swap_.front();
+        const TakeStack *takes = rec_ ? &rec_->takes() : nullptr;
+        if (tl.stale(*pat_, takes))
+            tl.build(*pat_, BUILD_BUDGET, takes);
 
         while (tx_->next(w))
         {
-            eng_->processTick(w.prev, w.curr, *pat_, evs_);
+            bool flip = swap_.boundary(w.prev, w.curr);
+            if (song_.window(w.prev, w.curr))
+                flip = swap_.pending(); // entry boundary: the cued pattern goes in now
+            if (flip)
+                applySwap();
+            if (evo_.boundary(w.prev, w.curr))
+                applyEvolve(takes);
+            tx_->setSongBase(song_.base());
+            eng_->processTick(w.prev, w.curr, swap_.front(), pat_->tempo, evs_);
+            stream_.processTick(w.prev, w.curr, pat_->tempo, evs_);
             if (++clkDiv_ == 4)
             {
                 midi_->sendClock();
@@ -75,6 +161,37 @@ public:
         midi_->update();
     }
     uint32_t playTick() const { return tx_->playTick(); }
+    const Timeline &timeline() const { return swap_.front(); }
+    PatternSwap &swapper() { return swap_; }
+    const PlaybackEngine *engine() const { return eng_; }
+    // Probability seed for the next start/locate (see PlaybackEngine)
+    void setTrigSeed(uint32_t seed) { eng_->setSeed(seed); }
+    SongPlayer &song() { return song_; }
+    StreamPlayer &stream() { return stream_; }
+    Evolver &evolver() { return evo_; }
+
+    // A stream sets the transport loop to its own length until closed
+    bool openStream(const char *path)
+    {
+        if (!stream_.open(path))
+            return false;
+        tx_->setLoopLen(loopTicks());
+        return true;
+    }
+    void closeStream()
+    {
+        stream_.allOff(evs_);
+        for (const auto &m : evs_)
+            midi_->send(m);
+        evs_.clear();
+        stream_.close();
+        tx_->setLoopLen(loopTicks());
+    }
+    PatternHistory &history() { return hist_; }
+
+    // Undo/redo drop a queued (non-song) swap so it cannot overwrite the restored state
+    bool undo() { return restore(true); }
+    bool redo() { return restore(false); }
 
 private:
     TickScheduler *sched_{};
@@ -82,11 +199,57 @@ private:
     PlaybackEngine *eng_{};
     MidiIO *midi_{};
     Pattern *pat_{};
+    PatternSwap swap_;
+    SongPlayer song_;
+    PatternHistory hist_;
+    StreamPlayer stream_;
+    RecordEngine *rec_{nullptr};
+    Evolver evo_;
 
     std::vector<MidiEvent> evs_;
     
     uint8_t clkDiv_{0}; // 96/24 = 4 ticks per MIDI clock
 
+    void applySwap()
+    {
+        uint32_t t0 = micros();
+        swap_.apply(eng_->sounding());
+        tx_->setLoopLen(loopTicks());
+        tx_->setTempo(pat_->tempo);
+        swap_.noteApplyUs(micros() - t0);
+    }
+
+    // Write the evolve plan into the live track and recompile it before this window plays;
+    // only that track, and Evolver only takes tracks of up to MAX_NOTES, so this stays bounded
+    void applyEvolve(const TakeStack *takes)
+    {
+        uint32_t t0 = micros();
+        if (evo_.apply(*pat_))
+            swap_.front().buildTrack(*pat_, evo_.track(), takes);
+        evo_.noteApplyUs(micros() - t0);
+    }
+
+    bool restore(bool back)
+    {
+        if (swap_.pending() && !swap_.pendingCue())
+            swap_.cancel();
+        if (!(back ? hist_.undo() : hist_.redo()))
+            return false;
+        tx_->setLoopLen(loopTicks());
+        return true;
+    }
+
+    uint32_t loopTicks() const { return stream_.isOpen() ? stream_.length() : pat_->ticks(); }
+
+    // SPP ahead of Continue so external gear picks up at the song position
+    void sendPosition()
+    {
+        uint32_t beats = tx_->songTick() / timebase::ticksPerStep(16);
+        midi_->sendSongPosition((uint16_t)(beats > 0x3FFF ? 0x3FFF : beats));
+    }
+
+    static constexpr uint8_t BUILD_BUDGET = 2; // live timeline tracks recompiled per service() pass
+
     // Simple event queue
     static constexpr size_t MaxEvt = 8;
     AppEvent evtQ_[MaxEvt]{};
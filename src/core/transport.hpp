@@ -32,10 +32,12 @@ public:
     void pause() { paused_ = true; running_ = false; }
     void resume() { running_ = true; paused_ = false; }
     void locate(uint32_t tick) { play_ = tick % loopLen_; }
-    void on1ms()
+    // us: when the millisecond elapsed (TickEvent::tmicros), anchors offsetAt()
+    void on1ms(uint32_t us = 0)
     {
         if (!running_)
             return;
+        lastUs_ = us;
         phase_ += 1000;
         while (phase_ >= uptick_)
         {
@@ -54,17 +56,35 @@ public:
         return true;
     }
     uint32_t playTick() const { return play_; }
+    uint32_t tickUs() const { return uptick_; }
+    // Musical position at micros() timestamp `us` (e.g. a key-scan edge) as whole
+    // ticks from playTick() (negative: before it) plus the rest in 1/256 tick
+    int32_t offsetAt(uint32_t us, uint8_t &frac_q8) const
+    {
+        frac_q8 = 0;
+        const int32_t dt = (int32_t)(us - lastUs_);
+        if (!running_ || dt > 100000 || dt < -100000) // no anchor yet (just started)
+            return 0;
+        const int64_t p = (int64_t)phase_ + dt; // us since the last generated tick
+        const int64_t t = p >= 0 ? p / uptick_ : -((-p + uptick_ - 1) / uptick_);
+        frac_q8 = (uint8_t)(((p - t * uptick_) << 8) / uptick_);
+        return (int32_t)(pend_ + t);
+    }
+    // Song mode: absolute tick where the current pattern pass began (0 when looping one pattern)
+    void setSongBase(uint32_t t) { songBase_ = t; }
+    uint32_t songTick() const { return songBase_ + play_; }
     uint16_t tpqn() const { return tempo_.tpqn; }
     uint8_t  clockDivisor() const { return 96 / (tempo_.tpqn / 24); } // e.g. TPQN=96 → 4
     // Song position in bars:beats:ticks assuming 4/4 and step=1/16 → 4 steps per beat
     void songPos(uint32_t &bars, uint32_t &beats, uint32_t &ticks) const {
         const uint32_t step = timebase::ticksPerStep(16); // 1/16 grid
         const uint32_t stepsPerBeat = 4; // 4 sixteenths per beat in 4/4
-        uint32_t stepIdx = play_ / step;
+        const uint32_t t = songTick();
+        uint32_t stepIdx = t / step;
         beats = stepIdx / stepsPerBeat;
         bars = beats / 4;
         beats = beats % 4;
-        ticks = play_ % step;
+        ticks = t % step;
     }
 private:
     Tempo tempo_{};
@@ -75,6 +95,8 @@ private:
     uint32_t uptick_{usPerTick(tempo_)};
     uint32_t loopLen_{1};
     uint32_t play_{0};
+    uint32_t songBase_{0};
     uint32_t pend_{0};
     uint32_t phase_{0};
+    uint32_t lastUs_{0};
 };
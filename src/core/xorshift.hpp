@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * xorshift32 (Marsaglia): three shifts and xors per draw, 4 bytes of state,
+ * period 2^32-1. Deterministic for a given seed, so anything driven by it
+ * (note probability, generator variation) replays exactly.
+ */
+struct XorShift32
+{
+    uint32_t s{0x9E3779B9u};
+
+    XorShift32() = default;
+    explicit XorShift32(uint32_t seed) { this->seed(seed); }
+
+    // Any seed is usable; the all-zero state (a fixed point) is remapped
+    void seed(uint32_t v) { s = v ? v : 0x9E3779B9u; }
+
+    uint32_t next()
+    {
+        uint32_t x = s;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return s = x;
+    }
+    // Uniform in [0, n) by multiply-shift (no division)
+    uint32_t below(uint32_t n) { return (uint32_t)(((uint64_t)next() * n) >> 32); }
+    uint8_t percent() { return (uint8_t)below(100); }
+    // Uniform in [-r, r]
+    int32_t spread(uint32_t r) { return (int32_t)below(2 * r + 1) - (int32_t)r; }
+};
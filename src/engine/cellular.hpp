@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * One-dimensional cellular automata on a 64-cell ring held in one word
+ * (bit i = cell i). A generation is evaluated for all cells at once: the
+ * left and right neighbours are the row rotated by one, and the rule is a
+ * handful of AND/OR terms over the three words, so hundreds of generations
+ * cost a few microseconds.
+ */
+namespace ca {
+
+using Row = uint64_t;
+constexpr uint8_t CELLS = 64;
+
+inline Row rotl(Row x) { return (x << 1) | (x >> 63); }
+inline Row rotr(Row x) { return (x >> 1) | (x << 63); }
+
+// Elementary rule (Wolfram number): bit n of `rule` is the next state of a
+// cell whose (left, self, right) neighbourhood reads n in binary
+inline Row elementary(Row x, uint8_t rule)
+{
+    const Row l = rotl(x), r = rotr(x); // cell i's left is i-1, its right i+1
+    Row next = 0;
+    for (uint8_t n = 0; n < 8; ++n)
+        if (rule & (1u << n))
+            next |= (n & 4 ? l : ~l) & (n & 2 ? x : ~x) & (n & 1 ? r : ~r);
+    return next;
+}
+
+// Totalistic rule: bit s of `code` (0..15) is the next state of a cell
+// whose neighbourhood holds s live cells, itself included
+inline Row totalistic(Row x, uint8_t code)
+{
+    const Row l = rotl(x), r = rotr(x);
+    const Row s0 = l ^ x ^ r;                // sum bit 0
+    const Row s1 = (l & x) | (r & (l ^ x));  // sum bit 1
+    Row next = 0;
+    if (code & 1)
+        next |= ~s1 & ~s0;
+    if (code & 2)
+        next |= ~s1 & s0;
+    if (code & 4)
+        next |= s1 & ~s0;
+    if (code & 8)
+        next |= s1 & s0;
+    return next;
+}
+
+enum Mode : uint8_t { Elementary = 0, Totalistic = 1 };
+
+inline Row step(Row x, Mode m, uint8_t rule) { return m == Totalistic ? totalistic(x, rule & 0x0F) : elementary(x, rule); }
+
+inline Row advance(Row x, Mode m, uint8_t rule, uint32_t generations)
+{
+    while (generations--)
+        x = step(x, m, rule);
+    return x;
+}
+
+} // namespace ca
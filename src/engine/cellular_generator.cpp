@@ -0,0 +1,86 @@
+#include "cellular_generator.hpp"
+#include "core/xorshift.hpp"
+#include "model/note.hpp"
+
+CellularGenerator::CellularGenerator()
+{
+    params_.bind(PARAMS, PARAM_COUNT, values_);
+}
+
+ca::Row CellularGenerator::firstRow() const
+{
+    const uint32_t seed = (uint32_t)params_.getInt(Seed);
+    ca::Row row = (ca::Row)1 << (ca::CELLS / 2);
+    if (seed)
+    {
+        XorShift32 rng(seed);
+        const ca::Row hi = rng.next();
+        row = (hi << 32) | rng.next();
+    }
+    return ca::advance(row, (ca::Mode)params_.getInt(Mode), (uint8_t)params_.getInt(Rule),
+                       (uint32_t)params_.getInt(Offset));
+}
+
+void CellularGenerator::generate(Pattern &pattern)
+{
+    Track &track = pattern.selected();
+    track.notes.clear();
+
+    const ca::Mode mode = (ca::Mode)params_.getInt(Mode);
+    const uint8_t rule = (uint8_t)params_.getInt(Rule);
+    const uint32_t rate = (uint32_t)params_.getInt(Rate);
+    const int32_t baseNote = params_.getInt(BaseNote);
+    const uint8_t width = (uint8_t)params_.getInt(Width);
+    const Scale sc = (Scale)params_.getInt(ScaleSel);
+    const int32_t velocity = params_.getInt(Velocity);
+    const gen::fx duration = params_.raw(Duration);
+    uint32_t steps = (uint32_t)params_.getInt(Length);
+    if (steps > pattern.steps)
+        steps = pattern.steps;
+
+    // Played window: `width` cells centred on the ring
+    const uint8_t lo = (uint8_t)((ca::CELLS - width) / 2);
+    const ca::Row window = (width >= ca::CELLS ? ~(ca::Row)0 : (((ca::Row)1 << width) - 1)) << lo;
+    int8_t pitchOf[24];
+    for (uint8_t c = 0; c < width; ++c)
+    {
+        const int p = sc == Scale::None ? baseNote + c : baseNote + 12 * (c / 7) + scale::degreeSemitone(sc, c % 7);
+        pitchOf[c] = (int8_t)(p > 127 ? -1 : p);
+    }
+
+    uint32_t ticksPerStep = (96 * 4) / pattern.grid;
+    ca::Row row = firstRow(), prev = row;
+    for (uint32_t s = 0; s < steps; ++s)
+    {
+        const ca::Row live = row & window, born = row & ~prev;
+        for (ca::Row b = live; b; b &= b - 1)
+        {
+            const uint8_t c = (uint8_t)(__builtin_ctzll(b) - lo);
+            if (pitchOf[c] < 0)
+                continue;
+            Note note{};
+            note.on = s * ticksPerStep;
+            note.duration = (uint32_t)(((int64_t)ticksPerStep * duration) >> 16);
+            note.pitch = (uint8_t)pitchOf[c];
+            const int v = velocity + (((born >> (c + lo)) & 1) ? 16 : 0);
+            note.vel = (uint8_t)(v > 127 ? 127 : v);
+            if (!track.notes.push_back(note))
+                break;
+        }
+        prev = row;
+        row = ca::advance(row, mode, rule, rate);
+    }
+
+    Serial.printf("CellularGenerator: rule %u, %lu steps, %u notes\n", rule, (unsigned long)steps,
+                  (unsigned)track.notes.size());
+}
+
+uint8_t CellularGenerator::drift(const Note &n, uint8_t semitones, XorShift32 &rng) const
+{
+    const Scale sc = (Scale)params_.getInt(ScaleSel);
+    const uint8_t root = (uint8_t)params_.getInt(BaseNote);
+    uint8_t p = Generator::drift(n, semitones, rng);
+    while (p > 0 && !scale::contains(sc, root, p))
+        p--;
+    return p;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "generator.hpp"
+#include "engine/cellular.hpp"
+#include "model/scale.hpp"
+
+/**
+ * Cellular automaton generator.
+ * Evolves a 64-cell ring (ca::step, one word per generation) from a seed row
+ * and plays it as a piano roll: step s is generation offset + s * rate, and
+ * the `width` cells around the middle of the ring are pitches, climbing the
+ * chosen scale from the base note. Same parameters, same pattern.
+ */
+class CellularGenerator : public Generator
+{
+public:
+    // Schema order: ENC1-3 and ENC5-8 of the generative view follow it
+    enum Param : uint8_t
+    {
+        Rule, Seed, Offset, Rate, BaseNote, Width, Length,
+        Mode, ScaleSel, Velocity, Duration,
+        PARAM_COUNT
+    };
+
+    static constexpr gen::ParamDesc PARAMS[PARAM_COUNT] = {
+        gen::param("rule", "RULE", "Rule number (totalistic: low 4 bits)", 30, 0, 255),
+        gen::param("seed", "SEED", "First row: 0 = one cell, else random from the seed", 0, 0, 255),
+        gen::param("offset", "OFFS", "Generations run before the first step", 0, 0, 255),
+        gen::param("rate", "RATE", "Generations per step", 1, 1, 8),
+        gen::param("base_note", "NOTE", "Pitch of the lowest cell", 48, 0, 127),
+        gen::param("width", "WID", "Cells played (pitches)", 8, 1, 24),
+        gen::param("length", "LEN", "Pattern length in steps", DEFAULT_LENGTH, 1, 64),
+        gen::param("mode", "MODE", "0 elementary, 1 totalistic", 0, 0, 1),
+        gen::param("scale", "SCAL", "Cell pitches: 0 chromatic, 1 Dorian, 2 Lydian", 1, 0, 2),
+        gen::param("velocity", "VEL", "Velocity (cells born this step +16)", DEFAULT_VELOCITY, 1, 127),
+        gen::param("duration", "DUR", "Note duration as fraction of step (0.1-1.0)", 0.5f, 0.1f, 1.0f, 0.1f),
+    };
+    static_assert(gen::uniqueHashes(PARAMS), "parameter names must hash apart");
+    static_assert(gen::at(PARAMS, Rule, "rule") && gen::at(PARAMS, Duration, "duration"),
+                  "PARAMS out of enum order");
+
+    CellularGenerator();
+
+    // Generator interface
+    const char* getName() const override { return "Cellular Automaton"; }
+    const char* getShortName() const override { return "CA"; }
+    void generate(Pattern& pattern) override;
+
+    // Row the pattern starts from (after `offset` generations)
+    ca::Row firstRow() const;
+
+    // Evolve: drifted pitches land on the chosen scale
+    uint8_t drift(const Note& n, uint8_t semitones, XorShift32& rng) const override;
+
+private:
+    gen::fx values_[PARAM_COUNT];
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * Euclidean rhythms as 64-bit step masks (bit i = step i). A layer is one
+ * word, so rotation is a bit-rotate and combining layers (accents, fills,
+ * polyrhythms) is a single AND/OR/XOR; no containers, no allocation.
+ */
+namespace euclid {
+
+using Bits = uint64_t;
+constexpr uint8_t MAX_STEPS = 64;
+
+inline Bits mask(uint8_t steps) { return steps >= MAX_STEPS ? ~(Bits)0 : ((Bits)1 << steps) - 1; }
+
+// `hits` spread as evenly as possible over `steps` (Bresenham; the same
+// placement the generator always produced)
+inline Bits pattern(uint8_t hits, uint8_t steps)
+{
+    if (steps > MAX_STEPS)
+        steps = MAX_STEPS;
+    if (hits >= steps)
+        return mask(steps);
+    Bits b = 0;
+    uint32_t bucket = 0;
+    for (uint8_t i = 0; i < steps; ++i)
+    {
+        bucket += hits;
+        const bool hit = bucket >= steps;
+        bucket -= hit ? steps : 0;
+        b |= (Bits)hit << i;
+    }
+    return b;
+}
+
+// Move every step r later, wrapping within `steps`
+inline Bits rotate(Bits b, uint8_t r, uint8_t steps)
+{
+    if (!steps)
+        return 0;
+    if (steps > MAX_STEPS)
+        steps = MAX_STEPS;
+    r %= steps;
+    if (!r)
+        return b & mask(steps);
+    return ((b << r) | (b >> (steps - r))) & mask(steps);
+}
+
+// How a layer combines with the main rhythm
+enum Op : uint8_t { Or = 0, Xor = 1, Fill = 2 };
+
+inline Bits combine(Bits main, Bits layer, Op op)
+{
+    switch (op)
+    {
+    case Xor: return main ^ layer;
+    case Fill: return layer & ~main; // only the main rhythm's gaps
+    default: return layer;           // its own polyrhythm
+    }
+}
+
+inline uint8_t count(Bits b) { return (uint8_t)__builtin_popcountll(b); }
+// Index of the lowest set step (b != 0)
+inline uint8_t first(Bits b) { return (uint8_t)__builtin_ctzll(b); }
+
+} // namespace euclid
@@ -1,95 +1,35 @@
 #include "euclidean_generator.hpp"
 #include "model/note.hpp"
-#include <cstdlib>
 
 EuclideanGenerator::EuclideanGenerator()
 {
-    initializeParameters();
-}
-
-void EuclideanGenerator::initializeParameters()
-{
-    parameters_.clear();
-
-    parameters_["density"] = GeneratorParameter(
-        "DENS", "Number of hits (steps with notes)",
-        DEFAULT_DENSITY, 1.0f, 64.0f, 1.0f);
-
-    parameters_["length"] = GeneratorParameter(
-        "LEN", "Pattern length in steps",
-        DEFAULT_LENGTH, 1.0f, 64.0f, 1.0f);
-
-    parameters_["velocity"] = GeneratorParameter(
-        "VEL", "Base velocity for generated notes",
-        DEFAULT_VELOCITY, 1.0f, 127.0f, 1.0f);
-
-    parameters_["vel_range"] = GeneratorParameter(
-        "VRAN", "Velocity randomization range (+/-)",
-        DEFAULT_VEL_RANGE, 0.0f, 64.0f, 1.0f);
-
-    parameters_["pitch_range"] = GeneratorParameter(
-        "PRAN", "Pitch randomization range (semitones)",
-        DEFAULT_PITCH_RANGE, 0.0f, 24.0f, 1.0f);
-
-    parameters_["base_note"] = GeneratorParameter(
-        "NOTE", "Base MIDI note number",
-        DEFAULT_BASE_NOTE, 0.0f, 127.0f, 1.0f);
-
-    parameters_["duration"] = GeneratorParameter(
-        "DUR", "Note duration as fraction of step (0.1-1.0)",
-        0.5f, 0.1f, 1.0f, 0.1f);
-}
-
-bool EuclideanGenerator::setParameter(const char* paramName, float value)
-{
-    auto it = parameters_.find(paramName);
-    if (it != parameters_.end())
-    {
-        it->second.setValue(value);
-        return true;
-    }
-    return false;
-}
-
-bool EuclideanGenerator::getParameter(const char* paramName, float& outValue) const
-{
-    auto it = parameters_.find(paramName);
-    if (it != parameters_.end())
-    {
-        outValue = it->second.value;
-        return true;
-    }
-    return false;
-}
-
-std::vector<const char*> EuclideanGenerator::getParameterNames() const
-{
-    std::vector<const char*> names;
-    for (const auto& pair : parameters_)
-    {
-        names.push_back(pair.first);
-    }
-    return names;
+    params_.bind(PARAMS, PARAM_COUNT, values_);
 }
 
 void EuclideanGenerator::resetToDefaults()
 {
-    initializeParameters();
+    params_.reset();
+    rng_.seed(1);
 }
 
 void EuclideanGenerator::generate(Pattern &pattern)
 {
-    // Clear existing notes
-    pattern.track.notes.clear();
+    using euclid::Bits;
+    Track &track = pattern.selected();
+    track.notes.clear();
 
     // Get parameters
-    float density = parameters_["density"].value;
-    float length = parameters_["length"].value;
-    float velocity = parameters_["velocity"].value;
-    float velRange = parameters_["vel_range"].value;
-    float pitchRange = parameters_["pitch_range"].value;
-    float baseNote = parameters_["base_note"].value;
-    float duration = parameters_["duration"].value;
+    int32_t density = params_.getInt(Density);
+    int32_t length = params_.getInt(Length);
+    int32_t velocity = params_.getInt(Velocity);
+    int32_t velRange = params_.getInt(VelRange);
+    int32_t pitchRange = params_.getInt(PitchRange);
+    int32_t baseNote = params_.getInt(BaseNote);
+    gen::fx duration = params_.raw(Duration);
+    // Seed 0 keeps drawing from the generator's own sequence
+    const uint32_t seed = (uint32_t)params_.getInt(Seed);
+    XorShift32 fixed(seed);
+    XorShift32 &rng = seed ? fixed : rng_;
 
     if (length == 0 || density == 0)
     {
@@ -104,27 +44,52 @@ void EuclideanGenerator::generate(Pattern &pattern)
     if (hits > steps)
         hits = steps;
 
-    // Generate Euclidean rhythm
-    std::vector<bool> rhythm = generateEuclideanRhythm(hits, steps);
+    // One word per layer: rhythm, accents, extra voices
+    Bits voice[MAX_VOICES] = {};
+    voice[0] = euclid::rotate(euclid::pattern(hits, steps), (uint8_t)params_.getInt(Rotate), steps);
+    if (pattern.steps < steps)
+        voice[0] &= euclid::mask((uint8_t)pattern.steps); // steps beyond the pattern never play
+    const uint8_t accentHits = (uint8_t)params_.getInt(Accent);
+    const Bits accents = accentHits ? voice[0] & euclid::rotate(euclid::pattern(accentHits, steps),
+                                                                 (uint8_t)params_.getInt(AccentRotate), steps)
+                                    : 0;
+    const uint8_t voices = (uint8_t)params_.getInt(Voices);
+    const Bits layer = euclid::pattern((uint8_t)params_.getInt(LayerHits), steps);
+    const euclid::Op op = (euclid::Op)params_.getInt(LayerOp);
+    Bits any = voice[0];
+    size_t total = euclid::count(voice[0]);
+    for (uint8_t v = 1; v < voices && v < MAX_VOICES; ++v)
+    {
+        const uint8_t rot = (uint8_t)(params_.getInt(LayerRotate) * v % steps);
+        voice[v] = euclid::combine(voice[0], euclid::rotate(layer, rot, steps), op);
+        if (pattern.steps < steps)
+            voice[v] &= euclid::mask((uint8_t)pattern.steps);
+        any |= voice[v];
+        total += euclid::count(voice[v]);
+    }
+    track.notes.reserve(total);
 
-    // Convert rhythm to MIDI notes
+    // Convert rhythm to MIDI notes, step by step so the track stays in start order
     uint32_t ticksPerStep = (96 * 4) / pattern.grid; // Assuming 16th note grid
-
-    for (uint8_t i = 0; i < steps && i < pattern.steps; i++)
+    const int32_t accentVel = params_.getInt(AccentVel), interval = params_.getInt(Interval);
+    for (Bits b = any; b; b &= b - 1)
     {
-        if (rhythm[i])
+        const uint8_t i = euclid::first(b);
+        for (uint8_t v = 0; v < MAX_VOICES; ++v)
         {
-            Note note;
+            if (!((voice[v] >> i) & 1))
+                continue;
+            Note note{};
             note.on = i * ticksPerStep;
-            note.duration = (uint32_t)(ticksPerStep * duration);
+            note.duration = (uint32_t)(((int64_t)ticksPerStep * duration) >> 16);
 
             // Add pitch variation
             int8_t pitchOffset = 0;
             if (pitchRange > 0)
             {
-                pitchOffset = (rand() % (int)(pitchRange * 2 + 1)) - (int)pitchRange;
+                pitchOffset = (int8_t)rng.spread((uint32_t)pitchRange);
             }
-            int pitchValue = (int)baseNote + pitchOffset;
+            int pitchValue = baseNote + v * interval + pitchOffset;
             if (pitchValue < 0) pitchValue = 0;
             if (pitchValue > 127) pitchValue = 127;
             note.pitch = (uint8_t)pitchValue;
@@ -133,43 +98,33 @@ void EuclideanGenerator::generate(Pattern &pattern)
             int8_t velOffset = 0;
             if (velRange > 0)
             {
-                velOffset = (rand() % (int)(velRange * 2 + 1)) - (int)velRange;
+                velOffset = (int8_t)rng.spread((uint32_t)velRange);
             }
-            int velValue = (int)velocity + velOffset;
+            int velValue = velocity + velOffset + (v == 0 && ((accents >> i) & 1) ? accentVel : 0);
             if (velValue < 1) velValue = 1;
             if (velValue > 127) velValue = 127;
             note.vel = (uint8_t)velValue;
-
-            note.micro = 0;
             note.micro_q8 = 0;
             note.flags = 0;
 
-            pattern.track.notes.push_back(note);
+            track.notes.push_back(note);
         }
     }
 
-    Serial.printf("EuclideanGenerator: Generated %d notes (%d hits in %d steps)\n",
-                  pattern.track.notes.size(), hits, steps);
+    Serial.printf("EuclideanGenerator: Generated %d notes (%d hits in %d steps, %d accents, %d voices)\n",
+                  track.notes.size(), hits, steps, euclid::count(accents), voices);
 }
 
-std::vector<bool> EuclideanGenerator::generateEuclideanRhythm(uint8_t hits, uint8_t steps) const
+bool EuclideanGenerator::cacheable() const
 {
-    std::vector<bool> rhythm(steps, false);
-
-    if (hits == 0 || steps == 0)
-        return rhythm;
-
-    // Euclidean algorithm (Bresenham-like)
-    int bucket = 0;
-    for (uint8_t i = 0; i < steps; i++)
-    {
-        bucket += hits;
-        if (bucket >= steps)
-        {
-            bucket -= steps;
-            rhythm[i] = true;
-        }
-    }
+    return params_.getInt(Seed) || (params_.getInt(VelRange) == 0 && params_.getInt(PitchRange) == 0);
+}
 
-    return rhythm;
-}
\ No newline at end of file
+uint8_t EuclideanGenerator::reroll(const Note &n, uint8_t range, XorShift32 &rng) const
+{
+    const int32_t velocity = params_.getInt(Velocity), velRange = params_.getInt(VelRange);
+    const int32_t lo = velocity - velRange, hi = velocity + velRange + params_.getInt(AccentVel);
+    int32_t v = (int32_t)n.vel + rng.spread(range);
+    v = v < lo ? lo : (v > hi ? hi : v);
+    return (uint8_t)(v < 1 ? 1 : (v > 127 ? 127 : v));
+}
@@ -1,30 +1,69 @@
 #pragma once
 #include "generator.hpp"
-#include <vector>
+#include "engine/euclid.hpp"
+#include "core/xorshift.hpp"
 
 /**
  * Euclidean rhythm generator.
  * Distributes a given number of hits evenly across a specified number of steps
- * using the Euclidean algorithm (similar to Bresenham's line algorithm).
+ * (euclid::pattern, one 64-bit mask), rotated by a bit-rotate. An accent layer
+ * ANDed with it raises velocity; up to three more voices play a second
+ * Euclidean layer on higher pitches, as its own polyrhythm, XORed with the
+ * main rhythm or filling its gaps. Notes are written straight into the
+ * selected track in step order.
+ * Pitch/velocity variation comes from a private xorshift generator, so the
+ * sequence of generated patterns repeats from boot or resetToDefaults();
+ * a non-zero `seed` gives the same variation every time instead.
  */
 class EuclideanGenerator : public Generator
 {
 public:
+    // Schema order: ENC1-3 and ENC5-8 of the generative view follow it
+    enum Param : uint8_t
+    {
+        Density, Length, Rotate, BaseNote, Accent, Voices, LayerHits,
+        Velocity, VelRange, PitchRange, Duration, AccentRotate, AccentVel, LayerRotate, LayerOp, Interval, Seed,
+        PARAM_COUNT
+    };
+    static constexpr uint8_t MAX_VOICES = 4;
+
+    static constexpr gen::ParamDesc PARAMS[PARAM_COUNT] = {
+        gen::param("density", "DENS", "Number of hits (steps with notes)", DEFAULT_DENSITY, 1, 64),
+        gen::param("length", "LEN", "Pattern length in steps", DEFAULT_LENGTH, 1, 64),
+        gen::param("rotate", "ROT", "Rotate the rhythm later by steps", 0, 0, 63),
+        gen::param("base_note", "NOTE", "Base MIDI note number", DEFAULT_BASE_NOTE, 0, 127),
+        gen::param("accent", "ACC", "Accent layer hits, ANDed with the rhythm (0 = off)", 0, 0, 64),
+        gen::param("voices", "VOIC", "Voices: 1 + layers of layer_hits on higher notes", 1, 1, MAX_VOICES),
+        gen::param("layer_hits", "LHIT", "Hits of the extra voices' layer", 3, 1, 64),
+        gen::param("velocity", "VEL", "Base velocity for generated notes", DEFAULT_VELOCITY, 1, 127),
+        gen::param("vel_range", "VRAN", "Velocity randomization range (+/-)", DEFAULT_VEL_RANGE, 0, 64),
+        gen::param("pitch_range", "PRAN", "Pitch randomization range (semitones)", DEFAULT_PITCH_RANGE, 0, 24),
+        gen::param("duration", "DUR", "Note duration as fraction of step (0.1-1.0)", 0.5f, 0.1f, 1.0f, 0.1f),
+        gen::param("accent_rot", "AROT", "Accent layer rotation", 0, 0, 63),
+        gen::param("accent_vel", "AVEL", "Velocity added on accents", 24, 0, 127),
+        gen::param("layer_rot", "LROT", "Layer rotation, times the voice number", 1, 0, 63),
+        gen::param("layer_op", "LOP", "Layer vs rhythm: 0 own, 1 XOR, 2 fill gaps", 0, 0, 2),
+        gen::param("interval", "INT", "Semitones between voices", 7, 0, 24),
+        gen::param("seed", "SEED", "Variation seed: 0 = new variation each time, else repeatable", 0, 0, 255),
+    };
+    static_assert(gen::uniqueHashes(PARAMS), "parameter names must hash apart");
+    static_assert(gen::at(PARAMS, Density, "density") && gen::at(PARAMS, Seed, "seed"),
+                  "PARAMS out of enum order");
+
     EuclideanGenerator();
     
     // Generator interface
     const char* getName() const override { return "Euclidean Rhythm"; }
     const char* getShortName() const override { return "EUC"; }
     void generate(Pattern& pattern) override;
-    const std::map<const char*, GeneratorParameter>& getParameters() const override { return parameters_; }
-    bool setParameter(const char* paramName, float value) override;
-    bool getParameter(const char* paramName, float& outValue) const override;
-    std::vector<const char*> getParameterNames() const override;
     void resetToDefaults() override;
+    // Variation from the running generator (seed 0) differs every time
+    bool cacheable() const override;
+
+    // Evolve: re-rolled velocities stay within this generator's dynamics
+    uint8_t reroll(const Note& n, uint8_t range, XorShift32& rng) const override;
 
 private:
-    std::map<const char*, GeneratorParameter> parameters_;
-    
-    void initializeParameters();
-    std::vector<bool> generateEuclideanRhythm(uint8_t hits, uint8_t steps) const;
-};
\ No newline at end of file
+    gen::fx values_[PARAM_COUNT];
+    XorShift32 rng_{1};
+};
@@ -0,0 +1,365 @@
+#pragma once
+#include <stdint.h>
+#include <utility>
+
+#include "core/xorshift.hpp"
+#include "model/pattern.hpp"
+
+/**
+ * Evolve mode: instead of regenerating a track, mutate it a little every
+ * N bars. Between boundaries the Evolver plans a handful of edits against
+ * the live track in idle slices of at most budget() notes (scan which steps
+ * are taken, then pick notes to move into empty steps, drift in pitch or
+ * re-roll in velocity); RunLoop times each slice and the budget shrinks when
+ * a slice runs over the cap. At the boundary the finished plan is written
+ * into the track in one go and only that track recompiles, inside the tick
+ * loop; tracks longer than MAX_NOTES are refused so that recompile (copy
+ * and, after a move, one sort) stays bounded. A plan made against notes
+ * that changed since (recording, undo, a swap) is dropped.
+ */
+namespace evolve {
+
+// How much one plan changes
+struct Amounts
+{
+    uint8_t swaps{2};     // hits moved to an empty step
+    uint8_t drifts{2};    // notes moved in pitch...
+    uint8_t drift{2};     // ...by up to this many semitones
+    uint8_t rerolls{4};   // velocities drawn again...
+    uint8_t velRange{16}; // ...within this of the old one
+};
+
+/**
+ * New values for a note being evolved. The active generator overrides these
+ * to keep edits in its own language (scale, learned transitions, dynamics);
+ * the defaults move freely within the given range.
+ */
+class Mutator
+{
+public:
+    virtual ~Mutator() = default;
+
+    virtual uint8_t drift(const Note &n, uint8_t semitones, XorShift32 &rng) const
+    {
+        const int32_t p = (int32_t)n.pitch + rng.spread(semitones);
+        return (uint8_t)(p < 0 ? 0 : (p > 127 ? 127 : p));
+    }
+    virtual uint8_t reroll(const Note &n, uint8_t range, XorShift32 &rng) const
+    {
+        const int32_t v = (int32_t)n.vel + rng.spread(range);
+        return (uint8_t)(v < 1 ? 1 : (v > 127 ? 127 : v));
+    }
+};
+
+} // namespace evolve
+
+class Evolver
+{
+public:
+    static constexpr uint8_t MAX_EDITS = 48;
+    static constexpr uint16_t MAX_STEPS = 512; // moves land within the first 512 steps of a track
+    static constexpr uint16_t MAX_NOTES = 1024; // longer tracks are not evolved (boundary recompile cost)
+    static constexpr uint16_t MIN_BUDGET = 8, MAX_BUDGET = 512;
+    static constexpr uint32_t BAR = 4 * 96; // transport ticks
+
+    struct Stats
+    {
+        uint32_t plans;   // plans finished
+        uint32_t applied; // plans written at a boundary
+        uint32_t edits;   // notes changed
+        uint32_t stale;   // plans dropped: the track changed underneath
+        uint32_t missed;  // boundaries reached before the plan was ready
+        uint32_t refused; // tracks over MAX_NOTES (counted once per change of the track)
+        uint32_t slices;
+        uint32_t lastUs, maxUs;           // planning slice cost
+        uint32_t lastApplyUs, maxApplyUs; // writing the plan + recompiling the track
+    };
+
+    // Evolve `track` every `bars` bars (0 = at each loop wrap)
+    void arm(uint8_t track, uint16_t bars, uint32_t seed)
+    {
+        track_ = track;
+        every_ = bars;
+        bars_ = 0;
+        rng_.seed(seed);
+        armed_ = true;
+        restart();
+    }
+    void disarm()
+    {
+        armed_ = false;
+        restart();
+    }
+    bool armed() const { return armed_; }
+    uint8_t track() const { return track_; }
+    uint16_t every() const { return every_; }
+    bool ready() const { return phase_ == Ready; }
+
+    // Each count is capped at MAX_EDITS / 3
+    void setAmounts(const evolve::Amounts &a)
+    {
+        amounts_ = a;
+        amounts_.swaps = a.swaps > MAX_EDITS / 3 ? MAX_EDITS / 3 : a.swaps;
+        amounts_.drifts = a.drifts > MAX_EDITS / 3 ? MAX_EDITS / 3 : a.drifts;
+        amounts_.rerolls = a.rerolls > MAX_EDITS / 3 ? MAX_EDITS / 3 : a.rerolls;
+        restart();
+    }
+    const evolve::Amounts &amounts() const { return amounts_; }
+
+    // Who picks new pitches/velocities; nullptr = evolve::Mutator defaults
+    void setMutator(const evolve::Mutator *m)
+    {
+        mut_ = m;
+        restart();
+    }
+
+    // Slice cap in microseconds; the note budget per slice adapts to it
+    void setCapUs(uint16_t us) { capUs_ = us ? us : 1; }
+    uint16_t capUs() const { return capUs_; }
+    uint16_t budget() const { return budget_; }
+    const Stats &stats() const { return stats_; }
+
+    // Service pass: one planning slice. Returns true if it did any work (time it, noteSliceUs)
+    bool idle(const Pattern &p)
+    {
+        if (!armed_ || phase_ == Ready || track_ >= p.trackCount)
+            return false;
+        const Track &trk = p.tracks[track_];
+        if (phase_ == Start || trk.notes.rev() != rev_)
+        {
+            if (phase_ != Start && phase_ != TooBig)
+                stats_.stale++;
+            begin(p, trk);
+        }
+        if (phase_ == TooBig)
+            return false;
+
+        uint16_t budget = budget_;
+        if (phase_ == Scan)
+        {
+            for (; at_ < n_ && budget; ++at_, --budget)
+            {
+                const uint32_t s = trk.notes.onAt(at_) / tps_;
+                if (s < steps_)
+                    occ_[s >> 5] |= 1u << (s & 31);
+            }
+            if (at_ < n_)
+                return true;
+            phase_ = Pick;
+            at_ = 0;
+        }
+
+        const uint16_t total = (uint16_t)(amounts_.swaps + amounts_.drifts + amounts_.rerolls);
+        for (; at_ < total && budget && n_; ++at_, --budget)
+            pick(trk, at_);
+        if (at_ >= total || !n_)
+        {
+            phase_ = Ready;
+            stats_.plans++;
+        }
+        return true;
+    }
+
+    void noteSliceUs(uint32_t us)
+    {
+        stats_.slices++;
+        stats_.lastUs = us;
+        if (us > stats_.maxUs)
+            stats_.maxUs = us;
+        if (us > capUs_)
+            budget_ = budget_ / 2 > MIN_BUDGET ? budget_ / 2 : MIN_BUDGET;
+        else if (us < capUs_ / 4 && budget_ < MAX_BUDGET)
+            budget_ = (uint16_t)(budget_ + MIN_BUDGET);
+    }
+
+    // Tick window (prev, curr]: true when it ends on the evolve boundary with a plan ready
+    bool boundary(uint32_t prev, uint32_t curr)
+    {
+        if (!armed_)
+            return false;
+        const bool wrap = curr < prev;
+        if (every_)
+        {
+            if (!wrap && curr % BAR != 0)
+                return false;
+            if (++bars_ < every_)
+                return false;
+            bars_ = 0;
+        }
+        else if (!wrap)
+            return false;
+        if (phase_ != Ready)
+            stats_.missed++;
+        return phase_ == Ready;
+    }
+
+    // Write the plan into the live track; returns the notes changed. The caller recompiles.
+    uint16_t apply(Pattern &p)
+    {
+        if (phase_ != Ready || track_ >= p.trackCount)
+            return 0;
+        NoteStore &ns = p.tracks[track_].notes;
+        if (ns.rev() != rev_)
+        {
+            stats_.stale++;
+            restart();
+            return 0;
+        }
+        uint16_t changed = 0;
+        uint8_t moves = 0;
+        for (uint8_t e = 0; e < edits_; ++e)
+        {
+            const Edit &ed = edit_[e];
+            if (ed.index >= ns.size())
+                continue;
+            if (ed.op == Move)
+            {
+                edit_[moves++] = ed; // kept for move(); e >= moves, nothing unread is overwritten
+                continue;
+            }
+            Note n = ns.get(ed.index);
+            if (ed.op == Pitch)
+                n.pitch = ed.value;
+            else
+                n.vel = ed.value;
+            changed += ns.set(ed.index, n);
+        }
+        changed += move(ns, moves);
+        stats_.applied++;
+        stats_.edits += changed;
+        restart();
+        return changed;
+    }
+
+    void noteApplyUs(uint32_t us)
+    {
+        stats_.lastApplyUs = us;
+        if (us > stats_.maxApplyUs)
+            stats_.maxApplyUs = us;
+    }
+
+private:
+    enum Phase : uint8_t { Start, Scan, Pick, Ready, TooBig };
+    enum Op : uint8_t { Move, Pitch, Vel };
+    struct Edit
+    {
+        uint16_t index;
+        Op op;
+        uint8_t value; // Pitch, Vel
+        uint32_t on;   // Move
+    };
+
+    evolve::Amounts amounts_{};
+    const evolve::Mutator *mut_{nullptr};
+    evolve::Mutator defaults_;
+    XorShift32 rng_;
+
+    Edit edit_[MAX_EDITS];
+    uint8_t edits_{0};
+    uint32_t occ_[MAX_STEPS / 32]; // steps holding a note
+    uint32_t rev_{0}, tps_{24}, steps_{0};
+    uint16_t n_{0}, at_{0};
+    uint16_t every_{0}, bars_{0};
+    uint16_t budget_{64}, capUs_{50};
+    uint8_t track_{0};
+    Phase phase_{Start};
+    bool armed_{false};
+    Stats stats_{};
+
+    void restart() { phase_ = Start; }
+
+    void begin(const Pattern &p, const Track &trk)
+    {
+        rev_ = trk.notes.rev();
+        if (trk.notes.size() > MAX_NOTES)
+        {
+            stats_.refused++;
+            phase_ = TooBig;
+            return;
+        }
+        n_ = (uint16_t)trk.notes.size();
+        tps_ = timebase::ticksPerStep(p.grid);
+        const uint32_t steps = p.trackSteps(track_);
+        steps_ = steps < MAX_STEPS ? steps : MAX_STEPS;
+        for (uint32_t &w : occ_)
+            w = 0;
+        at_ = 0;
+        edits_ = 0;
+        phase_ = Scan;
+    }
+
+    // Take the moved notes (edit_[0..k)) out and merge them back in start order: a
+    // sorted track stays sorted, so its recompile copies it instead of sorting. O(n).
+    uint16_t move(NoteStore &ns, uint8_t k)
+    {
+        if (!k)
+            return 0;
+        // By index; a note picked twice keeps its last move
+        for (uint8_t i = 1; i < k; ++i)
+            for (uint8_t j = i; j && edit_[j - 1].index > edit_[j].index; --j)
+                std::swap(edit_[j - 1], edit_[j]);
+        uint8_t m = 0;
+        for (uint8_t i = 0; i < k; ++i)
+            if (i + 1 == k || edit_[i].index != edit_[i + 1].index)
+                edit_[m++] = edit_[i];
+        Note moved[MAX_EDITS];
+        size_t w = edit_[0].index;
+        uint8_t e = 0;
+        for (size_t i = w; i < ns.size(); ++i)
+        {
+            if (e < m && edit_[e].index == i)
+            {
+                moved[e] = ns.get(i);
+                moved[e].on = edit_[e].on;
+                e++;
+                continue;
+            }
+            ns.set(w++, ns.get(i));
+        }
+        while (ns.size() > w)
+            ns.erase(ns.size() - 1);
+        for (uint8_t i = 1; i < m; ++i)
+            for (uint8_t j = i; j && moved[j - 1].on > moved[j].on; --j)
+                std::swap(moved[j - 1], moved[j]);
+        return (uint16_t)ns.merge(moved, m);
+    }
+
+    void pick(const Track &trk, uint16_t k)
+    {
+        const uint16_t i = (uint16_t)rng_.below(n_);
+        const Note n = trk.notes.get(i);
+        const evolve::Mutator &m = mut_ ? *mut_ : defaults_;
+        Edit &e = edit_[edits_];
+        e.index = i;
+        if (k < amounts_.swaps)
+        {
+            const uint32_t from = n.on / tps_;
+            if (from >= steps_)
+                return;
+            // A few tries at an empty step; a full track keeps its rhythm
+            for (uint8_t tries = 0; tries < 8; ++tries)
+            {
+                const uint32_t s = rng_.below(steps_);
+                if (occ_[s >> 5] & (1u << (s & 31)))
+                    continue;
+                occ_[s >> 5] |= 1u << (s & 31);
+                e.op = Move;
+                e.on = s * tps_ + n.on % tps_;
+                edits_++;
+                return;
+            }
+            return;
+        }
+        if (k < amounts_.swaps + amounts_.drifts)
+        {
+            e.op = Pitch;
+            e.value = m.drift(n, amounts_.drift, rng_);
+        }
+        else
+        {
+            e.op = Vel;
+            e.value = m.reroll(n, amounts_.velRange, rng_);
+        }
+        edits_++;
+    }
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#include "model/note_store.hpp"
+
+/**
+ * Small LRU cache of generated note sets. A generator's output is a pure
+ * function of its id, its parameter values (hashed), its seed and the
+ * pattern grid/steps, so a setting seen a moment ago (an encoder scrubbed
+ * back) is copied out instead of generated again. Notes are kept as 8-byte
+ * PackedNote in one arena; entries are contiguous runs, and evicting one
+ * closes the gap (memmove), so there is no fragmentation. The budget in
+ * bytes caps the arena in use and can be lowered at any time.
+ */
+class GenCache
+{
+public:
+    static constexpr uint16_t CAP = 4096; // notes in the arena (32 KB)
+    static constexpr uint8_t MAX_ENTRIES = 16;
+
+    struct Key
+    {
+        uint32_t params; // ParamSet::hash()
+        uint32_t seed;
+        uint32_t steps;
+        uint8_t gen;
+        uint8_t grid;
+
+        bool operator==(const Key &o) const
+        {
+            return params == o.params && seed == o.seed && steps == o.steps && gen == o.gen && grid == o.grid;
+        }
+    };
+
+    struct Stats
+    {
+        uint32_t hits, misses, stores;
+        uint32_t evicted; // entries pushed out to make room
+        uint32_t tooBig;  // results larger than the whole budget, not kept
+    };
+
+    // Arena bytes in use at most (rounded down to whole notes); evicts to fit
+    void setBudget(uint32_t bytes)
+    {
+        const uint32_t n = bytes / sizeof(PackedNote);
+        budget_ = (uint16_t)(n < CAP ? n : CAP);
+        while (used_ > budget_)
+            evict();
+    }
+    uint32_t budgetBytes() const { return (uint32_t)budget_ * sizeof(PackedNote); }
+    uint32_t usedBytes() const { return (uint32_t)used_ * sizeof(PackedNote); }
+    uint8_t entries() const { return n_; }
+    const Stats &stats() const { return stats_; }
+    void resetStats() { stats_ = Stats{}; }
+
+    void clear()
+    {
+        n_ = 0;
+        used_ = 0;
+    }
+
+    // Copy the cached notes for `k` into `out` (cleared first); false on a miss
+    bool fetch(const Key &k, NoteStore &out)
+    {
+        const uint8_t e = find(k);
+        if (e == NONE)
+        {
+            stats_.misses++;
+            return false;
+        }
+        stats_.hits++;
+        Entry &en = entry_[e];
+        en.used = ++clock_;
+        out.clear();
+        out.reserve(en.count);
+        for (uint16_t i = 0; i < en.count; ++i)
+            if (!out.push_back(arena_[en.first + i].unpack()))
+                break;
+        return true;
+    }
+
+    // Keep a copy of `notes` under `k`, evicting least recently used entries to fit
+    bool store(const Key &k, const NoteStore &notes)
+    {
+        if (notes.size() > budget_)
+        {
+            stats_.tooBig++;
+            return false;
+        }
+        const uint16_t count = (uint16_t)notes.size();
+        const uint8_t old = find(k);
+        if (old != NONE)
+            remove(old);
+        while (n_ && (used_ + count > budget_ || n_ == MAX_ENTRIES))
+            evict();
+        Entry &en = entry_[n_++];
+        en.key = k;
+        en.first = used_;
+        en.count = count;
+        en.used = ++clock_;
+        for (uint16_t i = 0; i < count; ++i)
+            arena_[used_ + i] = notes.packed(i);
+        used_ = (uint16_t)(used_ + count);
+        stats_.stores++;
+        return true;
+    }
+
+private:
+    static constexpr uint8_t NONE = 0xFF;
+
+    struct Entry
+    {
+        Key key;
+        uint16_t first, count; // run in the arena
+        uint32_t used;         // LRU clock at the last hit or store
+    };
+
+    PackedNote arena_[CAP];
+    Entry entry_[MAX_ENTRIES];
+    uint8_t n_{0};
+    uint16_t used_{0};
+    uint16_t budget_{CAP / 4}; // 8 KB until configured
+    uint32_t clock_{0};
+    Stats stats_{};
+
+    uint8_t find(const Key &k) const
+    {
+        for (uint8_t e = 0; e < n_; ++e)
+            if (entry_[e].key == k)
+                return e;
+        return NONE;
+    }
+
+    void evict()
+    {
+        uint8_t lru = 0;
+        for (uint8_t e = 1; e < n_; ++e)
+            if (entry_[e].used < entry_[lru].used)
+                lru = e;
+        remove(lru);
+        stats_.evicted++;
+    }
+
+    // Drop entry e and close its gap in the arena and the entry table
+    void remove(uint8_t e)
+    {
+        const uint16_t first = entry_[e].first, count = entry_[e].count;
+        memmove(&arena_[first], &arena_[first + count], (used_ - first - count) * sizeof(PackedNote));
+        used_ = (uint16_t)(used_ - count);
+        for (uint8_t i = 0; i < n_; ++i)
+            if (entry_[i].first > first)
+                entry_[i].first = (uint16_t)(entry_[i].first - count);
+        memmove(&entry_[e], &entry_[e + 1], (n_ - e - 1) * sizeof(Entry));
+        n_--;
+    }
+};
@@ -1,18 +1,42 @@
 #include "generator.hpp"
 
+bool Generator::setParameter(const char* key, float value)
+{
+    const uint8_t i = params_.find(key);
+    if (i == gen::ParamSet::NONE)
+        return false;
+    params_.set(i, value);
+    return true;
+}
+
+bool Generator::getParameter(const char* key, float& outValue) const
+{
+    const uint8_t i = params_.find(key);
+    if (i == gen::ParamSet::NONE)
+        return false;
+    outValue = params_.get(i);
+    return true;
+}
+
+uint32_t Generator::seed() const
+{
+    const uint8_t i = params_.find("seed");
+    return i == gen::ParamSet::NONE ? 0 : (uint32_t)params_.getInt(i);
+}
+
 void Generator::printParameters() const
 {
     Serial.printf("=== %s Generator Parameters ===\n", getName());
     
-    const auto& params = getParameters();
-    for (const auto& pair : params) {
-        const auto& param = pair.second;
-        Serial.printf("%s: %.2f (%.2f-%.2f) - %s\n", 
-                     param.name, 
-                     param.value, 
-                     param.minValue, 
-                     param.maxValue,
-                     param.description);
+    for (uint8_t i = 0; i < params_.count(); ++i) {
+        const gen::ParamDesc& d = params_.desc(i);
+        Serial.printf("%s (%s): %.2f (%.2f-%.2f) - %s\n", 
+                     d.key,
+                     d.name, 
+                     params_.get(i), 
+                     gen::toFloat(d.min), 
+                     gen::toFloat(d.max),
+                     d.description);
     }
     Serial.println("=====================================");
-}
\ No newline at end of file
+}
@@ -1,51 +1,16 @@
 #pragma once
 #include <Arduino.h>
-#include <map>
-#include <string>
-
+#include "engine/generator_params.hpp"
+#include "engine/evolve.hpp"
 #include "model/pattern.hpp"
 
-/**
- * Parameter value that can be controlled via encoders or serial commands.
- * Each parameter has a name, current value, min/max range, and description.
- */
-struct GeneratorParameter
-{
-    const char* name;        // Short name for display (e.g., "DENS", "VAR")
-    const char* description; // Full description for help
-    float value;        // Current value
-    float minValue;     // Minimum allowed value
-    float maxValue;     // Maximum allowed value
-    float step;         // Increment/decrement step size
-    
-    GeneratorParameter() = default;
-    GeneratorParameter(const char* n, const char* desc, float val, float minVal, float maxVal, float stepSize = 1.0f)
-        : name(n), description(desc), value(val), minValue(minVal), maxValue(maxVal), step(stepSize) {}
-    
-    // Clamp value to valid range
-    void clamp() {
-        if (value < minValue) value = minValue;
-        if (value > maxValue) value = maxValue;
-    }
-    
-    // Set value with automatic clamping
-    void setValue(float newValue) {
-        value = newValue;
-        clamp();
-    }
-    
-    // Adjust by step amount
-    void adjust(float steps) {
-        setValue(value + (steps * step));
-    }
-};
-
 /**
  * Abstract base class for all pattern generators.
  * Each generator implements a specific algorithm (Euclidean, Cellular, etc.)
- * and exposes configurable parameters.
+ * and exposes configurable parameters. As an evolve::Mutator it also picks
+ * the pitch drifts and velocity re-rolls of evolve mode (see Evolver).
  */
-class Generator
+class Generator : public evolve::Mutator
 {
 public:
     virtual ~Generator() = default;
@@ -67,36 +32,39 @@ public:
     virtual void generate(Pattern& pattern) = 0;
     
     /**
-     * Get all configurable parameters for this generator.
-     * @return Map of parameter ID to parameter object
+     * Parameters: fixed-point values over the generator's constexpr schema,
+     * read and adjusted by index (the generator's own Param enum).
+     */
+    gen::ParamSet& params() { return params_; }
+    const gen::ParamSet& params() const { return params_; }
+    
+    /**
+     * Set a parameter value by its serial name (hashed lookup).
+     * @return true if parameter exists and was set (clamped to its range)
      */
-    virtual const std::map<const char*, GeneratorParameter>& getParameters() const = 0;
+    bool setParameter(const char* key, float value);
     
     /**
-     * Set a parameter value by name.
-     * @param paramName Name of parameter to set
-     * @param value New value (will be clamped to valid range)
-     * @return true if parameter exists and was set, false otherwise
+     * Get a parameter value by its serial name.
+     * @return true if parameter exists
      */
-    virtual bool setParameter(const char* paramName, float value) = 0;
+    bool getParameter(const char* key, float& outValue) const;
     
     /**
-     * Get a parameter value by name.
-     * @param paramName Name of parameter to get
-     * @param outValue Reference to store the value
-     * @return true if parameter exists, false otherwise
+     * Seed of the next result: the "seed" parameter if there is one, else 0.
      */
-    virtual bool getParameter(const char* paramName, float& outValue) const = 0;
+    virtual uint32_t seed() const;
     
     /**
-     * Get list of all parameter names for iteration.
+     * True if the next result depends only on the parameters, the seed and
+     * the pattern grid/steps, so GeneratorManager may serve it from its cache.
      */
-    virtual std::vector<const char*> getParameterNames() const = 0;
+    virtual bool cacheable() const { return true; }
     
     /**
      * Reset all parameters to their default values.
      */
-    virtual void resetToDefaults() = 0;
+    virtual void resetToDefaults() { params_.reset(); }
     
     /**
      * Print current parameter values to Serial for debugging.
@@ -104,6 +72,8 @@ public:
     virtual void printParameters() const;
 
 protected:
+    gen::ParamSet params_;
+    
     // Common parameters that most generators will use
     static constexpr float DEFAULT_DENSITY = 64.0f;      // 0-127
     static constexpr float DEFAULT_VARIATION = 32.0f;    // 0-127  
@@ -1,30 +1,26 @@
 #include "generator_manager.hpp"
 #include "euclidean_generator.hpp"
+#include "cellular_generator.hpp"
+#include "markov_generator.hpp"
 
-GeneratorManager::GeneratorManager()
+namespace
 {
+// Every available generator, in selection order
+EuclideanGenerator euclidean;
+CellularGenerator cellular;
+MarkovGenerator markovChain;
+Generator *const REGISTRY[] = {&euclidean, &cellular, &markovChain};
 }
 
-void GeneratorManager::begin()
+GeneratorManager::GeneratorManager()
+    : generators_(REGISTRY), count_(sizeof(REGISTRY) / sizeof(REGISTRY[0]))
 {
-    // Register available generators
-    registerGenerator(std::make_unique<EuclideanGenerator>());
-    
-    // TODO: Add more generators here as they're implemented
-    // registerGenerator(std::make_unique<CellularGenerator>());
-    // registerGenerator(std::make_unique<MarkovGenerator>());
-    // registerGenerator(std::make_unique<ProbabilityGenerator>());
-    
-    Serial.printf("GeneratorManager: Registered %d generators\n", generators_.size());
-    printAvailableGenerators();
 }
 
-void GeneratorManager::registerGenerator(std::unique_ptr<Generator> generator)
+void GeneratorManager::begin()
 {
-    if (generator) {
-        Serial.printf("Registered generator: %s\n", generator->getName());
-        generators_.push_back(std::move(generator));
-    }
+    Serial.printf("GeneratorManager: Registered %d generators\n", count_);
+    printAvailableGenerators();
 }
 
 bool GeneratorManager::switchToGenerator(size_t index)
@@ -41,24 +37,24 @@ bool GeneratorManager::switchToGenerator(size_t index)
 
 void GeneratorManager::switchToNextGenerator()
 {
-    if (generators_.empty()) return;
+    if (!count_) return;
     
-    size_t nextIndex = (currentIndex_ + 1) % generators_.size();
+    size_t nextIndex = (currentIndex_ + 1) % count_;
     switchToGenerator(nextIndex);
 }
 
 void GeneratorManager::switchToPreviousGenerator()
 {
-    if (generators_.empty()) return;
+    if (!count_) return;
     
-    size_t prevIndex = (currentIndex_ + generators_.size() - 1) % generators_.size();
+    size_t prevIndex = (currentIndex_ + count_ - 1) % count_;
     switchToGenerator(prevIndex);
 }
 
 Generator* GeneratorManager::getCurrentGenerator() const
 {
     if (isValidIndex(currentIndex_)) {
-        return generators_[currentIndex_].get();
+        return generators_[currentIndex_];
     }
     return nullptr;
 }
@@ -67,8 +63,20 @@ void GeneratorManager::generatePattern(Pattern& pattern)
 {
     Generator* gen = getCurrentGenerator();
     if (gen) {
+        const uint32_t t0 = micros();
+        const bool memo = cacheOn_ && gen->cacheable();
+        const GenCache::Key key{gen->params().hash(), gen->seed(), pattern.steps, (uint8_t)currentIndex_,
+                                pattern.grid};
+        if (memo && cache_.fetch(key, pattern.selected().notes)) {
+            Serial.printf("%s: %u notes from cache in %lu us\n", gen->getName(),
+                          (unsigned)pattern.selected().notes.size(), (unsigned long)(micros() - t0));
+            return;
+        }
         Serial.printf("Generating pattern with %s...\n", gen->getName());
         gen->generate(pattern);
+        if (memo)
+            cache_.store(key, pattern.selected().notes);
+        Serial.printf("Generated in %lu us\n", (unsigned long)(micros() - t0));
     } else {
         Serial.println("GeneratorManager: No generator available");
     }
@@ -80,6 +88,7 @@ bool GeneratorManager::setParameter(const char* paramName, float value)
     if (gen) {
         bool success = gen->setParameter(paramName, value);
         if (success) {
+            gen->getParameter(paramName, value); // as clamped
             Serial.printf("Set %s = %.2f\n", paramName, value);
         } else {
             Serial.printf("Parameter '%s' not found\n", paramName);
@@ -98,15 +107,6 @@ bool GeneratorManager::getParameter(const char* paramName, float& outValue) cons
     return false;
 }
 
-std::vector<const char*> GeneratorManager::getCurrentParameterNames() const
-{
-    Generator* gen = getCurrentGenerator();
-    if (gen) {
-        return gen->getParameterNames();
-    }
-    return {};
-}
-
 void GeneratorManager::printCurrentGenerator() const
 {
     Generator* gen = getCurrentGenerator();
@@ -121,7 +121,7 @@ void GeneratorManager::printCurrentGenerator() const
 void GeneratorManager::printAvailableGenerators() const
 {
     Serial.println("=== Available Generators ===");
-    for (size_t i = 0; i < generators_.size(); i++) {
+    for (size_t i = 0; i < count_; i++) {
         const char* current = (i == currentIndex_) ? " *" : "  ";
         Serial.printf("%s[%d] %s (%s)\n", current, i, 
                      generators_[i]->getName(), 
@@ -141,5 +141,5 @@ void GeneratorManager::resetCurrentGeneratorToDefaults()
 
 bool GeneratorManager::isValidIndex(size_t index) const
 {
-    return index < generators_.size();
+    return index < count_;
 }
\ No newline at end of file
@@ -1,14 +1,15 @@
 #pragma once
 #include <Arduino.h>
-#include <vector>
-#include <memory>
 
 #include "generator.hpp"
+#include "engine/gen_cache.hpp"
 #include "model/pattern.hpp"
 
 /**
  * Manages multiple generators and provides a unified interface for pattern generation.
  * Handles generator selection, parameter management, and coordinates pattern generation.
+ * Generators are static objects listed in one table (generator_manager.cpp),
+ * so nothing is allocated to register them.
  */
 class GeneratorManager
 {
@@ -21,16 +22,10 @@ public:
      */
     void begin();
     
-    /**
-     * Register a generator with the manager.
-     * @param generator Unique pointer to generator (manager takes ownership)
-     */
-    void registerGenerator(std::unique_ptr<Generator> generator);
-    
     /**
      * Get number of registered generators.
      */
-    size_t getGeneratorCount() const { return generators_.size(); }
+    size_t getGeneratorCount() const { return count_; }
     
     /**
      * Switch to a specific generator by index.
@@ -60,11 +55,20 @@ public:
     Generator* getCurrentGenerator() const;
     
     /**
-     * Generate pattern using current generator.
+     * Generate pattern using current generator. Settings seen recently
+     * (same generator, parameters, seed and pattern grid/steps) are copied
+     * from the result cache instead.
      * @param pattern Pattern to populate with generated notes
      */
     void generatePattern(Pattern& pattern);
     
+    /**
+     * Memoized results (LRU); budget and stats over serial.
+     */
+    GenCache& cache() { return cache_; }
+    void setCacheEnabled(bool on) { cacheOn_ = on; }
+    bool cacheEnabled() const { return cacheOn_; }
+    
     /**
      * Set a parameter for the current generator.
      * @param paramName Name of parameter to set
@@ -81,11 +85,6 @@ public:
      */
     bool getParameter(const char* paramName, float& outValue) const;
     
-    /**
-     * Get list of parameter names for the current generator.
-     */
-    std::vector<const char*> getCurrentParameterNames() const;
-    
     /**
      * Print current generator info and parameters.
      */
@@ -102,8 +101,11 @@ public:
     void resetCurrentGeneratorToDefaults();
 
 private:
-    std::vector<std::unique_ptr<Generator>> generators_;
+    Generator *const *generators_{nullptr};
+    size_t count_{0};
     size_t currentIndex_{0};
+    GenCache cache_;
+    bool cacheOn_{true};
     
     bool isValidIndex(size_t index) const;
 };
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Generator parameter schema. Each generator describes its parameters once,
+ * in a constexpr table of ParamDesc indexed by its own enum, and keeps the
+ * values in a ParamSet: a fixed-point (Q16.16) array read by index, so the
+ * encoder and HUD paths never look anything up. Names are only needed on the
+ * serial path; find() compares the FNV-1a hash of the typed name with the
+ * hashes computed at compile time and confirms with one strcmp.
+ */
+namespace gen {
+
+using fx = int32_t; // Q16.16
+constexpr fx ONE = 1 << 16;
+
+constexpr fx toFx(float v) { return (fx)(v * ONE + (v < 0 ? -0.5f : 0.5f)); }
+constexpr float toFloat(fx v) { return (float)v / ONE; }
+
+// FNV-1a, 32-bit
+constexpr uint32_t fnv1a(const char *s)
+{
+    uint32_t h = 2166136261u;
+    while (*s)
+        h = (h ^ (uint8_t)*s++) * 16777619u;
+    return h;
+}
+
+struct ParamDesc
+{
+    const char *key;         // serial name, e.g. "density"
+    const char *name;        // short display name (OLED), e.g. "DENS"
+    const char *description; // help text
+    fx def, min, max, step;
+    uint32_t hash; // fnv1a(key)
+};
+
+constexpr ParamDesc param(const char *key, const char *name, const char *description, float def, float min,
+                          float max, float step = 1.0f)
+{
+    return ParamDesc{key, name, description, toFx(def), toFx(min), toFx(max), toFx(step), fnv1a(key)};
+}
+
+// For static_assert: no two keys of a table share a hash, so find() is exact on the hash
+template <size_t N>
+constexpr bool uniqueHashes(const ParamDesc (&t)[N])
+{
+    for (size_t i = 0; i < N; ++i)
+        for (size_t j = i + 1; j < N; ++j)
+            if (t[i].hash == t[j].hash)
+                return false;
+    return true;
+}
+
+// For static_assert: entry i of a table is the one the enum means
+template <size_t N>
+constexpr bool at(const ParamDesc (&t)[N], size_t i, const char *key)
+{
+    return i < N && t[i].hash == fnv1a(key);
+}
+
+class ParamSet
+{
+public:
+    static constexpr uint8_t NONE = 0xFF;
+
+    // values: storage for n parameters (owned by the generator)
+    void bind(const ParamDesc *schema, uint8_t n, fx *values)
+    {
+        desc_ = schema;
+        n_ = n;
+        v_ = values;
+        reset();
+    }
+
+    uint8_t count() const { return n_; }
+    const ParamDesc &desc(uint8_t i) const { return desc_[i]; }
+
+    fx raw(uint8_t i) const { return v_[i]; }
+    float get(uint8_t i) const { return toFloat(v_[i]); }
+    int32_t getInt(uint8_t i) const { return v_[i] >> 16; }
+
+    void setRaw(uint8_t i, fx v)
+    {
+        if (i >= n_)
+            return;
+        const ParamDesc &d = desc_[i];
+        v_[i] = v < d.min ? d.min : (v > d.max ? d.max : v);
+    }
+    void set(uint8_t i, float v) { setRaw(i, toFx(v)); }
+    // Move by `steps` of the parameter's step size (encoders)
+    void adjust(uint8_t i, int32_t steps)
+    {
+        if (i < n_)
+            setRaw(i, v_[i] + steps * desc_[i].step);
+    }
+
+    void reset()
+    {
+        for (uint8_t i = 0; i < n_; ++i)
+            v_[i] = desc_[i].def;
+    }
+
+    // FNV-1a over the current values (memo key for generated results)
+    uint32_t hash() const
+    {
+        uint32_t h = 2166136261u;
+        for (uint8_t i = 0; i < n_; ++i)
+            for (uint8_t b = 0; b < 4; ++b)
+                h = (h ^ (uint8_t)((uint32_t)v_[i] >> (8 * b))) * 16777619u;
+        return h;
+    }
+
+    // Index of the parameter called `key`, NONE if there is none
+    uint8_t find(const char *key) const
+    {
+        if (!key)
+            return NONE;
+        const uint32_t h = fnv1a(key);
+        for (uint8_t i = 0; i < n_; ++i)
+            if (desc_[i].hash == h && !strcmp(desc_[i].key, key))
+                return i;
+        return NONE;
+    }
+
+private:
+    const ParamDesc *desc_{nullptr};
+    fx *v_{nullptr};
+    uint8_t n_{0};
+};
+
+} // namespace gen
@@ -0,0 +1,95 @@
+#pragma once
+#include <stdint.h>
+
+// Where a live note came from; each source has its own measured latency.
+// Nothing reads MIDI in yet: MidiIn keeps its slot for when an input path does.
+enum class InputSource : uint8_t { Keys = 0, MidiIn = 1 };
+
+/**
+ * Input latency compensation. Every source has an offset (us) that the
+ * recorder subtracts from its edge timestamps. The offset is measured by
+ * tapping along with the beat: each tap's distance to the nearest beat is
+ * collected, the median becomes the offset, and what is left after
+ * subtracting it (jitter) is kept as a histogram of 1 ms bins.
+ */
+class LatencyComp
+{
+public:
+    static constexpr uint8_t SOURCES = 2;
+    static constexpr uint8_t MAX_TAPS = 32;
+    static constexpr uint8_t BINS = 25; // -12..+12 ms, ends collect everything beyond
+    static constexpr int32_t BIN_US = 1000;
+
+    int32_t offsetUs(InputSource s) const { return offset_[idx(s)]; }
+    void setOffsetUs(InputSource s, int32_t us) { offset_[idx(s)] = us; }
+
+    void startCalibration(InputSource s, uint8_t taps)
+    {
+        src_ = s;
+        want_ = taps < 4 ? 4 : (taps > MAX_TAPS ? MAX_TAPS : taps);
+        n_ = 0;
+    }
+    void cancel() { want_ = 0; }
+    bool calibrating() const { return want_ != 0; }
+    bool calibrating(InputSource s) const { return want_ && s == src_; }
+    uint8_t taps() const { return n_; }
+    uint8_t wanted() const { return want_; }
+
+    // A tap `errUs` after the nearest beat (negative: early), measured without
+    // compensation. Returns true when this tap completed the calibration.
+    bool tap(int32_t errUs)
+    {
+        if (!want_)
+            return false;
+        tap_[n_++] = errUs;
+        if (n_ < want_)
+            return false;
+        finish();
+        return true;
+    }
+
+    const uint16_t *histogram() const { return hist_; }
+    uint8_t histogramTaps() const { return histN_; }
+    // Spread of the last calibration: largest |residual|
+    int32_t worstUs() const { return worst_; }
+
+private:
+    int32_t offset_[SOURCES]{};
+    InputSource src_{InputSource::Keys};
+    uint8_t want_{0}, n_{0};
+    int32_t tap_[MAX_TAPS]{};
+    uint16_t hist_[BINS]{};
+    uint8_t histN_{0};
+    int32_t worst_{0};
+
+    static uint8_t idx(InputSource s) { return (uint8_t)s < SOURCES ? (uint8_t)s : 0; }
+
+    void finish()
+    {
+        // Median of the taps (insertion sort, at most MAX_TAPS): one stray tap does not skew it
+        int32_t v[MAX_TAPS];
+        for (uint8_t i = 0; i < n_; ++i)
+        {
+            uint8_t j = i;
+            for (; j && v[j - 1] > tap_[i]; --j)
+                v[j] = v[j - 1];
+            v[j] = tap_[i];
+        }
+        const int32_t med = n_ & 1 ? v[n_ / 2] : (v[n_ / 2 - 1] + v[n_ / 2]) / 2;
+        offset_[idx(src_)] = med;
+        for (uint8_t b = 0; b < BINS; ++b)
+            hist_[b] = 0;
+        worst_ = 0;
+        for (uint8_t i = 0; i < n_; ++i)
+        {
+            const int32_t r = tap_[i] - med;
+            const int32_t a = r < 0 ? -r : r;
+            if (a > worst_)
+                worst_ = a;
+            int32_t b = (r + (r < 0 ? -BIN_US / 2 : BIN_US / 2)) / BIN_US + BINS / 2;
+            hist_[b < 0 ? 0 : (b >= BINS ? BINS - 1 : b)]++;
+        }
+        histN_ = n_;
+        want_ = 0;
+    }
+};
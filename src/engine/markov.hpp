@@ -0,0 +1,389 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+
+#include "core/xorshift.hpp"
+#include "model/note_store.hpp"
+
+/**
+ * Markov chains learned from played notes. Each chain counts, for a small
+ * alphabet of classes (interval, pitch class, onset gap, duration,
+ * velocity), which class followed the previous one and the previous two,
+ * in a fixed open-addressing table: training is O(1) per note and never
+ * allocates. compile() packs the counts into one sorted array of
+ * (context, class, cumulative count) words, so sampling is two binary
+ * searches for the context's run and one over its cumulative counts.
+ * A missing second-order context falls back to first order, then to the
+ * plain class frequencies. The walk draws from a XorShift32: same model,
+ * same seed, same notes.
+ */
+namespace markov {
+
+constexpr uint8_t NONE = 0xFF; // no previous class (start of a phrase)
+
+template <uint8_t A, uint16_t CAP>
+class Chain
+{
+public:
+    static_assert((CAP & (CAP - 1)) == 0, "CAP is a power of two");
+    // key = context * A + class, context = (prev2 + 1) * (A + 1) + (prev1 + 1)
+    static_assert((uint32_t)(A + 1) * (A + 1) * A < 0xFFFF, "keys are 16-bit");
+    // Counts are halved when one reaches LIMIT, so a context's total fits 16 bits
+    static constexpr uint16_t LIMIT = 0xFFFF / A;
+
+    void reset()
+    {
+        for (uint16_t i = 0; i < CAP; ++i)
+            key_[i] = EMPTY;
+        used_ = runs_ = 0;
+        dropped_ = 0;
+        dirty_ = false;
+        restart();
+    }
+    // New phrase: the next class has no history
+    void restart() { p1_ = p2_ = NONE; }
+
+    void observe(uint8_t s)
+    {
+        if (s >= A)
+            return;
+        count(ctx(NONE, NONE), s);
+        if (p1_ != NONE)
+            count(ctx(NONE, p1_), s);
+        if (p2_ != NONE)
+            count(ctx(p2_, p1_), s);
+        p2_ = p1_;
+        p1_ = s;
+        dirty_ = true;
+    }
+
+    // Counts → sorted (key << 16 | cumulative count) runs; O(CAP log CAP)
+    void compile()
+    {
+        runs_ = 0;
+        for (uint16_t i = 0; i < CAP; ++i)
+            if (key_[i] != EMPTY && count_[i])
+                run_[runs_++] = (uint32_t)key_[i] << 16 | count_[i];
+        std::sort(run_, run_ + runs_);
+        uint32_t cum = 0, ctxOf = 0xFFFFFFFF;
+        for (uint16_t i = 0; i < runs_; ++i)
+        {
+            const uint32_t c = (run_[i] >> 16) / A;
+            cum = (c == ctxOf ? cum : 0) + (run_[i] & 0xFFFF);
+            ctxOf = c;
+            run_[i] = (run_[i] & 0xFFFF0000u) | cum;
+        }
+        dirty_ = false;
+    }
+
+    bool ready() const { return runs_ && !dirty_; }
+    uint16_t entries() const { return used_; }
+    uint32_t dropped() const { return dropped_; }
+
+    // Next class after (p2, p1) using up to `order` previous classes; NONE
+    // if nothing was learned. Call compile() after training.
+    uint8_t sample(uint8_t p2, uint8_t p1, uint8_t order, XorShift32 &rng) const
+    {
+        uint16_t lo = 0, hi = 0;
+        if (order >= 2 && p2 != NONE && p1 != NONE)
+            range(ctx(p2, p1), lo, hi);
+        if (lo == hi && order >= 1 && p1 != NONE)
+            range(ctx(NONE, p1), lo, hi);
+        if (lo == hi)
+            range(ctx(NONE, NONE), lo, hi);
+        if (lo == hi)
+            return NONE;
+        const uint32_t r = rng.below(run_[hi - 1] & 0xFFFF);
+        // First cumulative count above r
+        while (lo < hi)
+        {
+            const uint16_t mid = (uint16_t)((lo + hi) / 2);
+            if ((run_[mid] & 0xFFFF) > r)
+                hi = mid;
+            else
+                lo = (uint16_t)(mid + 1);
+        }
+        return (uint8_t)((run_[lo] >> 16) % A);
+    }
+
+private:
+    static constexpr uint16_t EMPTY = 0xFFFF;
+
+    uint16_t key_[CAP];
+    uint16_t count_[CAP];
+    uint32_t run_[CAP];
+    uint16_t used_{0}, runs_{0};
+    uint32_t dropped_{0};
+    uint8_t p1_{NONE}, p2_{NONE};
+    bool dirty_{false};
+
+    static uint16_t ctx(uint8_t p2, uint8_t p1) { return (uint16_t)((uint8_t)(p2 + 1) * (A + 1) + (uint8_t)(p1 + 1)); }
+
+    void count(uint16_t c, uint8_t s)
+    {
+        const uint16_t k = (uint16_t)(c * A + s);
+        uint16_t i = (uint16_t)((k * 40503u) & (CAP - 1));
+        while (key_[i] != k)
+        {
+            if (key_[i] == EMPTY)
+            {
+                if (used_ >= CAP * 3 / 4) // keep probes short; new transitions are dropped
+                {
+                    dropped_++;
+                    return;
+                }
+                key_[i] = k;
+                count_[i] = 0;
+                used_++;
+                break;
+            }
+            i = (uint16_t)((i + 1) & (CAP - 1));
+        }
+        if (++count_[i] >= LIMIT)
+            for (uint16_t j = 0; j < CAP; ++j)
+                if (key_[j] != EMPTY)
+                    count_[j] >>= 1;
+    }
+
+    // [lo, hi) of the compiled runs of context c
+    void range(uint16_t c, uint16_t &lo, uint16_t &hi) const
+    {
+        lo = lower((uint32_t)(c * A) << 16);
+        hi = lower((uint32_t)((c + 1) * A) << 16);
+    }
+    uint16_t lower(uint32_t v) const { return (uint16_t)(std::lower_bound(run_, run_ + runs_, v) - run_); }
+};
+
+// Onset gaps in steps (0 = chord) and durations in half steps, by class
+constexpr uint8_t GAPS = 9; // 0..8 steps
+constexpr uint8_t DURS = 8;
+constexpr uint8_t DUR_HALF_STEPS[DURS] = {1, 2, 3, 4, 6, 8, 12, 16};
+constexpr uint8_t INTERVALS = 25; // -12..+12 semitones
+
+struct WalkParams
+{
+    uint32_t ticks;        // length to fill
+    uint32_t ticksPerStep;
+    uint8_t order;         // 0..2
+    uint8_t base;          // first pitch
+    uint8_t range;         // pitches fold into base ± range (>= 6)
+    bool pitchClass;       // follow the pitch-class chain instead of intervals
+};
+
+class Model
+{
+public:
+    Chain<INTERVALS, 1024> interval;
+    Chain<12, 256> pitch;
+    Chain<GAPS, 256> gap;
+    Chain<DURS, 256> dur;
+    Chain<8, 256> vel;
+
+    void reset()
+    {
+        interval.reset();
+        pitch.reset();
+        gap.reset();
+        dur.reset();
+        vel.reset();
+        notes_ = 0;
+        restart(tps_);
+    }
+
+    // Start a phrase (a track): no history carries over from the last one
+    void restart(uint32_t ticksPerStep)
+    {
+        tps_ = ticksPerStep ? ticksPerStep : 1;
+        interval.restart();
+        pitch.restart();
+        gap.restart();
+        dur.restart();
+        vel.restart();
+        havePrev_ = false;
+    }
+
+    // One note of the phrase, in start order
+    void observe(const Note &n)
+    {
+        if (havePrev_)
+        {
+            const int32_t iv = (int32_t)n.pitch - prevPitch_;
+            interval.observe((uint8_t)((iv < -12 ? -12 : (iv > 12 ? 12 : iv)) + 12));
+            const uint32_t g = (n.on - prevOn_ + tps_ / 2) / tps_;
+            gap.observe((uint8_t)(g < GAPS ? g : GAPS - 1));
+        }
+        pitch.observe(n.pitch % 12);
+        dur.observe(durClass(n.duration));
+        vel.observe((n.vel & 0x7F) >> 4);
+        prevPitch_ = n.pitch;
+        prevOn_ = n.on;
+        havePrev_ = true;
+        notes_++;
+    }
+
+    void compile()
+    {
+        interval.compile();
+        pitch.compile();
+        gap.compile();
+        dur.compile();
+        vel.compile();
+    }
+
+    uint32_t notes() const { return notes_; }
+    bool ready() const { return gap.ready() && dur.ready() && vel.ready() && pitch.ready(); }
+
+    // Fill `out` (appending, start order) with a walk over the chains.
+    // Returns the notes added; 0 if nothing has been learned.
+    size_t walk(NoteStore &out, const WalkParams &w, XorShift32 &rng) const
+    {
+        if (!ready())
+            return 0;
+        int32_t lo = (int32_t)w.base - w.range, hi = (int32_t)w.base + w.range;
+        lo = lo < 0 ? 0 : lo;
+        hi = hi > 127 ? 127 : hi;
+        if (hi - lo < 11) // at least an octave, so folding always lands
+        {
+            if (hi >= 11)
+                lo = hi - 11;
+            else
+                hi = lo + 11;
+        }
+        uint8_t iv[2] = {NONE, NONE}, pc[2] = {NONE, NONE}, gp[2] = {NONE, NONE}, du[2] = {NONE, NONE},
+                ve[2] = {NONE, NONE};
+        int32_t p = w.base;
+        uint32_t t = 0;
+        uint8_t stacked = 0;
+        size_t added = 0;
+        for (bool first = true;; first = false)
+        {
+            if (!first)
+            {
+                uint8_t g = next(gap, gp, w.order, rng);
+                stacked = g ? 0 : (uint8_t)(stacked + 1);
+                if (stacked >= 4) // a chord chain cannot stall the walk
+                    g = 1, stacked = 0;
+                t += g * w.ticksPerStep;
+
+                if (w.pitchClass || !interval.ready())
+                {
+                    const uint8_t c = next(pitch, pc, w.order, rng);
+                    p += ((int32_t)c - p % 12 + 18) % 12 - 6; // nearest pitch of that class
+                }
+                else
+                    p += (int32_t)next(interval, iv, w.order, rng) - 12;
+            }
+            else if (w.pitchClass)
+                shift(pc, (uint8_t)(w.base % 12));
+            if (t >= w.ticks)
+                break;
+            while (p > hi)
+                p -= 12;
+            while (p < lo)
+                p += 12;
+
+            Note n{};
+            n.on = t;
+            n.duration = DUR_HALF_STEPS[next(dur, du, w.order, rng)] * w.ticksPerStep / 2;
+            n.pitch = (uint8_t)p;
+            n.vel = (uint8_t)(next(vel, ve, w.order, rng) * 16 + 8);
+            if (!out.push_back(n))
+                break;
+            added++;
+        }
+        return added;
+    }
+
+private:
+    uint32_t notes_{0}, tps_{24}, prevOn_{0};
+    uint8_t prevPitch_{0};
+    bool havePrev_{false};
+
+    uint8_t durClass(uint32_t ticks) const
+    {
+        const uint32_t half = (2 * ticks + tps_ / 2) / tps_;
+        uint8_t best = 0;
+        for (uint8_t c = 1; c < DURS; ++c)
+            if (absDiff(DUR_HALF_STEPS[c], half) < absDiff(DUR_HALF_STEPS[best], half))
+                best = c;
+        return best;
+    }
+    static uint32_t absDiff(uint32_t a, uint32_t b) { return a > b ? a - b : b - a; }
+
+    static void shift(uint8_t (&h)[2], uint8_t s)
+    {
+        h[0] = h[1];
+        h[1] = s;
+    }
+    template <class C>
+    static uint8_t next(const C &c, uint8_t (&h)[2], uint8_t order, XorShift32 &rng)
+    {
+        uint8_t s = c.sample(h[0], h[1], order, rng);
+        if (s == NONE) // trained chains always have an order-0 run
+            s = 0;
+        shift(h, s);
+        return s;
+    }
+};
+
+/**
+ * Trains a model from a track in slices: begin() orders the notes by start
+ * (index sort, the store is left alone), step(budget) observes up to
+ * `budget` of them, so a long take can be spread over service passes.
+ * train() does it in one go.
+ */
+class Trainer
+{
+public:
+    static constexpr uint16_t MAX_NOTES = 2048; // longer tracks train on their first notes
+
+    void begin(Model &m, const NoteStore &src, uint32_t ticksPerStep)
+    {
+        m_ = &m;
+        src_ = &src;
+        n_ = (uint16_t)(src.size() < MAX_NOTES ? src.size() : MAX_NOTES);
+        for (uint16_t i = 0; i < n_; ++i)
+            order_[i] = i;
+        bool sorted = true;
+        for (uint16_t i = 1; i < n_ && sorted; ++i)
+            sorted = src.onAt(i - 1) <= src.onAt(i);
+        if (!sorted)
+            std::stable_sort(order_, order_ + n_, [&](uint16_t a, uint16_t b) { return src.onAt(a) < src.onAt(b); });
+        at_ = 0;
+        m.restart(ticksPerStep);
+    }
+
+    // true once every note is in and the model is compiled
+    bool step(uint16_t budget)
+    {
+        if (!m_)
+            return true;
+        for (; at_ < n_ && budget; ++at_, --budget)
+        {
+            const Note n = src_->get(order_[at_]);
+            if (!(n.flags & NF_Mute))
+                m_->observe(n);
+        }
+        if (at_ < n_)
+            return false;
+        m_->compile();
+        m_ = nullptr;
+        return true;
+    }
+
+    void train(Model &m, const NoteStore &src, uint32_t ticksPerStep)
+    {
+        begin(m, src, ticksPerStep);
+        step(MAX_NOTES);
+    }
+
+    bool busy() const { return m_ != nullptr; }
+
+private:
+    Model *m_{nullptr};
+    const NoteStore *src_{nullptr};
+    uint16_t n_{0}, at_{0};
+    static inline uint16_t order_[MAX_NOTES];
+};
+
+} // namespace markov
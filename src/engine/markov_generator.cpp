@@ -0,0 +1,71 @@
+#include "markov_generator.hpp"
+#include "model/note.hpp"
+
+MarkovGenerator::MarkovGenerator()
+{
+    params_.bind(PARAMS, PARAM_COUNT, values_);
+    model_.reset();
+}
+
+void MarkovGenerator::resetToDefaults()
+{
+    params_.reset();
+    model_.reset();
+}
+
+void MarkovGenerator::generate(Pattern &pattern)
+{
+    const uint32_t ticksPerStep = (96 * 4) / pattern.grid;
+    const int32_t source = params_.getInt(Source);
+    const int32_t learn = params_.getInt(Learn);
+    const Track &src = source ? pattern.tracks[source - 1] : pattern.selected();
+
+    // Learn before the selected track is cleared: it may be the source
+    if (learn != 2)
+    {
+        const uint32_t t0 = micros();
+        if (learn == 0)
+            model_.reset();
+        trainer_.train(model_, src.notes, ticksPerStep);
+        Serial.printf("MarkovGenerator: learned %u notes (%lu total) in %lu us, %u interval transitions\n",
+                      (unsigned)(src.notes.size() < markov::Trainer::MAX_NOTES ? src.notes.size()
+                                                                                : markov::Trainer::MAX_NOTES),
+                      (unsigned long)model_.notes(), (unsigned long)(micros() - t0), model_.interval.entries());
+    }
+    if (!model_.ready())
+    {
+        Serial.println("MarkovGenerator: nothing learned yet (source track is empty)");
+        return;
+    }
+
+    uint32_t steps = (uint32_t)params_.getInt(Length);
+    if (steps > pattern.steps)
+        steps = pattern.steps;
+
+    markov::WalkParams w{};
+    w.ticks = steps * ticksPerStep;
+    w.ticksPerStep = ticksPerStep;
+    w.order = (uint8_t)params_.getInt(Order);
+    w.base = (uint8_t)params_.getInt(BaseNote);
+    w.range = (uint8_t)params_.getInt(Range);
+    w.pitchClass = params_.getInt(Mode) == 1;
+
+    Track &track = pattern.selected();
+    track.notes.clear();
+    XorShift32 rng((uint32_t)params_.getInt(Seed));
+    const size_t n = model_.walk(track.notes, w, rng);
+
+    Serial.printf("MarkovGenerator: order %u, %lu steps, %u notes\n", w.order, (unsigned long)steps, (unsigned)n);
+}
+
+uint8_t MarkovGenerator::drift(const Note &n, uint8_t semitones, XorShift32 &rng) const
+{
+    const uint8_t c = model_.pitch.ready() ? model_.pitch.sample(markov::NONE, n.pitch % 12, 1, rng) : markov::NONE;
+    if (c == markov::NONE)
+        return Generator::drift(n, semitones, rng);
+    const int32_t d = ((int32_t)c - n.pitch % 12 + 18) % 12 - 6; // nearest pitch of that class
+    if (d > semitones || -d > semitones)
+        return Generator::drift(n, semitones, rng);
+    const int32_t p = (int32_t)n.pitch + d;
+    return (uint8_t)(p < 0 ? p + 12 : (p > 127 ? p - 12 : p));
+}
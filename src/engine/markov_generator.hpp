@@ -0,0 +1,56 @@
+#pragma once
+#include "generator.hpp"
+#include "engine/markov.hpp"
+
+/**
+ * Markov-chain generator.
+ * Learns from a track of the pattern (usually a recorded take): intervals or
+ * pitch classes, onset gaps, durations and velocities each get first- and
+ * second-order transition counts (markov::Model), then a seeded walk over
+ * them fills the selected track. Learning replaces the model each time, or
+ * adds to it so several takes can be combined.
+ */
+class MarkovGenerator : public Generator
+{
+public:
+    // Schema order: ENC1-3 and ENC5-8 of the generative view follow it
+    enum Param : uint8_t
+    {
+        Source, Order, Seed, Length, BaseNote, Range, Mode, Learn,
+        PARAM_COUNT
+    };
+
+    static constexpr gen::ParamDesc PARAMS[PARAM_COUNT] = {
+        gen::param("source", "SRC", "Track to learn from: 0 = selected, else 1-16", 0, 0, 16),
+        gen::param("order", "ORD", "Previous notes considered (0-2)", 2, 0, 2),
+        gen::param("seed", "SEED", "Walk seed (same seed, same notes)", 1, 1, 255),
+        gen::param("length", "LEN", "Pattern length in steps", DEFAULT_LENGTH, 1, 64),
+        gen::param("base_note", "NOTE", "First pitch; the walk folds into its range", DEFAULT_BASE_NOTE, 0, 127),
+        gen::param("range", "RNG", "Pitches within base_note +/- range semitones", DEFAULT_PITCH_RANGE, 6, 36),
+        gen::param("mode", "MODE", "0 intervals (transposes), 1 pitch classes (keeps the key)", 0, 0, 1),
+        gen::param("learn", "LRN", "0 relearn the source, 1 add it to the model, 2 keep the model", 0, 0, 2),
+    };
+    static_assert(gen::uniqueHashes(PARAMS), "parameter names must hash apart");
+    static_assert(gen::at(PARAMS, Source, "source") && gen::at(PARAMS, Learn, "learn"),
+                  "PARAMS out of enum order");
+
+    MarkovGenerator();
+
+    // Generator interface
+    const char* getName() const override { return "Markov Chain"; }
+    const char* getShortName() const override { return "MRKV"; }
+    void generate(Pattern& pattern) override;
+    void resetToDefaults() override;
+    // The result depends on what was learned, not only on the parameters
+    bool cacheable() const override { return false; }
+
+    const markov::Model& model() const { return model_; }
+
+    // Evolve: a drifted note moves to a pitch class that followed its own in what was learned
+    uint8_t drift(const Note& n, uint8_t semitones, XorShift32& rng) const override;
+
+private:
+    gen::fx values_[PARAM_COUNT];
+    markov::Model model_;
+    markov::Trainer trainer_;
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * Fixed-capacity min-heap of pending note-offs keyed on absolute tick
+ * (wrap-safe comparison). Shared by the pattern and stream players so both
+ * release notes on time and skip a note-on rather than leave it hanging
+ * when full.
+ */
+template <uint8_t N>
+class NoteOffQueue
+{
+public:
+    struct Off
+    {
+        uint32_t at;
+        uint8_t ch, pitch;
+    };
+
+    uint8_t size() const { return n_; }
+    bool empty() const { return n_ == 0; }
+    const Off &top() const { return q_[0]; }
+    const Off &operator[](uint8_t i) const { return q_[i]; }
+    void clear() { n_ = 0; }
+    // Note-ons dropped because the queue was full
+    uint32_t overflow() const { return overflow_; }
+
+    bool push(uint32_t at, uint8_t ch, uint8_t pitch)
+    {
+        if (n_ >= N)
+        {
+            overflow_++;
+            return false;
+        }
+        unsigned i = n_++;
+        while (i && before(at, q_[(i - 1) / 2].at))
+        {
+            q_[i] = q_[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        q_[i] = Off{at, ch, pitch};
+        return true;
+    }
+
+    void pop()
+    {
+        Off last = q_[--n_];
+        unsigned i = 0;
+        for (;;)
+        {
+            unsigned l = 2 * i + 1, r = l + 1, m = l;
+            if (l >= n_)
+                break;
+            if (r < n_ && before(q_[r].at, q_[l].at))
+                m = r;
+            if (!before(q_[m].at, last.at))
+                break;
+            q_[i] = q_[m];
+            i = m;
+        }
+        if (n_)
+            q_[i] = last;
+    }
+
+    static bool before(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+
+private:
+    Off q_[N]{};
+    uint8_t n_{0};
+    uint32_t overflow_{0};
+};
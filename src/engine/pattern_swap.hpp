@@ -0,0 +1,169 @@
+#pragma once
+#include <stdint.h>
+
+#include "model/pattern.hpp"
+#include "engine/timeline.hpp"
+
+enum class SwapQuant : uint8_t
+{
+    Now,  // next tick
+    Beat, // next quarter note
+    Bar,  // next 4/4 bar
+    Loop, // next pass through tick 0
+    Cue   // held until the owner flips it (song chain)
+};
+
+inline const char *swapQuantName(SwapQuant q)
+{
+    switch (q)
+    {
+    case SwapQuant::Now: return "now";
+    case SwapQuant::Beat: return "beat";
+    case SwapQuant::Bar: return "bar";
+    case SwapQuant::Loop: return "loop";
+    case SwapQuant::Cue: return "cue";
+    }
+    return "?";
+}
+
+/**
+ * Double buffer for wholesale pattern replacement (generators, loads).
+ * stage() copies the live Pattern into a back buffer that can be rewritten
+ * freely while the live one keeps playing; commit() hands it over. The back
+ * Timeline is compiled in a service pass before the boundary, and RunLoop
+ * flips pattern and timeline together between two tick windows, so the engine
+ * never sees a half-built track. PlaybackEngine keeps its note-off heap across
+ * the flip: notes from the outgoing pattern still end on time.
+ */
+class PatternSwap
+{
+public:
+    struct Stats
+    {
+        uint32_t swaps;
+        uint32_t lastWait, maxWait; // tick windows from commit to flip
+        uint32_t lastUs, maxUs;     // cost of the flip itself
+        uint8_t carried;            // note-offs owed by the outgoing pattern at the last flip
+        uint32_t carriedTotal;
+        uint32_t failed; // stage() copies that ran out of note pool
+    };
+
+    void begin(Pattern *live) { live_ = live; }
+
+    Timeline &front() { return tl_[front_]; }
+    const Timeline &front() const { return tl_[front_]; }
+
+    void setQuant(SwapQuant q) { quant_ = q; }
+    SwapQuant quant() const { return quant_; }
+    bool pending() const { return pending_; }
+    const Stats &stats() const { return stats_; }
+
+    // Copy the live pattern into the back buffer for editing. Returns nullptr
+    // while a previous swap is still pending or if the pool cannot hold a copy.
+    Pattern *stage() { return live_ ? stage(*live_) : nullptr; }
+    // Same, starting from another pattern (e.g. a bank slot)
+    Pattern *stage(const Pattern &src)
+    {
+        if (!live_ || pending_)
+            return nullptr;
+        if (!back_.assign(src))
+        {
+            stats_.failed++;
+            release();
+            return nullptr;
+        }
+        return &back_;
+    }
+
+    void commit() { commit(quant_); }
+    void commit(SwapQuant q)
+    {
+        pendQuant_ = q;
+        pending_ = true;
+        ready_ = false;
+        wait_ = 0;
+    }
+    void cancel()
+    {
+        pending_ = false;
+        release();
+    }
+
+    bool pendingCue() const { return pending_ && pendQuant_ == SwapQuant::Cue; }
+
+    // Compile the staged pattern ahead of the boundary, `budget` tracks per call
+    void prepare(uint8_t budget = Pattern::MAX_TRACKS)
+    {
+        if (!pending_ || ready_)
+            return;
+        Timeline &tl = tl_[front_ ^ 1];
+        tl.build(back_, budget);
+        ready_ = !tl.stale(back_);
+    }
+    bool ready() const { return ready_; }
+
+    // True when the window (prev, curr] ends on the quantization boundary
+    bool boundary(uint32_t prev, uint32_t curr)
+    {
+        if (!pending_)
+            return false;
+        wait_++;
+        if (pendQuant_ == SwapQuant::Cue)
+            return false;
+        if (pendQuant_ == SwapQuant::Now || curr < prev) // loop wrap is a boundary for every mode
+            return true;
+        const uint32_t beat = 96; // TPQN
+        switch (pendQuant_)
+        {
+        case SwapQuant::Beat: return curr % beat == 0;
+        case SwapQuant::Bar: return curr % (beat * 4) == 0;
+        default: return curr == 0;
+        }
+    }
+
+    // Flip pattern and timeline. `carried` is what the engine still has sounding.
+    void apply(uint8_t carried)
+    {
+        if (!pending_)
+            return;
+        prepare();
+        live_->swap(back_);
+        front_ ^= 1;
+        pending_ = false;
+        release(); // the outgoing pattern is not needed any more
+
+        stats_.swaps++;
+        stats_.lastWait = wait_;
+        if (wait_ > stats_.maxWait)
+            stats_.maxWait = wait_;
+        stats_.carried = carried;
+        stats_.carriedTotal += carried;
+    }
+
+    void noteApplyUs(uint32_t us)
+    {
+        stats_.lastUs = us;
+        if (us > stats_.maxUs)
+            stats_.maxUs = us;
+    }
+
+private:
+    Pattern *live_{nullptr};
+    Pattern back_;
+    Timeline tl_[2];
+    uint8_t front_{0};
+
+    SwapQuant quant_{SwapQuant::Bar};
+    SwapQuant pendQuant_{SwapQuant::Bar};
+    bool pending_{false};
+    bool ready_{false};
+    uint32_t wait_{0};
+    Stats stats_{};
+
+    void release()
+    {
+        for (uint8_t t = 0; t < Pattern::MAX_TRACKS; ++t)
+            back_.tracks[t].clear();
+        tl_[front_ ^ 1].clear();
+    }
+};
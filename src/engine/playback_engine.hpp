@@ -1,12 +1,56 @@
 #pragma once
 #include <vector>
 
-#include "model/pattern.hpp"
-#include "core/midi_io.hpp"
+#include "engine/timeline.hpp"
+#include "engine/note_off_queue.hpp"
+#include "core/midi_event.hpp"
 #include "core/timebase.hpp"
+#include "core/xorshift.hpp"
 
-struct PlaybackEngine
+/**
+ * Plays a compiled Timeline.
+ * Every track has a cursor into its sorted events and an absolute loop base;
+ * a min-heap over the cursors' next due ticks merges all tracks into one
+ * time-ordered stream, so a tick costs O(due events · log tracks) no matter
+ * how many notes are stored. Note-offs are scheduled into a second heap when
+ * their note-on fires, which also makes them survive loop wraps, rebuilds and
+ * relocation.
+ *
+ * Each track wraps on its own timeline length, so tracks drift against each
+ * other across pattern loops (polymeter). Stop and locate realign them: a
+ * track's phase becomes the transport tick modulo its length.
+ *
+ * Track mute (Timeline::muted()) and solo (setSolo) are combined into one
+ * audible mask; tracks outside it are kept out of the heap, so they cost
+ * nothing per tick. A mask change re-seats the cursors on the next tick
+ * (O(tracks · log notes)), and notes already sounding still get their note-off.
+ * Notes flagged NF_Mute are skipped when due.
+ *
+ * Trigs: a note's loop condition (trig::passes) is checked against its
+ * track's pass count (transport position / track length, so a locate keeps
+ * the A:B phase; First is the pass played first after start/locate), and its
+ * skip chance against the track's own xorshift generator, drawn only for
+ * notes that have one. Generators are reseeded from seed() at every
+ * start/locate, so playing from the same position with the same seed repeats
+ * the same choices.
+ *
+ * Ratchets (ratchet:: bits in Note::flags) are expanded here: the stored note
+ * plays its first hit and parks a Roll holding the absolute tick of the next
+ * one, so the repeats survive loop wraps and rebuilds like note-offs do and
+ * a track stores one note per ratcheted step. Repeats draw on a byte budget
+ * refilled every tick (RATCHET_BYTES_PER_SEC, below the 3125 B/s of the DIN
+ * port) and charged for everything sent; a repeat that would overrun it is
+ * dropped, never delayed, so dense rolls thin out instead of backing up the
+ * UART.
+ */
+class PlaybackEngine
 {
+public:
+    static constexpr uint8_t MAX_TRACKS = Timeline::MAX_TRACKS;
+    static constexpr uint8_t MAX_OFFS = 128;
+    static constexpr uint8_t MAX_ROLLS = 16;
+    static constexpr uint16_t RATCHET_BYTES_PER_SEC = 2500; // ~80% of 31250 baud, room for clock/CC
+
     static inline uint32_t microDelayUs(int16_t micro_q8, float bpm)
     {
         if (micro_q8 <= 0)
@@ -15,22 +59,270 @@ struct PlaybackEngine
         return (uint32_t)((int32_t)micro_q8 * (int32_t)upt / 256);
     }
 
-    void processTick(uint32_t prev, uint32_t curr, const Pattern &p, std::vector<MidiEvent> &out)
+    // Bit t set: only soloed tracks play (mutes still apply); 0 = no solo
+    void setSolo(uint16_t mask) { solo_ = mask; }
+    uint16_t solo() const { return solo_; }
+    // Tracks the cursors currently play
+    uint16_t audible() const { return audible_; }
+    // Fill state for trig::Fill / NotFill notes; takes effect on the next due note
+    void setFill(bool on) { fill_ = on; }
+    bool fill() const { return fill_; }
+    // Probability seed, applied at the next start/locate
+    void setSeed(uint32_t s) { seed_ = s; }
+    uint32_t seed() const { return seed_; }
+    // Output budget ratchet repeats must fit in (bytes/s, all note traffic counts)
+    void setRatchetBudget(uint16_t bytesPerSec) { budget_ = bytesPerSec; }
+
+    // Emit events for the transport window (prev, curr]
+    void processTick(uint32_t prev, uint32_t curr, const Timeline &tl, float bpm, std::vector<MidiEvent> &out)
+    {
+        const uint16_t audible = (uint16_t)((solo_ ? solo_ : 0xFFFF) & ~tl.muted());
+        if (!synced_ || prev != last_)
+            relocate(tl, prev, true, audible); // start, stop or locate
+        else if (tl.rev() != tlRev_ || audible != audible_)
+            relocate(tl, prev, false, audible); // rebuilt or (un)muted under us: keep already-fired notes
+        last_ = curr;
+        now_++;
+        size_t mark = out.size();
+        credit_ += (int32_t)(usPerTick(Tempo{bpm, 96}) * budget_ / 1000);
+        if (credit_ > CREDIT_MAX)
+            credit_ = CREDIT_MAX;
+
+        // Note-offs first so a retrigger on the same tick is not cut short
+        while (!offs_.empty() && due(offs_.top().at))
+        {
+            out.push_back(MidiEvent{offs_.top().ch, offs_.top().pitch, 0, false, 0});
+            offs_.pop();
+        }
+
+        for (uint8_t i = 0; i < rollN_;)
+        {
+            Roll &r = rolls_[i];
+            if (!due(r.at))
+            {
+                ++i;
+                continue;
+            }
+            spend(out, mark);
+            if (credit_ < 2 * MSG_COST) // room for the hit and its note-off
+                ratchetDropped_++;
+            else if (offs_.push(r.at + ratchet::gate(r.interval), r.ch, r.pitch))
+                out.push_back(MidiEvent{r.ch, r.pitch, ratchet::velocity(r.flags, r.vel, r.k), true,
+                                        microDelayUs(r.micro, bpm)});
+            if (++r.k == ratchet::hits(r.flags))
+            {
+                rolls_[i] = rolls_[--rollN_];
+                continue;
+            }
+            r.at += r.interval;
+            ++i;
+        }
+
+        while (heapN_ && due(heap_[0].at))
+        {
+            const uint8_t t = heap_[0].trk;
+            const Timeline::TrackTimeline &tt = tl.track(t);
+            Cursor &c = cur_[t];
+
+            const uint8_t f = c.it.flags();
+            if (!(f & NF_Mute) && trig(c, t))
+            {
+                if (f & NF_Ratchet)
+                    startRoll(c, tt, t, heap_[0].at, bpm, out);
+                else if (offs_.push(heap_[0].at + (c.it.duration() ? c.it.duration() : 1u), tt.ch, c.it.pitch()))
+                    out.push_back(MidiEvent{tt.ch, c.it.pitch(), c.it.vel(), true, microDelayUs(c.it.micro_q8(), bpm)});
+            }
+
+            ++c.it;
+            if (c.it == tt.ev.end())
+            {
+                c.base += tt.len;
+                c.pass++;
+                c.it = tt.ev.begin();
+            }
+            heap_[0].at = c.base + c.it.on();
+            siftDown(0);
+        }
+        spend(out, mark);
+        if (credit_ < CREDIT_MIN)
+            credit_ = CREDIT_MIN;
+    }
+
+    // Release everything still sounding (transport stop) and resync on next tick
+    void allOff(std::vector<MidiEvent> &out)
     {
-        const uint32_t L = p.ticks();
-        const auto &trk = p.track;
-        const uint8_t ch = trk.channel;
+        for (uint8_t i = 0; i < offs_.size(); ++i)
+            out.push_back(MidiEvent{offs_[i].ch, offs_[i].pitch, 0, false, 0});
+        offs_.clear();
+        rollN_ = 0;
+        synced_ = false;
+    }
 
-        auto inside = [&](uint32_t x) -> bool
-        { return (prev < curr) ? (x > prev && x <= curr) : (x > prev || x <= curr); };
+    // Current position of track t in its own loop (transport ticks), valid once playing
+    uint32_t trackPhase(uint8_t t) const
+    {
+        const Cursor &c = cur_[t];
+        if (!synced_ || !c.len)
+            return 0;
+        int32_t ph = (int32_t)(now_ - c.base) % (int32_t)c.len;
+        return (uint32_t)(ph < 0 ? ph + (int32_t)c.len : ph);
+    }
+    bool synced() const { return synced_; }
 
-        for (const auto &n : trk.notes)
+    uint8_t sounding() const { return offs_.size(); }
+    uint32_t offOverflow() const { return offs_.overflow(); }
+    uint8_t rolling() const { return rollN_; }
+    // Ratchet repeats dropped by the output budget / notes ratcheted while every Roll was busy
+    uint32_t ratchetDropped() const { return ratchetDropped_; }
+    uint32_t rollOverflow() const { return rollOverflow_; }
+
+private:
+    struct Cursor
+    {
+        NoteStore::const_iterator it;
+        uint32_t base; // absolute tick at which the current loop pass started
+        uint32_t len;  // track loop length (0 while the track is empty)
+        uint32_t pass;  // loop count at the transport position, for trig conditions
+        uint32_t first; // pass played first since start/locate
+    };
+    struct Due
+    {
+        uint32_t at; // absolute tick
+        uint8_t trk;
+    };
+    // Remaining hits of a ratcheted note
+    struct Roll
+    {
+        uint32_t at;       // absolute tick of hit k
+        uint32_t interval; // ticks between hits
+        int16_t micro;
+        uint8_t trk, ch, pitch, vel, flags;
+        uint8_t k; // next hit, 1..hits-1
+    };
+    static constexpr int32_t MSG_COST = 3000;            // one 3-byte message, in 1/1000 byte
+    static constexpr int32_t CREDIT_MAX = 8 * MSG_COST; // burst allowance
+    static constexpr int32_t CREDIT_MIN = -1000 * MSG_COST; // debt from unthrottled notes: ~1 s of UART
+
+    Cursor cur_[MAX_TRACKS]{};
+    Due heap_[MAX_TRACKS]{};
+    uint8_t heapN_{0};
+    NoteOffQueue<MAX_OFFS> offs_;
+    Roll rolls_[MAX_ROLLS]{};
+    uint8_t rollN_{0};
+    uint16_t budget_{RATCHET_BYTES_PER_SEC};
+    int32_t credit_{CREDIT_MAX};
+    uint32_t ratchetDropped_{0}, rollOverflow_{0};
+
+    uint32_t now_{0};  // absolute tick of the last processed window end
+    uint32_t last_{0}; // transport tick expected as next prev
+    uint32_t start_{0}; // transport tick of the last start/locate
+    uint32_t tlRev_{0};
+    uint16_t solo_{0};
+    uint16_t audible_{0};
+    bool synced_{false};
+    bool fill_{false};
+    uint32_t seed_{1};
+    XorShift32 rng_[MAX_TRACKS];
+
+    bool due(uint32_t at) const { return (int32_t)(at - now_) <= 0; }
+
+    // Condition first (no draw), then the skip chance
+    bool trig(const Cursor &c, uint8_t t)
+    {
+        const uint8_t cond = c.it.cond(), skip = c.it.skip();
+        if (cond && !trig::passes(cond, c.pass, c.pass == c.first, fill_))
+            return false;
+        return !skip || rng_[t].percent() >= skip;
+    }
+    static bool before(uint32_t a, uint32_t b) { return NoteOffQueue<MAX_OFFS>::before(a, b); }
+
+    // Charge the output budget for events sent since `mark`
+    void spend(const std::vector<MidiEvent> &out, size_t &mark)
+    {
+        credit_ -= (int32_t)(out.size() - mark) * MSG_COST;
+        mark = out.size();
+    }
+
+    // First hit of a ratcheted note now, the rest from rolls_
+    void startRoll(const Cursor &c, const Timeline::TrackTimeline &tt, uint8_t t, uint32_t at, float bpm,
+                   std::vector<MidiEvent> &out)
+    {
+        const uint8_t f = c.it.flags();
+        const uint32_t iv = ratchet::interval(f, c.it.duration());
+        if (offs_.push(at + ratchet::gate(iv), tt.ch, c.it.pitch()))
+            out.push_back(MidiEvent{tt.ch, c.it.pitch(), ratchet::velocity(f, c.it.vel(), 0), true,
+                                    microDelayUs(c.it.micro_q8(), bpm)});
+        if (rollN_ < MAX_ROLLS)
+            rolls_[rollN_++] = Roll{at + iv, iv, c.it.micro_q8(), t, tt.ch, c.it.pitch(), c.it.vel(), f, 1};
+        else
+            rollOverflow_++;
+    }
+
+    // Point every track cursor at transport tick `pos`; inclusive also replays events at pos.
+    // Only audible tracks enter the heap; the others keep a cursor for trackPhase().
+    void relocate(const Timeline &tl, uint32_t pos, bool inclusive, uint16_t audible)
+    {
+        heapN_ = 0;
+        // Pending repeats belong to the old position; keep those of still audible tracks across a rebuild
+        for (uint8_t i = 0; i < rollN_;)
+            if (inclusive || !(audible & (1u << rolls_[i].trk)))
+                rolls_[i] = rolls_[--rollN_];
+            else
+                ++i;
+        if (inclusive)
+            start_ = pos;
+        for (uint8_t t = 0; t < MAX_TRACKS; ++t)
+        {
+            Cursor &c = cur_[t];
+            const uint32_t oldLen = c.len;
+            c.len = 0;
+            if (t >= tl.count() || tl.track(t).ev.empty())
+                continue;
+            const Timeline::TrackTimeline &tt = tl.track(t);
+            const uint32_t ph = pos % tt.len;
+            c.len = tt.len;
+            c.base = now_ - ph;
+            c.pass = pos / tt.len;
+            if (inclusive)
+                rng_[t].seed(seed_ ^ (t + 1u) * 0x9E3779B9u ^ pos);
+            size_t i = inclusive ? tt.ev.lowerBound(ph) : tt.ev.upperBound(ph);
+            if (i == tt.ev.size())
+            {
+                i = 0;
+                c.base += tt.len;
+                c.pass++;
+            }
+            // A rebuild keeps the first pass; a new length renumbers it from the last locate
+            if (inclusive)
+                c.first = c.pass;
+            else if (tt.len != oldLen)
+                c.first = start_ / tt.len;
+            c.it = tt.ev.at(i);
+            if (audible & (1u << t))
+                heap_[heapN_++] = Due{c.base + c.it.on(), t};
+        }
+        for (int i = heapN_ / 2 - 1; i >= 0; --i)
+            siftDown((unsigned)i);
+        tlRev_ = tl.rev();
+        audible_ = audible;
+        synced_ = true;
+    }
+
+    void siftDown(unsigned i)
+    {
+        for (;;)
         {
-            uint32_t on = n.on % L, off = (n.on + n.duration) % L;
-            if (inside(on))
-                out.push_back(MidiEvent{ch, n.pitch, n.vel, true, microDelayUs(n.micro_q8, p.tempo)});
-            if (inside(off))
-                out.push_back(MidiEvent{ch, n.pitch, 0, false, 0});
+            unsigned l = 2 * i + 1, r = l + 1, m = i;
+            if (l < heapN_ && before(heap_[l].at, heap_[m].at))
+                m = l;
+            if (r < heapN_ && before(heap_[r].at, heap_[m].at))
+                m = r;
+            if (m == i)
+                return;
+            Due tmp = heap_[i];
+            heap_[i] = heap_[m];
+            heap_[m] = tmp;
+            i = m;
         }
     }
 };
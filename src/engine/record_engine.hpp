@@ -1,17 +1,56 @@
 #pragma once
 #include <stdint.h>
-#include <unordered_map>
 #include "model/pattern.hpp"
+#include "core/ring_buffer.hpp"
 #include "core/transport.hpp"
 #include "core/timebase.hpp"
+#include "engine/playback_engine.hpp"
+#include "engine/latency.hpp"
+#include "model/pattern_history.hpp"
+#include "model/take_stack.hpp"
 
+/**
+ * Live recording into the selected track. Held notes sit in a fixed table
+ * indexed by pitch; a note-off turns one into a finished note and stages it
+ * in a lock-free SPSC ring, so the input path never allocates, hashes or
+ * touches the pattern. commit() (RunLoop, before it checks the timeline)
+ * merges the staged notes into their tracks in start order. idle() commits
+ * in batches rather than note by note, since every merge shifts the notes
+ * behind the insert point and makes the track recompile: it waits for BATCH
+ * notes or for the gap since the last commit, and the gap doubles while a
+ * commit runs over COMMIT_CAP_US.
+ * Notes keep the played timing (tick + micro_q8, from the input layer's
+ * edge timestamp, less the source's calibrated latency); the track's
+ * Quantize is applied by Timeline instead.
+ *
+ * Loop-take mode records every pass of the selected track's loop into its
+ * own TakeStack take instead of the track; the pass a note belongs to is
+ * taken at its note-on (a note held across the loop point lands in the take
+ * open when it is released).
+ */
 class RecordEngine
 {
 public:
-    void begin(Pattern *pat, Transport *tx)
+    static constexpr uint8_t STAGE = 64; // finished notes awaiting commit (ring holds STAGE - 1)
+    static constexpr uint8_t BATCH = STAGE / 2;    // staged notes that commit without waiting for the gap
+    static constexpr uint32_t MIN_GAP_US = 10000;  // commit spacing, widened up to MAX_GAP_US
+    static constexpr uint32_t MAX_GAP_US = 160000; // while commits run over the cap
+    static constexpr uint32_t COMMIT_CAP_US = 100;
+
+    struct Stats
+    {
+        uint32_t commits;
+        uint32_t lastUs, maxUs;
+    };
+
+    // eng (optional) supplies the selected track's own loop phase for polymetric tracks;
+    // hist (optional) gets a checkpoint at every punch-in so a take can be undone
+    void begin(Pattern *pat, Transport *tx, const PlaybackEngine *eng = nullptr, PatternHistory *hist = nullptr)
     {
         pat_ = pat;
         tx_ = tx;
+        eng_ = eng;
+        hist_ = hist;
     }
 
     void arm(bool on)
@@ -21,71 +60,278 @@ public:
             punching_ = false;
     }
     bool isArmed() const { return armed_; }
+    // Input layers report edges while this is true (armed or calibrating latency)
+    bool listening() const { return armed_ || lat_.calibrating(); }
+    LatencyComp &latency() { return lat_; }
     bool isPunching() const { return punching_; }
+    // Loop-take mode: each pass goes into a new take (see TakeStack)
+    void setLoopTakes(bool on)
+    {
+        loopTakes_ = on;
+        takes_.close();
+    }
+    bool loopTakes() const { return loopTakes_; }
+    TakeStack &takes() { return takes_; }
+    const TakeStack &takes() const { return takes_; }
+    // Notes lost: staging ring full or note pool exhausted at commit
+    uint32_t dropped() const { return dropped_; }
+    uint32_t staged() const { return stage_.depth(); }
+    uint32_t committed() const { return committed_; }
+    const Stats &stats() const { return stats_; }
+    uint32_t gapUs() const { return gapUs_; }
 
-    // Called on live performance events (already sent to MIDI)
-    void onLiveNoteOn(uint8_t pitch, uint8_t vel, uint32_t tick)
+    // Called on live performance events (already sent to MIDI). us: micros()
+    // when the input layer saw the edge; timing is kept to 1/256 tick and
+    // quantized only when the track is compiled (Track::quant)
+    void onLiveNoteOn(uint8_t pitch, uint8_t vel, uint32_t us, InputSource src = InputSource::Keys)
     {
-        if (!armed_ || !tx_ || !tx_->isRunning())
+        if (!tx_ || !tx_->isRunning())
             return;
+        if (lat_.calibrating(src))
+        {
+            lat_.tap(beatErrorUs(us)); // tap-along: measured against the beat, nothing recorded
+            return;
+        }
+        if (!armed_)
+            return;
+        us -= (uint32_t)lat_.offsetUs(src);
         if (!punching_)
+        {
             punching_ = true; // first note starts punching
-        uint32_t on = quantize(tick);
-        start_[pitch] = {on, vel};
+            if (hist_ && !loopTakes_)
+                hist_->checkpoint(); // takes are kept apart, the track is untouched
+        }
+        const uint64_t pos = position(us);
+        held_[pitch & 0x7F] = Pending{pos, vel, pat_ ? pat_->sel : (uint8_t)0, true, passOf(pos)};
     }
-    void onLiveNoteOff(uint8_t pitch, uint32_t tick)
+    void onLiveNoteOff(uint8_t pitch, uint32_t us, InputSource src = InputSource::Keys)
     {
-        if (!armed_ || !tx_)
-            return;
-        auto it = start_.find(pitch);
-        if (it == start_.end())
+        Pending &h = held_[pitch & 0x7F];
+        if (!armed_ || !tx_ || !h.down)
             return;
-        uint32_t off = quantize(tick);
-        uint32_t on = it->second.on;
-        uint8_t vel = it->second.vel;
-        start_.erase(it);
+        h.down = false;
+        us -= (uint32_t)lat_.offsetUs(src);
         if (!pat_)
             return;
-        const uint32_t L = pat_->ticks() ? pat_->ticks() : 1u;
-        // duration with wrap handling
-        uint32_t dur = (off >= on) ? (off - on) : ((L - on) + off);
-        if (dur == 0)
-            dur = 1; // avoid zero-length
+        const uint64_t loop = (uint64_t)playLen() << 8;
+        const uint64_t off = position(us);
+        const uint64_t held = off >= h.pos ? off - h.pos : loop - h.pos + off; // wraps the loop
+        const uint32_t div = divOf();
+        const uint32_t unit = div << 8; // one note tick in 1/256 transport ticks
+        uint32_t on = (uint32_t)((h.pos + unit / 2) / unit);
         Note n{};
-        n.on = on % L;
-        n.duration = dur;
-        n.micro = 0;
-        n.micro_q8 = 0;
+        // Residual in 1/256 note tick (-128..127), so a slow track keeps it whole; Timeline scales it back
+        n.micro_q8 = (int16_t)(((int64_t)h.pos - (int64_t)on * unit) / (int32_t)div);
+        if (on >= loopLen())
+            on = 0; // rounded up to the loop end: just before the start
+        n.on = on;
+        n.duration = (uint32_t)((held + unit / 2) / unit);
+        if (n.duration == 0)
+            n.duration = 1; // avoid zero-length
         n.pitch = pitch;
-        n.vel = vel;
+        n.vel = h.vel;
         n.flags = 0;
-        pat_->track.notes.push_back(n);
+        if (!stage_.push(Staged{n, h.trk, h.pass}))
+            dropped_++; // commit has not run for STAGE notes
+    }
+
+    // Service pass: count loop wraps, and commit once BATCH notes are staged or the
+    // gap has passed. Returns true if it committed (time it, noteCommitUs)
+    bool idle(uint32_t us)
+    {
+        pollPass();
+        const uint32_t n = stage_.depth();
+        if (!n || (n < BATCH && us - lastCommit_ < gapUs_))
+            return false;
+        lastCommit_ = us;
+        commit();
+        return true;
+    }
+    void noteCommitUs(uint32_t us)
+    {
+        stats_.commits++;
+        stats_.lastUs = us;
+        if (us > stats_.maxUs)
+            stats_.maxUs = us;
+        if (us > COMMIT_CAP_US)
+            gapUs_ = gapUs_ * 2 < MAX_GAP_US ? gapUs_ * 2 : MAX_GAP_US;
+        else if (us < COMMIT_CAP_US / 4 && gapUs_ > MIN_GAP_US)
+            gapUs_ = gapUs_ / 2 > MIN_GAP_US ? gapUs_ / 2 : MIN_GAP_US;
+    }
+
+    // Safe point (between ticks, main loop): move every staged note into its track now
+    void commit()
+    {
+        if (!pat_)
+            return;
+        pollPass();
+        uint8_t n = 0;
+        while (n < STAGE && stage_.pop(batch_[n]))
+            n++;
+        if (!n)
+            return;
+        // Insertion sort by track, (take pass,) then start: batches are small
+        for (uint8_t i = 1; i < n; ++i)
+            for (uint8_t j = i; j && later(batch_[j - 1], batch_[j], loopTakes_); --j)
+                std::swap(batch_[j - 1], batch_[j]);
+        if (loopTakes_)
+        {
+            commitTakes(n);
+            return;
+        }
+        for (uint8_t i = 0; i < n;)
+        {
+            uint8_t k = 0;
+            const uint8_t t = batch_[i].trk;
+            while (i + k < n && batch_[i + k].trk == t)
+            {
+                notes_[k] = batch_[i + k].n;
+                k++;
+            }
+            const size_t added = t < Pattern::MAX_TRACKS ? pat_->tracks[t].notes.merge(notes_, k) : 0;
+            committed_ += added;
+            dropped_ += k - added;
+            i += k;
+        }
     }
 
 private:
     struct Pending
     {
-        uint32_t on;
+        uint64_t pos; // start in the track's loop, 1/256 transport tick
         uint8_t vel;
+        uint8_t trk; // track selected at note-on
+        bool down;
+        uint16_t pass; // loop pass at note-on
+    };
+    struct Staged
+    {
+        Note n;
+        uint8_t trk;
+        uint16_t pass;
     };
     Pattern *pat_{nullptr};
     Transport *tx_{nullptr};
+    const PlaybackEngine *eng_{nullptr};
+    PatternHistory *hist_{nullptr};
     bool armed_{false};
     bool punching_{false};
-    std::unordered_map<uint8_t, Pending> start_;
+    uint32_t dropped_{0};
+    uint32_t committed_{0};
+    uint32_t lastCommit_{0}, gapUs_{MIN_GAP_US};
+    Stats stats_{};
+    LatencyComp lat_;
+    TakeStack takes_;
+    bool loopTakes_{false};
+    uint16_t pass_{0};       // loop passes of the selected track seen by pollPass()
+    uint32_t lastPhase_{0};
+    uint8_t takeTrk_{0xFF};  // track and pass of the open take
+    uint16_t takePass_{0};
+    Pending held_[128]{};
+    RingBufferSPSC<Staged, STAGE> stage_;
+    Staged batch_[STAGE]; // commit() scratch
+    Note notes_[STAGE];
+
+    static bool later(const Staged &a, const Staged &b, bool byPass)
+    {
+        if (a.trk != b.trk)
+            return a.trk > b.trk;
+        if (byPass && a.pass != b.pass)
+            return (int16_t)(a.pass - b.pass) > 0;
+        return a.n.on > b.n.on;
+    }
 
-    inline uint32_t stepTicks() const
+    // Batch (sorted by track) into the open take, starting a new one for a
+    // new track or a later pass
+    void commitTakes(uint8_t n)
+    {
+        for (uint8_t i = 0; i < n; ++i)
+        {
+            const Staged &s = batch_[i];
+            const bool newer = (int16_t)(s.pass - takePass_) > 0;
+            if (takes_.open() == TakeStack::NONE || s.trk != takeTrk_ || newer)
+            {
+                if (!takes_.begin(s.trk))
+                {
+                    dropped_++;
+                    continue;
+                }
+                takeTrk_ = s.trk;
+                takePass_ = s.pass;
+            }
+            if (takes_.append(s.n))
+                committed_++;
+            else
+                dropped_++;
+        }
+    }
+
+    // Selected track's phase now, in transport ticks
+    uint32_t phaseNow() const
+    {
+        const uint32_t L = playLen();
+        return (eng_ && eng_->synced()) ? eng_->trackPhase(pat_ ? pat_->sel : 0) : tx_->playTick() % L;
+    }
+    // Count loop wraps; called often enough (every service pass) not to miss one
+    void pollPass()
+    {
+        if (!tx_ || !tx_->isRunning())
+            return;
+        const uint32_t ph = phaseNow();
+        if (ph < lastPhase_)
+            pass_++;
+        lastPhase_ = ph;
+    }
+    // Pass of a position: an edge just before the loop point may be seen after it, and the reverse
+    uint16_t passOf(uint64_t pos)
+    {
+        pollPass();
+        const uint32_t L = playLen(), at = (uint32_t)(pos >> 8);
+        if (at > lastPhase_ + L / 2)
+            return pass_ - 1;
+        if (at + L / 2 < lastPhase_)
+            return pass_ + 1;
+        return pass_;
+    }
+
+    uint8_t divOf() const
+    {
+        const uint8_t div = pat_ ? pat_->selected().clockDiv : 1;
+        return div ? div : 1;
+    }
+    // Loop length of the track being recorded into, in its own (undivided) ticks
+    inline uint32_t loopLen() const
+    {
+        uint32_t L = pat_ ? pat_->trackTicks(pat_->sel) : 1u;
+        return L ? L : 1u;
+    }
+    // Same loop in transport ticks
+    uint32_t playLen() const
+    {
+        const uint32_t L = pat_ ? pat_->trackPlayTicks(pat_->sel) : 1u;
+        return L ? L : 1u;
+    }
+    // Distance from the nearest beat at micros() timestamp `us` (negative: early)
+    int32_t beatErrorUs(uint32_t us) const
     {
-        return pat_ ? timebase::ticksPerStep(pat_->grid) : 24u; // default 1/16 at PPQN=96
+        uint8_t frac = 0;
+        const int64_t beat = (int64_t)timebase::PPQN << 8;
+        const int64_t pos = ((int64_t)tx_->playTick() + tx_->offsetAt(us, frac)) * 256 + frac;
+        int64_t r = (pos % beat + beat) % beat;
+        if (r >= beat / 2)
+            r -= beat;
+        return (int32_t)(r * tx_->tickUs() / 256);
     }
-    inline uint32_t loopLen() const { return pat_ ? pat_->ticks() : 1u; }
-    // Round to nearest grid step and clamp to loop
-    uint32_t quantize(uint32_t t) const
+    // Selected track's position at micros() timestamp `us`, in 1/256 transport ticks
+    uint64_t position(uint32_t us) const
     {
-        uint32_t s = stepTicks();
-        uint32_t L = loopLen();
-        uint32_t r = (t + s / 2) / s; // nearest step index
-        uint32_t q = (r * s) % (L ? L : 1u);
-        return q;
+        uint8_t frac = 0;
+        const int32_t ahead = tx_->offsetAt(us, frac);
+        const uint32_t L = playLen();
+        const uint32_t now = phaseNow();
+        int64_t t = ((int64_t)now + ahead) % L;
+        if (t < 0)
+            t += L;
+        return ((uint64_t)t << 8) | frac;
     }
 };
@@ -0,0 +1,156 @@
+#pragma once
+#include <stdint.h>
+
+#include "model/song.hpp"
+#include "engine/pattern_swap.hpp"
+
+/**
+ * Walks a Song chain on top of PatternSwap.
+ * The pattern for the next entry is staged as a Cue swap at the start of the
+ * current entry's last pass and compiled in idle slices, so when that pass
+ * wraps RunLoop only flips buffers between two tick windows. Song position
+ * (base()) is the transport tick at which the current pass started.
+ */
+class SongPlayer
+{
+public:
+    static constexpr uint8_t NONE = Song::END;
+
+    void begin(PatternBank *bank, Song *song)
+    {
+        bank_ = bank;
+        song_ = song;
+    }
+
+    PatternBank *bank() const { return bank_; }
+    Song *chain() const { return song_; }
+    bool active() const { return active_; }
+    uint8_t entry() const { return entry_; }
+    uint8_t pass() const { return pass_; }
+    uint32_t base() const { return active_ ? base_ : 0; }
+    // Entry boundaries where the next pattern was not ready in time
+    uint32_t late() const { return late_; }
+
+    // Start (or restart) the chain at entry e; flips in at the next wrap, or at once while stopped
+    bool start(uint8_t e, PatternSwap &sw)
+    {
+        if (!bank_ || !song_ || e >= song_->length)
+            return false;
+        dropCue(sw);
+        active_ = true;
+        starting_ = true;
+        entry_ = e;
+        pass_ = 0;
+        cue_ = e;
+        return true;
+    }
+    void stop(PatternSwap &sw)
+    {
+        dropCue(sw);
+        active_ = false;
+        starting_ = false;
+    }
+    // Transport stop: back to the first entry
+    void rewind(PatternSwap &sw)
+    {
+        if (active_)
+            start(0, sw);
+    }
+
+    // Idle work: stage the cued pattern and compile one track of it per call
+    void idle(PatternSwap &sw)
+    {
+        if (!active_ || cue_ == NONE)
+            return;
+        if (!staged_)
+        {
+            if (sw.pending())
+                return; // a user swap is in flight; retry next pass
+            if (!sw.stage(bank_->slots[song_->chain[cue_].pat]))
+                return;
+            sw.commit(SwapQuant::Cue);
+            staged_ = true;
+        }
+        sw.prepare(1);
+    }
+
+    // Called for every tick window before playback; true when the cued pattern must go in now
+    bool window(uint32_t prev, uint32_t curr)
+    {
+        if (!active_ || curr > prev)
+            return false; // not a loop wrap
+        if (starting_)
+        {
+            if (!staged_)
+                return false; // not staged yet: start on a later wrap
+            enter(cue_);
+            base_ = song_->offsetOf(entry_, *bank_);
+            return true;
+        }
+        base_ += prev + 1;
+        const uint8_t reps = song_->chain[entry_].repeats;
+        if (++pass_ < reps)
+        {
+            if (pass_ + 1 == reps)
+                cue(song_->next(entry_));
+            return false;
+        }
+        const uint8_t n = song_->next(entry_);
+        if (n == NONE)
+        {
+            active_ = false; // end of a non-looping song: keep looping the last pattern
+            return false;
+        }
+        const bool ready = staged_ && cue_ == n;
+        if (!ready)
+            late_++;
+        if (n <= entry_)
+            base_ = 0; // song looped: position restarts with it
+        enter(n);
+        return ready;
+    }
+
+    // RunLoop flipped the buffers outside window() (transport stopped)
+    void flipped()
+    {
+        if (active_ && starting_ && staged_)
+        {
+            enter(cue_);
+            base_ = song_->offsetOf(entry_, *bank_);
+        }
+    }
+
+private:
+    PatternBank *bank_{nullptr};
+    Song *song_{nullptr};
+
+    bool active_{false};
+    bool starting_{false};
+    uint8_t entry_{0};
+    uint8_t pass_{0};
+    uint8_t cue_{NONE};  // entry whose pattern goes in at the next entry boundary
+    bool staged_{false}; // cue_ sits in the swap back buffer
+    uint32_t base_{0};
+    uint32_t late_{0};
+
+    void cue(uint8_t e)
+    {
+        cue_ = e;
+        staged_ = false;
+    }
+    void enter(uint8_t e)
+    {
+        starting_ = false;
+        entry_ = e;
+        pass_ = 0;
+        cue(NONE);
+        if (song_->chain[e].repeats <= 1)
+            cue(song_->next(e));
+    }
+    void dropCue(PatternSwap &sw)
+    {
+        if (staged_ && sw.pendingCue())
+            sw.cancel();
+        cue(NONE);
+    }
+};
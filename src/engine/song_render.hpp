@@ -0,0 +1,134 @@
+#pragma once
+#include <stdint.h>
+
+#include "model/song.hpp"
+#include "engine/playback_engine.hpp"
+#include "storage/stream_file.hpp"
+#include "core/xorshift.hpp"
+
+/**
+ * Flattens a Song chain into a stream file (every pass of every entry, all
+ * tracks merged in time order) so it can be played by StreamPlayer without
+ * holding the song in RAM. Each pass starts every track at phase 0, as after
+ * a locate. Trigs are decided here, once: conditions count a track's loops
+ * from the entry start (fill off) and skip chances draw from per-track
+ * generators seeded with `seed`, so a render is repeatable. Ratchets are
+ * expanded into their hits (no output budget: the file is read ahead).
+ * Uses a scratch Timeline: run it with the transport stopped.
+ * Returns the song length in ticks, 0 on error.
+ */
+inline uint32_t renderSong(const Song &song, const PatternBank &bank, StreamWriter &w, uint32_t seed = 1)
+{
+    static Timeline tl;
+    struct Head
+    {
+        NoteStore::const_iterator it;
+        uint32_t base;
+        bool live;
+    };
+    // Ratchet hits still to write; flushed in time order before any later note
+    struct Hit
+    {
+        uint32_t at, interval;
+        stream_file::Event ev;
+        uint8_t flags, vel, k;
+    };
+    Hit hits[PlaybackEngine::MAX_ROLLS];
+    uint8_t hitN = 0;
+    auto flush = [&](uint32_t until) -> bool
+    {
+        for (;;)
+        {
+            uint8_t m = hitN;
+            for (uint8_t i = 0; i < hitN; ++i)
+                if (hits[i].at <= until && (m == hitN || hits[i].at < hits[m].at))
+                    m = i;
+            if (m == hitN)
+                return true;
+            Hit &h = hits[m];
+            h.ev.on = h.at;
+            h.ev.vel = ratchet::velocity(h.flags, h.vel, h.k);
+            if (!w.add(h.ev))
+                return false;
+            if (++h.k == ratchet::hits(h.flags))
+                hits[m] = hits[--hitN];
+            else
+                h.at += h.interval;
+        }
+    };
+    XorShift32 rng[Timeline::MAX_TRACKS];
+    for (uint8_t t = 0; t < Timeline::MAX_TRACKS; ++t)
+        rng[t].seed(seed ^ (t + 1u) * 0x9E3779B9u);
+    uint32_t offset = 0;
+    bool ok = true;
+    for (uint8_t e = 0; ok && e < song.length; ++e)
+    {
+        const Pattern &p = bank.slots[song.chain[e].pat];
+        const uint32_t passLen = p.ticks();
+        tl.build(p);
+        const uint32_t entryStart = offset;
+        for (uint8_t r = 0; ok && r < song.chain[e].repeats; ++r, offset += passLen)
+        {
+            Head h[Timeline::MAX_TRACKS];
+            for (uint8_t t = 0; t < Timeline::MAX_TRACKS; ++t)
+            {
+                h[t].live = t < tl.count() && !tl.track(t).mute && !tl.track(t).ev.empty();
+                if (h[t].live)
+                {
+                    h[t].it = tl.track(t).ev.begin();
+                    h[t].base = 0;
+                }
+            }
+            for (;;)
+            {
+                // Earliest pending note over all tracks (16-way scan)
+                uint8_t best = Timeline::MAX_TRACKS;
+                uint32_t at = passLen;
+                for (uint8_t t = 0; t < tl.count(); ++t)
+                    if (h[t].live && h[t].base + h[t].it.on() < at)
+                    {
+                        at = h[t].base + h[t].it.on();
+                        best = t;
+                    }
+                if (best == Timeline::MAX_TRACKS)
+                    break;
+                const Timeline::TrackTimeline &tt = tl.track(best);
+                Head &c = h[best];
+                const uint32_t loop = (offset - entryStart + c.base) / tt.len;
+                if (!(c.it.flags() & NF_Mute) && (!c.it.cond() || trig::passes(c.it.cond(), loop, loop == 0, false)) &&
+                    (!c.it.skip() || rng[best].percent() >= c.it.skip()))
+                {
+                    const int16_t m = c.it.micro_q8();
+                    const uint32_t d = c.it.duration() ? c.it.duration() : 1;
+                    stream_file::Event ev{};
+                    ev.on = offset + at;
+                    ev.duration = (uint16_t)(d > 0xFFFF ? 0xFFFF : d);
+                    ev.micro = (int8_t)(m < -128 ? -128 : (m > 127 ? 127 : m));
+                    ev.ch = tt.ch;
+                    ev.pitch = c.it.pitch();
+                    ev.vel = c.it.vel();
+                    const uint8_t f = c.it.flags();
+                    ok = flush(ev.on);
+                    if (ok && (f & NF_Ratchet))
+                    {
+                        const uint32_t iv = ratchet::interval(f, d);
+                        const uint32_t g = ratchet::gate(iv);
+                        ev.duration = (uint16_t)(g > 0xFFFF ? 0xFFFF : g);
+                        ev.vel = ratchet::velocity(f, ev.vel, 0);
+                        if (hitN < PlaybackEngine::MAX_ROLLS)
+                            hits[hitN++] = Hit{ev.on + iv, iv, ev, f, c.it.vel(), 1};
+                    }
+                    ok = ok && w.add(ev);
+                }
+                if (++c.it == tt.ev.end())
+                {
+                    c.base += tt.len; // track shorter than the pattern: loop it within the pass
+                    c.it = tt.ev.begin();
+                }
+            }
+        }
+    }
+    ok = ok && flush(UINT32_MAX);
+    tl.clear();
+    return ok && offset && w.finish(offset) ? offset : 0;
+}
@@ -0,0 +1,313 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+#include "core/midi_event.hpp"
+#include "engine/note_off_queue.hpp"
+#include "engine/playback_engine.hpp"
+#include "storage/stream_file.hpp"
+
+/**
+ * Plays a song-length stream file (storage/stream_file.hpp) from the card.
+ * Blocks go through a ring of caller-provided buffers (OCRAM on the Teensy):
+ * fill() reads ahead in idle time, one block per call, or a short burst while
+ * fewer than leadTicks are buffered. processTick() only ever touches
+ * the ring, and a window that finds the ring empty counts an underrun; so
+ * does a start, locate or loop wrap the ring was not positioned for, which
+ * drops the ring instead of seeking. The next fill() then jumps the reader to
+ * the playhead, and events that still turn up after their tick are dropped
+ * instead of played late. Reading wraps to block 0 at the end of the stream,
+ * so fill() reads the next pass ahead of the loop end and the wrap is seamless.
+ * Locate binary-searches the block index; call it outside the tick loop.
+ */
+class StreamPlayer
+{
+public:
+    static constexpr uint8_t MAX_OFFS = 128;
+
+    struct Stats
+    {
+        uint32_t blocksRead;
+        uint32_t underruns; // windows that found the ring empty or not positioned at the playhead
+        uint32_t dropped;   // events read after their tick had passed
+        uint32_t resyncs;   // reader jumped to the playhead after an underrun
+        uint32_t locates;
+        uint32_t played;
+        uint32_t minLead; // fewest ticks buffered ahead of the playhead while playing
+        uint32_t readErrors;
+    };
+
+    void begin(stream_file::Block *ring, uint8_t blocks, uint32_t leadTicks)
+    {
+        ring_ = ring;
+        cap_ = blocks < MAX_RING ? blocks : MAX_RING;
+        leadTicks_ = leadTicks;
+    }
+
+    bool open(const char *path)
+    {
+        using namespace stream_file;
+        close();
+        if (!ring_ || !f_.open(path, false))
+            return false;
+        if (!f_.seek(0) || f_.read(&hdr_, sizeof(hdr_)) != sizeof(hdr_) || hdr_.magic != MAGIC ||
+            hdr_.version != VERSION || hdr_.blockBytes != BLOCK_BYTES || !hdr_.length)
+        {
+            f_.close();
+            return false;
+        }
+        stats_ = Stats{};
+        stats_.minLead = UINT32_MAX;
+        channels_ = 0;
+        open_ = true;
+        locate(0);
+        return true;
+    }
+    void close()
+    {
+        f_.close();
+        open_ = false;
+        synced_ = false;
+        count_ = 0;
+    }
+
+    bool isOpen() const { return open_; }
+    uint32_t length() const { return open_ ? hdr_.length : 0; }
+    uint32_t events() const { return open_ ? hdr_.events : 0; }
+    uint32_t blocks() const { return open_ ? hdr_.blocks : 0; }
+    uint8_t buffered() const { return count_; }
+    uint16_t channels() const { return channels_; } // bit ch-1 set once a note played on ch
+    const Stats &stats() const { return stats_; }
+
+    // Point the ring at the first event at or after `tick`; reads synchronously.
+    // Call it ahead of a start (e.g. on stop) to keep the first window cheap.
+    void locate(uint32_t tick)
+    {
+        count_ = 0;
+        ev_ = 0;
+        pass_ = fillPass_ = 0;
+        located_ = UINT32_MAX;
+        if (!open_ || !hdr_.blocks)
+            return;
+        stats_.locates++;
+        // First block starting after tick; the one before it may still hold events >= tick
+        uint32_t lo = 0, hi = hdr_.blocks;
+        while (lo < hi)
+        {
+            uint32_t mid = (lo + hi) / 2, first;
+            if (!f_.seek(hdr_.index + mid * 4) || f_.read(&first, 4) != 4)
+            {
+                stats_.readErrors++;
+                return;
+            }
+            if (first < tick)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        next_ = lo ? lo - 1 : 0;
+        if (!readBlock())
+            return;
+        for (;;)
+        {
+            const stream_file::Block &b = ring_[head_];
+            while (ev_ < b.count && b.ev[ev_].on < tick)
+                ev_++;
+            if (ev_ < b.count)
+                break;
+            popFront();
+            if (!readBlock() || tag_[head_] != pass_)
+                break; // past the last event: the next pass starts at the wrap
+        }
+        // A little read-ahead so the first windows after the jump cannot starve
+        while (count_ < LOCATE_BLOCKS && readBlock())
+        {
+        }
+        located_ = tick;
+    }
+
+    // Idle work: read ahead `budget` blocks, more while under the lead target; returns blocks read
+    uint8_t fill(uint32_t playhead, uint8_t budget = 1)
+    {
+        uint8_t n = 0;
+        if (open_ && behind_ && !count_)
+        {
+            // Starved: whatever the reader would fetch next is already late
+            stats_.resyncs++;
+            locate(playhead + 1);
+            n = count_;
+        }
+        behind_ = false;
+        while (open_ && count_ < cap_ && (n < budget || (n < budget * BURST && lead(playhead) < leadTicks_)))
+        {
+            if (!readBlock())
+                break;
+            n++;
+        }
+        return n;
+    }
+
+    // Ticks of events buffered ahead of the playhead
+    uint32_t lead(uint32_t playhead) const
+    {
+        if (!count_)
+            return 0;
+        const stream_file::Block &b = ring_[slot(count_ - 1)];
+        const uint32_t last = b.count ? b.ev[b.count - 1].on : 0;
+        const uint32_t end = (uint32_t)(uint8_t)(tag_[slot(count_ - 1)] - pass_) * hdr_.length + last;
+        return end > playhead ? end - playhead : 0;
+    }
+
+    // Emit events for the transport window (prev, curr]
+    void processTick(uint32_t prev, uint32_t curr, float bpm, std::vector<MidiEvent> &out)
+    {
+        if (!open_)
+            return;
+        uint32_t from = prev + 1;
+        if (!synced_ || prev != last_)
+        {
+            if (located_ != prev)
+                miss(); // start, stop or transport locate nobody located the ring for
+            from = prev;
+            synced_ = true;
+        }
+        else if (curr < prev)
+        {
+            // Loop wrap: continue into the next pass if the ring already holds its start
+            while (count_ && tag_[head_] == pass_)
+                popFront(); // events past the loop length never play
+            if (count_ && tag_[head_] == (uint8_t)(pass_ + 1) && blockOf_[head_] == 0 && ev_ == 0)
+                pass_++;
+            else
+                miss();
+            from = 0;
+        }
+        located_ = UINT32_MAX;
+        last_ = curr;
+        now_++;
+
+        while (!offs_.empty() && (int32_t)(offs_.top().at - now_) <= 0)
+        {
+            out.push_back(MidiEvent{offs_.top().ch, offs_.top().pitch, 0, false, 0});
+            offs_.pop();
+        }
+
+        for (;;)
+        {
+            if (!count_)
+            {
+                if (hdr_.blocks)
+                {
+                    stats_.underruns++;
+                    behind_ = true;
+                }
+                break;
+            }
+            if (tag_[head_] != pass_)
+                break; // next pass: wait for the wrap
+            const stream_file::Block &b = ring_[head_];
+            if (ev_ >= b.count)
+            {
+                popFront();
+                continue;
+            }
+            const stream_file::Event &e = b.ev[ev_];
+            if (e.on > curr)
+                break;
+            ev_++;
+            if (e.on < from)
+            {
+                stats_.dropped++;
+                continue;
+            }
+            const uint8_t ch = e.ch ? e.ch : 1;
+            if (offs_.push(now_ + (e.duration ? e.duration : 1u), ch, e.pitch))
+            {
+                out.push_back(MidiEvent{ch, e.pitch, e.vel, true, PlaybackEngine::microDelayUs(e.micro, bpm)});
+                channels_ |= (uint16_t)(1u << ((ch - 1) & 0x0F));
+                stats_.played++;
+            }
+        }
+
+        const uint32_t l = lead(curr);
+        if (l < stats_.minLead)
+            stats_.minLead = l;
+    }
+
+    // Release everything still sounding (transport stop) and resync on next tick
+    void allOff(std::vector<MidiEvent> &out)
+    {
+        for (uint8_t i = 0; i < offs_.size(); ++i)
+            out.push_back(MidiEvent{offs_[i].ch, offs_[i].pitch, 0, false, 0});
+        offs_.clear();
+        synced_ = false;
+    }
+    uint8_t sounding() const { return offs_.size(); }
+
+private:
+    static constexpr uint8_t MAX_RING = 64;
+    static constexpr uint8_t LOCATE_BLOCKS = 4;
+    static constexpr uint8_t BURST = 4; // fill() multiplier while under the lead target
+
+    BlockFile f_;
+    stream_file::Header hdr_{};
+    bool open_{false};
+
+    stream_file::Block *ring_{nullptr};
+    uint8_t cap_{0};
+    uint8_t tag_[MAX_RING]{};     // loop pass a buffered block belongs to (mod 256)
+    uint32_t blockOf_[MAX_RING]{}; // block number held by each slot
+    uint8_t head_{0}, count_{0};
+    uint16_t ev_{0};  // next event in the front block
+    uint8_t pass_{0}; // loop pass being played
+    uint8_t fillPass_{0};
+    uint32_t next_{0}; // next block to read
+    uint32_t located_{UINT32_MAX}; // tick the ring was positioned at, until playback moves on
+    uint32_t leadTicks_{0};
+
+    NoteOffQueue<MAX_OFFS> offs_;
+    uint32_t now_{0}, last_{0};
+    bool synced_{false};
+    bool behind_{false}; // ring ran dry since the last fill()
+    uint16_t channels_{0};
+    Stats stats_{};
+
+    uint8_t slot(uint8_t i) const { return (uint8_t)((head_ + i) % cap_); }
+
+    bool readBlock()
+    {
+        if (count_ >= cap_ || !hdr_.blocks)
+            return false;
+        const uint8_t s = slot(count_);
+        if (!f_.seek(stream_file::blockOffset(next_)) || f_.read(&ring_[s], sizeof(ring_[s])) != sizeof(ring_[s]))
+        {
+            stats_.readErrors++;
+            return false;
+        }
+        tag_[s] = fillPass_;
+        blockOf_[s] = next_;
+        count_++;
+        stats_.blocksRead++;
+        if (++next_ == hdr_.blocks)
+        {
+            next_ = 0;
+            fillPass_++;
+        }
+        return true;
+    }
+
+    void popFront()
+    {
+        head_ = slot(1);
+        count_--;
+        ev_ = 0;
+    }
+
+    // The ring does not hold the playhead: drop it, so the window counts an underrun
+    // and the next fill() seeks
+    void miss()
+    {
+        count_ = 0;
+        ev_ = 0;
+    }
+};
@@ -0,0 +1,314 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+
+#include "model/pattern.hpp"
+#include "model/note_store.hpp"
+#include "model/take_stack.hpp"
+
+/**
+ * Compiled, play-ready form of a Pattern.
+ * Each track's notes are copied into their own NoteStore sorted by start tick,
+ * so PlaybackEngine can walk every track with a cursor instead of scanning all
+ * notes each tick. Tracks are only recompiled when their source changed.
+ *
+ * Tracks loop independently: a track's timeline covers its own step count and
+ * is stretched by its clock divisor (starts and durations in transport ticks),
+ * so polymeters never expand to a pattern-wide common multiple.
+ *
+ * A track's Quantize pulls notes toward the pattern grid here, before the
+ * groove, so recorded timing is never lost and requantizing only rebuilds.
+ * The pattern's Groove is applied here too: each note is moved by its step
+ * position's offset (whole ticks into `on`, the rest into micro_q8, wrapping
+ * within the loop) and its velocity adjusted, so grooved playback costs
+ * nothing per tick. A groove edit marks every track dirty and they rebuild
+ * through the usual budgeted build(), a few per RunLoop pass.
+ *
+ * With a TakeStack, a track's active loop-recording takes are compiled in
+ * with its notes (same stretch, quantize and groove), so the engine plays
+ * one merged stream; muted takes are never read.
+ */
+class Timeline
+{
+public:
+    static constexpr uint8_t MAX_TRACKS = Pattern::MAX_TRACKS;
+
+    struct TrackTimeline
+    {
+        NoteStore ev;     // sorted by start tick, all starts < len
+        uint32_t len{1};  // loop length in transport ticks
+        uint8_t div{1};   // clock divisor the events were stretched by
+        uint8_t ch{1};
+        bool mute{false};
+        uint32_t srcRev{0};
+        uint32_t grooveRev{0};
+        uint32_t takeRev{0};
+        uint32_t grid{0}; // pattern step in note ticks, for quantize
+        Quantize quant{};
+        uint32_t maxDur{0}; // longest note, in transport ticks (bounds windowed lookups)
+        bool built{false};
+    };
+
+    // True if any track differs from what was last compiled
+    bool stale(const Pattern &p, const TakeStack *takes = nullptr) const
+    {
+        if (p.trackCount != count_ || muteMask(p) != muted_)
+            return true;
+        for (uint8_t t = 0; t < count_; ++t)
+            if (dirty(tracks_[t], p.tracks[t], p.trackPlayTicks(t), gridOf(p), p.groove, takeRev(takes, t)))
+                return true;
+        return false;
+    }
+
+    // Recompile changed tracks, at most `budget` of them per call (idle slicing);
+    // returns true if anything changed. takes: active takes to merge in (optional)
+    bool build(const Pattern &p, uint8_t budget = MAX_TRACKS, const TakeStack *takes = nullptr)
+    {
+        bool changed = p.trackCount != count_;
+        for (uint8_t t = 0; t < p.trackCount; ++t)
+        {
+            TrackTimeline &dst = tracks_[t];
+            const Track &src = p.tracks[t];
+            const uint32_t len = p.trackPlayTicks(t) ? p.trackPlayTicks(t) : 1u;
+            if (!dirty(dst, src, len, gridOf(p), p.groove, takeRev(takes, t)))
+                continue;
+            if (!budget--)
+                break;
+            compile(dst, src, len, gridOf(p), p.groove, takes, t);
+            changed = true;
+        }
+        for (uint8_t t = p.trackCount; t < count_; ++t)
+        {
+            tracks_[t].ev.clear();
+            tracks_[t].built = false;
+        }
+        count_ = p.trackCount;
+        // Mutes never recompile: the engine reads the mask on the next tick
+        for (uint8_t t = 0; t < count_; ++t)
+            tracks_[t].mute = p.tracks[t].mute;
+        muted_ = muteMask(p);
+        if (changed)
+            rev_ = ++revSeq_;
+        return changed;
+    }
+
+    // Recompile track t alone if it changed (a live edit at a boundary, whatever
+    // else is waiting for the budgeted build()); returns true if it did
+    bool buildTrack(const Pattern &p, uint8_t t, const TakeStack *takes = nullptr)
+    {
+        if (t >= count_ || t >= p.trackCount)
+            return false;
+        TrackTimeline &dst = tracks_[t];
+        const Track &src = p.tracks[t];
+        const uint32_t len = p.trackPlayTicks(t) ? p.trackPlayTicks(t) : 1u;
+        if (!dirty(dst, src, len, gridOf(p), p.groove, takeRev(takes, t)))
+            return false;
+        compile(dst, src, len, gridOf(p), p.groove, takes, t);
+        rev_ = ++revSeq_;
+        return true;
+    }
+
+    // Release every compiled track back to the note pool
+    void clear()
+    {
+        for (uint8_t t = 0; t < MAX_TRACKS; ++t)
+        {
+            tracks_[t].ev.clear();
+            tracks_[t].built = false;
+        }
+        count_ = 0;
+        muted_ = 0;
+        rev_ = ++revSeq_;
+    }
+
+    uint8_t count() const { return count_; }
+    // Bit t set: track t is muted (Track::mute)
+    uint16_t muted() const { return muted_; }
+    const TrackTimeline &track(uint8_t t) const { return tracks_[t]; }
+    // Changes on every rebuild and is unique across Timeline instances, so
+    // PlaybackEngine also re-seeks when handed a different (swapped-in) timeline
+    uint32_t rev() const { return rev_; }
+    // Notes that did not fit in the pool during compilation
+    uint32_t overflow() const { return overflow_; }
+
+private:
+    TrackTimeline tracks_[MAX_TRACKS];
+    uint8_t count_{0};
+    uint16_t muted_{0};
+    uint32_t rev_{0};
+    uint32_t overflow_{0};
+    static inline uint32_t revSeq_{0};
+
+    // Sort scratch: indices into the source store (stable index sort up to this size)
+    static constexpr uint16_t SORT_SCRATCH = 2048;
+    static inline uint16_t order_[SORT_SCRATCH];
+
+    static bool dirty(const TrackTimeline &dst, const Track &src, uint32_t len, uint32_t grid, const Groove &g,
+                      uint32_t takeRev)
+    {
+        return !dst.built || dst.srcRev != src.notes.rev() || dst.len != len || dst.div != divOf(src) ||
+               dst.ch != src.channel || dst.grooveRev != g.rev() || dst.takeRev != takeRev ||
+               (src.quant.active() && dst.grid != grid) || dst.quant != src.quant;
+    }
+    static uint32_t takeRev(const TakeStack *takes, uint8_t t) { return takes ? takes->rev(t) : 0; }
+    static uint32_t gridOf(const Pattern &p) { return timebase::ticksPerStep(p.grid); }
+
+    static uint16_t muteMask(const Pattern &p)
+    {
+        uint16_t m = 0;
+        for (uint8_t t = 0; t < p.trackCount; ++t)
+            m |= (uint16_t)(p.tracks[t].mute ? 1u << t : 0);
+        return m;
+    }
+
+    static uint8_t divOf(const Track &t) { return t.clockDiv ? t.clockDiv : 1; }
+
+    // How a track's notes land on the transport timeline
+    struct Shape
+    {
+        uint8_t div;
+        uint32_t len;  // transport ticks
+        uint32_t grid; // note ticks
+        Quantize quant;
+        const Groove &g;
+    };
+
+    // Stretch by the clock divisor (micro_q8 too: stored in 1/256 note tick),
+    // quantize, then apply the groove; false if the note starts beyond the
+    // track's own length (never reached)
+    static bool place(Note &x, const Shape &s)
+    {
+        const uint8_t div = s.div;
+        if ((uint64_t)x.on * div >= s.len)
+            return false;
+        x.duration *= div;
+        if (!s.g.active() && !s.quant.active() && (div == 1 || !x.micro_q8))
+        {
+            x.on *= div;
+            return true;
+        }
+        const int64_t loop = (int64_t)s.len << 8;
+        int64_t q = ((int64_t)x.on << 8) * div + (int64_t)x.micro_q8 * div; // 1/256 transport tick
+        if (s.quant.active() && s.grid)
+        {
+            const int64_t step = (int64_t)s.grid * div << 8;
+            const int64_t d = (q + step / 2) / step * step - q;
+            if ((d < 0 ? -d : d) * 200 <= step * s.quant.window)
+                q += d * s.quant.strength / 100;
+        }
+        if (s.g.active())
+        {
+            q = (q % loop + loop) % loop;
+            const uint8_t k = s.g.position((uint32_t)(((q + 128) >> 8) / div));
+            q += (int32_t)s.g.shift_q8[k] * div;
+            const int v = x.vel + s.g.vel[k];
+            x.vel = (uint8_t)(v < 1 ? 1 : (v > 127 ? 127 : v));
+        }
+        q = (q % loop + loop) % loop; // pushed past either end: wraps within the loop
+        const int64_t on = (q + 128) >> 8;
+        x.micro_q8 = (int16_t)(q - (on << 8)); // -128..127
+        x.on = on >= s.len ? 0 : (uint32_t)on;
+        return true;
+    }
+
+    void emit(TrackTimeline &dst, Note x, const Shape &s)
+    {
+        if (!place(x, s))
+            return;
+        if (!dst.ev.push_back(x))
+            overflow_++;
+        else if (x.duration > dst.maxDur)
+            dst.maxDur = x.duration;
+    }
+
+    // In-place heapsort by start tick (ties in no particular order); no scratch
+    static void heapSort(NoteStore &ev)
+    {
+        const size_t n = ev.size();
+        auto sift = [&](size_t root, size_t end)
+        {
+            const Note x = ev.get(root);
+            for (size_t c; (c = 2 * root + 1) < end; root = c)
+            {
+                if (c + 1 < end && ev.onAt(c + 1) > ev.onAt(c))
+                    c++;
+                if (ev.onAt(c) <= x.on)
+                    break;
+                ev.set(root, ev.get(c));
+            }
+            ev.set(root, x);
+        };
+        for (size_t i = n / 2; i-- > 0;)
+            sift(i, n);
+        for (size_t end = n; end-- > 1;)
+        {
+            const Note top = ev.get(0);
+            ev.set(0, ev.get(end));
+            ev.set(end, top);
+            sift(0, end);
+        }
+    }
+
+    void compile(TrackTimeline &dst, const Track &src, uint32_t len, uint32_t grid, const Groove &g,
+                 const TakeStack *takes, uint8_t t)
+    {
+        const uint8_t div = divOf(src);
+        const Shape shape{div, len, grid, src.quant, g};
+        dst.ev.clear();
+        dst.maxDur = 0;
+        const NoteStore &ns = src.notes;
+        const size_t n = ns.size();
+        // Compiled start of source note i (quantized or grooved notes can change order or wrap)
+        auto key = [&](size_t i) -> uint32_t
+        {
+            if (!g.active() && !src.quant.active() && div == 1)
+                return ns.onAt(i);
+            Note x = ns.get(i);
+            return place(x, shape) ? x.on : UINT32_MAX;
+        };
+        bool sorted = true;
+        for (size_t i = 1; i < n && sorted; ++i)
+            sorted = key(i - 1) <= key(i);
+        if (sorted || n > SORT_SCRATCH)
+        {
+            // Recorded and imported tracks are mostly in order already; long
+            // unsorted ones are sorted in place once copied
+            for (auto it = ns.begin(); it != ns.end(); ++it)
+                emit(dst, *it, shape);
+            if (!sorted)
+                heapSort(dst.ev);
+        }
+        else
+        {
+            for (uint16_t i = 0; i < n; ++i)
+                order_[i] = i;
+            std::sort(order_, order_ + n, [&](uint16_t a, uint16_t b)
+                      {
+                          uint32_t ta = key(a), tb = key(b);
+                          return ta < tb || (ta == tb && a < b);
+                      });
+            for (uint16_t i = 0; i < n; ++i)
+                emit(dst, ns.get(order_[i]), shape);
+        }
+        // Active takes go after the notes; one sort if they interleave
+        if (takes && takes->any(t))
+        {
+            takes->forEachActive(t, [&](const Note &x) { emit(dst, x, shape); });
+            bool inOrder = true;
+            for (size_t i = 1; i < dst.ev.size() && inOrder; ++i)
+                inOrder = dst.ev.onAt(i - 1) <= dst.ev.onAt(i);
+            if (!inOrder)
+                heapSort(dst.ev);
+        }
+        dst.len = len;
+        dst.div = div;
+        dst.ch = src.channel;
+        dst.mute = src.mute;
+        dst.srcRev = ns.rev();
+        dst.grooveRev = g.rev();
+        dst.takeRev = takeRev(takes, t);
+        dst.grid = grid;
+        dst.quant = src.quant;
+        dst.built = true;
+    }
+};
@@ -97,6 +97,11 @@ public:
             if (!pcf_.read(pins)) {
                 continue;
             }
+            // An edge seen now happened at some point since this row's previous
+            // read: stamp it halfway (unbiased, error within half a scan period)
+            const uint32_t readUs = micros();
+            const uint32_t edgeUs = rowReadUs_[r] ? readUs - (readUs - rowReadUs_[r]) / 2 : readUs;
+            rowReadUs_[r] = readUs;
             
             // Process each column
             for (uint8_t c = 0; c < 8; c++)
@@ -133,11 +138,11 @@ public:
                 // Musical keys
                 if (down)
                 {
-                    noteOn(btn, midi, ch, lastPitchOpt);
+                    noteOn(btn, midi, ch, edgeUs, lastPitchOpt);
                 }
                 else
                 {
-                    noteOff(btn, midi, ch);
+                    noteOff(btn, midi, ch, edgeUs);
                 }
             }
         }
@@ -150,6 +155,7 @@ private:
     PCF8575 pcf_;
     Config cfg_;
     uint32_t lastScanUs_{0};
+    uint32_t rowReadUs_[3]{}; // last column read per row, for edge timestamps
 
     bool driveRow(uint8_t r)
     {
@@ -247,7 +253,8 @@ private:
         snprintf(buf, bufLen, "%s%d", names[n], o);
     }
 
-    void noteOn(int btn, MidiIO &midi, uint8_t ch, int *lastPitchOpt)
+    // seen: estimated micros() of the key edge, so recording does not inherit loop latency
+    void noteOn(int btn, MidiIO &midi, uint8_t ch, uint32_t seen, int *lastPitchOpt)
     {
         int p = btnToPitch(btn);
         if (p < 0)
@@ -258,13 +265,13 @@ private:
         pressed_[btn] = true;
         pitch_[btn] = p;
         midi.send({ch, (uint8_t)p, vel_, true, 0});
-        if (rec_ && tx_ && tx_->isRunning() && rec_->isArmed())
-            rec_->onLiveNoteOn((uint8_t)p, vel_, tx_->playTick());
+        if (rec_ && tx_ && tx_->isRunning() && rec_->listening())
+            rec_->onLiveNoteOn((uint8_t)p, vel_, seen);
         if (lastPitchOpt)
             *lastPitchOpt = p;
     }
 
-    void noteOff(int btn, MidiIO &midi, uint8_t ch)
+    void noteOff(int btn, MidiIO &midi, uint8_t ch, uint32_t seen)
     {
         if (!pressed_[btn])
             return;
@@ -280,7 +287,7 @@ private:
             midi.send({ch, (uint8_t)p, 0, false, 0});
         }
         if (rec_ && tx_ && rec_->isArmed())
-            rec_->onLiveNoteOff((uint8_t)p, tx_->playTick());
+            rec_->onLiveNoteOff((uint8_t)p, seen);
         pressed_[btn] = false;
         pitch_[btn] = -1;
     }
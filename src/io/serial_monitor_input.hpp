@@ -11,6 +11,51 @@
 #include "ui/views/performance_view.hpp"
 #include "ui/views/generative_view.hpp"
 #include "ui/views/view_manager.hpp"
+#include "storage/pattern_file.hpp"
+#include "storage/smf_import.hpp"
+#include "storage/stream_file.hpp"
+#include "engine/song_render.hpp"
+
+// Command letters. Every line command letter is claimed once, never by a
+// single key as well: the table checks are static_asserts, and the Enter
+// switch and viewport switch labels only compile for a registered letter.
+namespace serial_cmd
+{
+    // Open a line command (read up to Enter); one case each in the Enter switch
+    constexpr char LINE[] = "TCGLSPKXWJFUONHBIYVZM";
+    // Act at once in every view (the generative view's g n b l i r and the
+    // performance view's S prefix take over G L N B I S only there)
+    constexpr char KEYS[] = "zymaAdDwsqeQE+-=_;";
+
+    constexpr bool has(const char *s, char c)
+    {
+        for (; *s; ++s)
+            if (*s == c)
+                return true;
+        return false;
+    }
+    constexpr bool unique(const char *s)
+    {
+        for (; *s; ++s)
+            if (has(s + 1, *s))
+                return false;
+        return true;
+    }
+    constexpr bool disjoint(const char *a, const char *b)
+    {
+        for (; *a; ++a)
+            if (has(b, *a))
+                return false;
+        return true;
+    }
+    static_assert(unique(LINE) && unique(KEYS), "a command letter is claimed twice");
+    static_assert(disjoint(LINE, KEYS), "a line command letter is also a single key: its line can never start");
+
+    // Not constexpr: a label for an unregistered letter is not a constant expression
+    inline char unregistered(char c) { return c; }
+    constexpr char line(char c) { return has(LINE, c) ? c : unregistered(c); }
+    constexpr char key(char c) { return has(KEYS, c) ? c : unregistered(c); }
+}
 
 // Lightweight Serial Monitor input for ghost control during development.
 // Reads single-key commands and simple line commands from USB Serial.
@@ -27,6 +72,7 @@ public:
         vm_ = vm;
         perf_ = perf;
     }
+    void attachStorage(PatternFile *file) { file_ = file; }
 
     void poll(MidiIO &midi)
     {
@@ -37,6 +83,13 @@ public:
         {
             char c = (char)Serial.read();
 
+            // Once a line command has started, everything up to Enter belongs to it
+            if (bufLen_ && c != '\r' && c != '\n')
+            {
+                appendCmd_(c);
+                continue;
+            }
+
             // Generative commands (when in generative view)
             if (vm_->getCurrentViewType() == ViewType::Generative)
             {
@@ -158,6 +211,72 @@ public:
                 Serial.println("PANIC sent (all notes off)\n");
                 continue;
             }
+            if (c == 'z' || c == 'y')
+            {
+                // Undo / redo (pattern snapshots)
+                bool ok = (c == 'z') ? rl_->undo() : rl_->redo();
+                const PatternHistory &h = rl_->history();
+                if (ok)
+                    vp_->clamp(pat_->ticks());
+                Serial.printf("%s%s (undo %u, redo %u)\n", c == 'z' ? "Undo" : "Redo", ok ? "" : ": nothing",
+                              h.undoDepth(), h.redoDepth());
+                continue;
+            }
+            if (c == 'm')
+            {
+                // Memory footprint report for note storage
+                const NoteStore &ns = pat_->selected().notes;
+                Serial.printf("Notes/1k: AoS %u B, SoA %u B, paged %u B, packed %u B\n",
+                              (unsigned)note_footprint::aos(), (unsigned)note_footprint::soa(),
+                              (unsigned)note_footprint::paged(), (unsigned)note_footprint::packed());
+                Serial.printf("Track %u: %u notes, cap %u, %u B\n", pat_->sel + 1,
+                              (unsigned)ns.size(), (unsigned)ns.capacity(), (unsigned)ns.bytes());
+                size_t total = 0, tlBytes = 0;
+                for (uint8_t t = 0; t < pat_->trackCount; ++t)
+                    total += pat_->tracks[t].notes.size();
+                const Timeline &tl = rl_->timeline();
+                for (uint8_t t = 0; t < tl.count(); ++t)
+                    tlBytes += tl.track(t).ev.bytes();
+                Serial.printf("Pattern: %u tracks, %u notes; timeline %u B (overflow %lu); mute %04X solo %04X playing %04X\n",
+                              pat_->trackCount, (unsigned)total, (unsigned)tlBytes,
+                              (unsigned long)tl.overflow(), tl.muted(), rl_->engine()->solo(),
+                              rl_->engine()->audible());
+                const PlaybackEngine &eng = *rl_->engine();
+                Serial.printf("Ratchets: %u rolling, %lu repeats dropped (budget), %lu notes unrolled (full)\n",
+                              eng.rolling(), (unsigned long)eng.ratchetDropped(), (unsigned long)eng.rollOverflow());
+                if (const NotePool *np = ns.pool())
+                {
+                    const NotePool::Stats &st = np->stats();
+                    Serial.printf("Pool %s: %u/%u pages (peak %u), %u KB, allocs %lu frees %lu fails %lu\n",
+                                  memRegionName(np->region()), st.used, st.total, st.peak,
+                                  (unsigned)(np->bytes() / 1024), (unsigned long)st.allocs,
+                                  (unsigned long)st.frees, (unsigned long)st.failures);
+                }
+                const PatternSwap &sw = rl_->swapper();
+                const PatternSwap::Stats &ss = sw.stats();
+                Serial.printf("Swap @%s%s: %lu done, wait %lu/%lu ticks, flip %lu/%lu us, offs carried %u (total %lu), refused ons %lu, stage fails %lu\n",
+                              swapQuantName(sw.quant()), sw.pending() ? " (pending)" : "",
+                              (unsigned long)ss.swaps, (unsigned long)ss.lastWait, (unsigned long)ss.maxWait,
+                              (unsigned long)ss.lastUs, (unsigned long)ss.maxUs, ss.carried,
+                              (unsigned long)ss.carriedTotal, (unsigned long)rl_->engine()->offOverflow(),
+                              (unsigned long)ss.failed);
+                const PatternHistory &h = rl_->history();
+                Serial.printf("History: undo %u, redo %u, evicted %lu\n", h.undoDepth(), h.redoDepth(),
+                              (unsigned long)h.evictions());
+                StreamPlayer &sp = rl_->stream();
+                if (sp.isOpen())
+                {
+                    const StreamPlayer::Stats &st = sp.stats();
+                    Serial.printf("Stream: %u blocks buffered, lead %lu (min %lu) ticks, read %lu, underruns %lu, "
+                                  "resyncs %lu, dropped %lu, locates %lu, errors %lu\n",
+                                  sp.buffered(), (unsigned long)sp.lead(tx_->playTick()),
+                                  (unsigned long)(st.minLead == UINT32_MAX ? 0 : st.minLead),
+                                  (unsigned long)st.blocksRead, (unsigned long)st.underruns,
+                                  (unsigned long)st.resyncs, (unsigned long)st.dropped,
+                                  (unsigned long)st.locates, (unsigned long)st.readErrors);
+                }
+                continue;
+            }
 
             // Scale and fold quick commands
             // Two-character commands with a tolerant entry model:
@@ -229,41 +348,41 @@ public:
             uint32_t stepT = timebase::ticksPerStep(pat_->grid);
             switch (c)
             {
-            case 'a':
+            case serial_cmd::key('a'):
                 vp_->pan_ticks(-(int32_t)stepT, pat_->ticks());
                 continue;
-            case 'A':
+            case serial_cmd::key('A'):
                 vp_->pan_ticks(-(int32_t)(stepT * 4), pat_->ticks());
                 continue;
-            case 'd':
+            case serial_cmd::key('d'):
                 vp_->pan_ticks((int32_t)stepT, pat_->ticks());
                 continue;
-            case 'D':
+            case serial_cmd::key('D'):
                 vp_->pan_ticks((int32_t)(stepT * 4), pat_->ticks());
                 continue;
-            case 'w':
+            case serial_cmd::key('w'):
                 vp_->zoom_ticks(2.0f, pat_->ticks());
                 continue;
-            case 's':
+            case serial_cmd::key('s'):
                 vp_->zoom_ticks(0.5f, pat_->ticks());
                 continue;
-            case 'q':
+            case serial_cmd::key('q'):
                 vp_->pan_pitch(-1);
                 continue;
-            case 'e':
+            case serial_cmd::key('e'):
                 vp_->pan_pitch(+1);
                 continue;
-            case 'Q':
+            case serial_cmd::key('Q'):
                 vp_->pan_pitch(-12);
                 continue;
-            case 'E':
+            case serial_cmd::key('E'):
                 vp_->pan_pitch(+12);
                 continue;
             default:
                 break;
             }
 
-            // Line-based commands: T<float>, C<int>, G<int>, L<uint>
+            // Line-based commands (letters in serial_cmd::LINE): one case each below, argument up to Enter
             if (c == '\r' || c == '\n')
             {
                 if (bufLen_)
@@ -272,7 +391,7 @@ public:
                     char op = cmdBuf_[0];
                     switch (op)
                     {
-                    case 'T':
+                    case serial_cmd::line('T'):
                     {
                         float bpm = atof(cmdBuf_ + 1);
                         if (bpm >= 20 && bpm <= 300)
@@ -287,12 +406,12 @@ public:
                         }
                     }
                     break;
-                    case 'C':
+                    case serial_cmd::line('C'):
                     {
                         int ch = atoi(cmdBuf_ + 1);
                         if (ch >= 1 && ch <= 16)
                         {
-                            pat_->track.channel = (uint8_t)ch;
+                            pat_->selected().channel = (uint8_t)ch;
                             perf_->state().channel = (uint8_t)ch;
                             Serial.printf("Channel=%d\n", ch);
                         }
@@ -302,33 +421,151 @@ public:
                         }
                     }
                     break;
-                    case 'G': // steps
+                    case serial_cmd::line('G'): // steps
                     {
-                        uint16_t steps = (uint16_t)atoi(cmdBuf_ + 1);
-                        if (steps > 0 && steps <= 256)
+                        char *end = nullptr;
+                        unsigned long steps = strtoul(cmdBuf_ + 1, &end, 10);
+                        if (end != cmdBuf_ + 1 && !*end && steps > 0 && steps <= Pattern::MAX_STEPS)
                         {
-                            pat_->steps = steps;
+                            rl_->history().checkpoint();
+                            pat_->steps = (uint32_t)steps;
                             tx_->setLoopLen(pat_->ticks());
                             vp_->clamp(pat_->ticks());
-                            Serial.printf("Steps=%u (ticks=%lu)\n", steps, (unsigned long)pat_->ticks());
+                            Serial.printf("Steps=%lu (ticks=%lu)\n", steps, (unsigned long)pat_->ticks());
+                        }
+                        else
+                        {
+                            Serial.printf("ERR steps 1..%lu\n", (unsigned long)Pattern::MAX_STEPS);
+                        }
+                    }
+                    break;
+                    case serial_cmd::line('K'): // select track (1-16), adding tracks up to it
+                    {
+                        int t = atoi(cmdBuf_ + 1);
+                        if (t >= 1 && t <= Pattern::MAX_TRACKS && pat_->select((uint8_t)(t - 1)))
+                        {
+                            perf_->state().channel = pat_->selected().channel;
+                            Serial.printf("Track=%d/%u ch%u\n", t, pat_->trackCount, pat_->selected().channel);
+                        }
+                        else
+                        {
+                            Serial.println("ERR track 1..16");
+                        }
+                    }
+                    break;
+                    case serial_cmd::line('U'): // mute toggle: U<track 1-16>
+                    case serial_cmd::line('O'): // solo toggle: O<track 1-16>, O0 clears all solos
+                    {
+                        int t = atoi(cmdBuf_ + 1);
+                        const bool solo = op == 'O';
+                        if (t >= 1 && t <= Pattern::MAX_TRACKS)
+                        {
+                            rl_->post(AppEvent{solo ? AppEvent::Type::Solo : AppEvent::Type::Mute, (uint8_t)(t - 1)});
+                            Serial.printf("Track %d %s=%s\n", t, solo ? "solo" : "mute",
+                                          (solo ? (rl_->engine()->solo() >> (t - 1)) & 1 : pat_->tracks[t - 1].mute) ? "OFF" : "ON");
+                        }
+                        else if (solo && t == 0)
+                        {
+                            rl_->post(AppEvent{AppEvent::Type::Solo, AppEvent::ALL});
+                            Serial.println("Solo cleared");
+                        }
+                        else
+                        {
+                            Serial.printf("ERR %c<track 1..16>\n", op);
+                        }
+                    }
+                    break;
+                    case serial_cmd::line('X'): // selected track length: X<steps>[ <div>], X0 follows the pattern
+                    {
+                        char *end = nullptr;
+                        unsigned long steps = strtoul(cmdBuf_ + 1, &end, 10);
+                        unsigned long div = (end && *end) ? strtoul(end, nullptr, 10) : 1;
+                        if (steps <= Pattern::MAX_STEPS && div >= 1 && div <= 16)
+                        {
+                            rl_->history().checkpoint();
+                            Track &trk = pat_->selected();
+                            trk.steps = (uint32_t)steps;
+                            trk.clockDiv = (uint8_t)div;
+                            Serial.printf("Track %u: steps=%lu div=%lu (loop=%lu ticks)\n", pat_->sel + 1,
+                                          (unsigned long)pat_->trackSteps(pat_->sel), div,
+                                          (unsigned long)pat_->trackPlayTicks(pat_->sel));
                         }
                         else
                         {
-                            Serial.println("ERR steps 1..256");
+                            Serial.printf("ERR X<steps 0..%lu>[ <div 1..16>]\n", (unsigned long)Pattern::MAX_STEPS);
                         }
                     }
                     break;
+                    case serial_cmd::line('W'): // pattern swap quantization: W0 now, W1 beat, W2 bar, W3 loop
+                    {
+                        int q = atoi(cmdBuf_ + 1);
+                        if (cmdBuf_[1] && q >= 0 && q <= 3)
+                        {
+                            rl_->swapper().setQuant((SwapQuant)q);
+                            Serial.printf("Swap at %s\n", swapQuantName((SwapQuant)q));
+                        }
+                        else
+                        {
+                            Serial.println("ERR W0..3 (now/beat/bar/loop)");
+                        }
+                    }
+                    break;
+                    case serial_cmd::line('J'): // song: J list, JS<slot> store, JL<slot> load, JA<slot> <reps> append, JC clear, JP<entry> play, JO off, JR<name> render
+                        songCommand(cmdBuf_[1], cmdBuf_ + 2);
+                        break;
+                    case serial_cmd::line('N'): // trigs: N<prob %>[ <cond>] on the selected track, NF fill toggle, NS<seed>
+                        trigCommand(cmdBuf_ + 1);
+                        break;
+                    case serial_cmd::line('B'): // ratchets: B<hits 1..8>[ <rate 0..3>[ U|D]] on the selected track, B1 off
+                        ratchetCommand(cmdBuf_ + 1);
+                        break;
+                    case serial_cmd::line('I'): // quantize the selected track when compiled: I<strength %>[ <window %>], I0 as played
+                    {
+                        char *end = nullptr;
+                        unsigned long str = strtoul(cmdBuf_ + 1, &end, 10);
+                        unsigned long win = (end && *end) ? strtoul(end, &end, 10) : 100;
+                        if (end != cmdBuf_ + 1 && !*end && str <= 100 && win >= 1 && win <= 100)
+                        {
+                            rl_->history().checkpoint();
+                            pat_->selected().quant = Quantize{(uint8_t)str, (uint8_t)win};
+                            Serial.printf("Track %u quantize %lu%% within %lu%% of a step\n", pat_->sel + 1, str, win);
+                        }
+                        else
+                        {
+                            Serial.println("ERR I<strength 0..100>[ <window 1..100>]");
+                        }
+                    }
+                    break;
+                    case serial_cmd::line('Y'): // input latency: Y report, YC[<taps>] tap-along calibration (keys), YS<us> set, YX cancel
+                        latencyCommand(cmdBuf_[1], cmdBuf_ + 2);
+                        break;
+                    case serial_cmd::line('V'): // loop takes: V list, VR loop-take recording on/off, VS stacking on/off, VA<n> audition, VT<n> toggle, VC<n> <from> <to> comp steps into the track, VM merge active takes, VX[<n>] delete
+                        takeCommand(cmdBuf_[1], cmdBuf_ + 2);
+                        break;
+                    case serial_cmd::line('Z'): // evolve: Z report, ZE[<bars>] evolve the selected track every <bars> bars (0 = each loop), ZX off, ZA<swaps> <drifts> <semitones> <rerolls> <vel range>, ZC<us> slice cap
+                        evolveCommand(cmdBuf_[1], cmdBuf_ + 2);
+                        break;
+                    case serial_cmd::line('M'): // generator result cache (memo): M stats, MB<bytes> budget, MC clear, MO on/off
+                        cacheCommand(cmdBuf_[1], cmdBuf_ + 2);
+                        break;
+                    case serial_cmd::line('H'): // groove: H<swing %>[ <grid 8|16|32>], H50 straight, HX[<steps>] from the selected track
+                        grooveCommand(cmdBuf_ + 1);
+                        break;
+                    case serial_cmd::line('F'): // pattern file: F status, FS<slot> save, FL<slot> load, FP compact, FM<name> import /<name> (.mid), FO<name> stream, FC close stream
+                        fileCommand(cmdBuf_[1], cmdBuf_ + 2);
+                        break;
                     // Description: Move playhead to specified tick position.
                     // Note: no range check; user is responsible to provide valid tick within pattern length
                     // (pattern length can be queried with 'G' command)
-                    case 'L':
+                    case serial_cmd::line('L'):
                     {
                         uint32_t t = strtoul(cmdBuf_ + 1, nullptr, 10);
                         tx_->locate(t);
+                        rl_->stream().locate(tx_->playTick()); // seek the card here, not in the next tick
                         Serial.printf("Locate=%lu\n", (unsigned long)t);
                     }
                     break;
-                    case 'P':
+                    case serial_cmd::line('P'):
                     {
                         // Handle "set param value" commands for generative view
                         // Format: P<paramname> <value>
@@ -345,21 +582,16 @@ public:
                             GenerativeView *genView = static_cast<GenerativeView *>(vm_->getCurrentView());
                             if (genView)
                             {
-                                // Parse "P<paramname> <value>" format
-                                String cmd(cmdBuf_);
-                                int spaceIndex = cmd.indexOf(' ');
-                                if (spaceIndex > 1)
+                                // Parse "P<paramname> <value>" in place (hashed name lookup)
+                                char *space = strchr(cmdBuf_, ' ');
+                                if (space && space > cmdBuf_ + 1)
                                 {
-                                    String paramName = cmd.substring(1, spaceIndex);
-                                    float value = cmd.substring(spaceIndex + 1).toFloat();
+                                    *space = '\0';
+                                    const char *paramName = cmdBuf_ + 1;
+                                    float value = strtof(space + 1, nullptr);
 
-                                    if (genView->getGeneratorManager().setParameter(paramName.c_str(), value))
+                                    if (!genView->getGeneratorManager().setParameter(paramName, value))
                                     {
-                                        Serial.printf("Set %s = %.2f\n", paramName.c_str(), value);
-                                    }
-                                    else
-                                    {
-                                        Serial.printf("Unknown parameter: %s\n", paramName.c_str());
                                         Serial.println("Use 'i' to see available parameters");
                                     }
                                 }
@@ -387,28 +619,639 @@ public:
                 continue;
             }
 
-            // Start/append numeric command buffer
-            if (bufLen_ == 0)
+            // Start a line command buffer
+            if (isLineCmd_(c))
+                cmdBuf_[bufLen_++] = c;
+        }
+    }
+
+private:
+    static bool isDigit_(char c) { return c >= '0' && c <= '9'; }
+    static bool isLineCmd_(char c) { return c && serial_cmd::has(serial_cmd::LINE, c); }
+
+    void appendCmd_(char c)
+    {
+        if (isDigit_(c) || c == '.' || c == '-' || c == ' ' || c == ':' || c == '!' ||
+            (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+        {
+            if (bufLen_ < (int)sizeof(cmdBuf_) - 1)
+                cmdBuf_[bufLen_++] = c;
+        }
+        else
+        {
+            // invalid char → reset buffer
+            bufLen_ = 0;
+        }
+    }
+
+    // Pattern file commands (line command F)
+    void fileCommand(char sub, const char *arg)
+    {
+        switch (sub)
+        {
+        case 'M':
+            importMidi(arg);
+            return;
+        case 'O':
+            openStream(arg);
+            return;
+        case 'C':
+            rl_->closeStream();
+            Serial.println("Stream closed");
+            return;
+        default:
+            break;
+        }
+        if (!file_)
+        {
+            Serial.println("ERR no pattern file");
+            return;
+        }
+        unsigned long slot = strtoul(arg, nullptr, 10);
+        switch (sub)
+        {
+        case 'S':
+            if (file_->saveBegin((uint16_t)slot, *pat_))
+                Serial.printf("Saving slot %lu in the background\n", slot);
+            else
+                Serial.println("ERR slot, save in progress or note pool");
+            return;
+        case 'L':
+        {
+            // Load into the swap back buffer so playback switches at the boundary
+            PatternSwap &sw = rl_->swapper();
+            uint32_t t0 = micros();
+            Pattern *back = file_->used((uint16_t)slot) ? sw.stage() : nullptr;
+            if (back && file_->load((uint16_t)slot, *back))
             {
-                if (c == 'T' || c == 'C' || c == 'G' || c == 'L' || c == 'S' || c == 'P')
-                    cmdBuf_[bufLen_++] = c;
+                rl_->history().checkpoint();
+                sw.commit();
+                Serial.printf("Loaded slot %lu in %lu us (%u notes), swap at %s\n", slot,
+                              (unsigned long)(micros() - t0), file_->entry((uint16_t)slot).notes,
+                              swapQuantName(sw.quant()));
             }
-            else if (isDigit_(c) || c == '.' || c == '-' || c == ' ' ||
-                     (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+            else
             {
-                if (bufLen_ < (int)sizeof(cmdBuf_) - 1)
-                    cmdBuf_[bufLen_++] = c;
+                if (back)
+                    sw.cancel();
+                Serial.println("ERR empty slot, pending swap or read error");
             }
+            return;
+        }
+        case 'P':
+            if (file_->compactBegin())
+                Serial.printf("Compacting %lu KB of dead records in the background\n",
+                              (unsigned long)(file_->deadBytes() / 1024));
             else
+                Serial.println("ERR save or compaction in progress");
+            return;
+        default:
+            break;
+        }
+        const PatternFile::Stats &st = file_->stats();
+        uint16_t used = 0;
+        for (uint16_t i = 0; i < file_->slots(); ++i)
+            used += file_->used(i);
+        Serial.printf("File: %u/%u slots, %lu KB (%lu KB dead), %s; loads %lu saves %lu compactions %lu fails %lu\n",
+                      used, file_->slots(), (unsigned long)(file_->fileEnd() / 1024),
+                      (unsigned long)(file_->deadBytes() / 1024),
+                      file_->compacting() ? "compacting" : file_->busy() ? "saving" : "idle", (unsigned long)st.loads,
+                      (unsigned long)st.saves, (unsigned long)st.compactions, (unsigned long)st.failures);
+    }
+
+    // Stream a song-length file from the card root (see StreamPlayer)
+    void openStream(const char *name)
+    {
+        char path[sizeof(cmdBuf_) + 1];
+        snprintf(path, sizeof(path), "/%s", name);
+        if (!*name || !rl_->openStream(path))
+        {
+            Serial.println("ERR FO<file name>: missing or not a stream file");
+            return;
+        }
+        const StreamPlayer &sp = rl_->stream();
+        Serial.printf("Streaming %s: %lu events, %lu blocks, %lu bars\n", path, (unsigned long)sp.events(),
+                      (unsigned long)sp.blocks(), (unsigned long)(sp.length() / (4 * 96)));
+    }
+
+    // Import a Standard MIDI File from the card root through the swap back buffer
+    void importMidi(const char *name)
+    {
+        if (!*name)
+        {
+            Serial.println("Usage: FM<file name>");
+            return;
+        }
+        char path[sizeof(cmdBuf_) + 1];
+        snprintf(path, sizeof(path), "/%s", name);
+        PatternSwap &sw = rl_->swapper();
+        Pattern *back = sw.stage();
+        if (!back)
+        {
+            Serial.println("ERR pending swap or note pool");
+            return;
+        }
+        uint32_t t0 = micros();
+        SmfImporter::Result r = smf_.import(path, *back);
+        uint32_t us = micros() - t0;
+        if (r.error)
+        {
+            sw.cancel();
+            Serial.printf("ERR %s: %s\n", path, r.error);
+            return;
+        }
+        rl_->history().checkpoint();
+        sw.commit();
+        Serial.printf("Imported %s (type %u, %u chunks, %u ppq) in %lu us: %lu events, %lu notes on %u tracks, "
+                      "%lu dropped, %lu unmatched; swap at %s\n",
+                      path, r.format, r.chunks, r.division, (unsigned long)us, (unsigned long)r.events,
+                      (unsigned long)r.notes, back->trackCount, (unsigned long)r.dropped,
+                      (unsigned long)r.unmatched, swapQuantName(sw.quant()));
+    }
+
+    // Song chain commands (line command J)
+    void songCommand(char sub, const char *arg)
+    {
+        SongPlayer &sp = rl_->song();
+        PatternBank *bank = sp.bank();
+        Song *song = sp.chain();
+        if (!bank || !song)
+            return;
+        char *end = nullptr;
+        unsigned long a = strtoul(arg, &end, 10);
+        switch (sub)
+        {
+        case 'S': // live pattern → bank slot
+            if (a < PatternBank::SIZE && bank->slots[a].assign(*pat_))
+                Serial.printf("Stored pattern in slot %lu\n", a);
+            else
+                Serial.println("ERR slot or note pool");
+            return;
+        case 'L': // bank slot → live, through the pattern swap
+        {
+            Pattern *back = (a < PatternBank::SIZE) ? rl_->swapper().stage(bank->slots[a]) : nullptr;
+            if (back)
             {
-                // invalid char → reset buffer
-                bufLen_ = 0;
+                rl_->history().checkpoint();
+                rl_->swapper().commit();
+                Serial.printf("Slot %lu queued (%s)\n", a, swapQuantName(rl_->swapper().quant()));
             }
+            else
+                Serial.println("ERR slot, pending swap or note pool");
+            return;
+        }
+        case 'A':
+        {
+            unsigned long reps = (end && *end) ? strtoul(end, nullptr, 10) : 1;
+            if (a < PatternBank::SIZE && reps <= 255 && song->append((uint8_t)a, (uint8_t)reps))
+                Serial.printf("Chain %u: slot %lu x%lu\n", song->length, a, reps ? reps : 1);
+            else
+                Serial.println("ERR JA<slot> <reps 1..255>, chain full?");
+            return;
         }
+        case 'C':
+            sp.stop(rl_->swapper());
+            song->clear();
+            Serial.println("Chain cleared");
+            return;
+        case 'P':
+            if (sp.start((uint8_t)a, rl_->swapper()))
+                Serial.printf("Song from entry %lu%s\n", a, tx_->isRunning() ? " at next wrap" : "");
+            else
+                Serial.println("ERR entry (chain empty?)");
+            return;
+        case 'O':
+            sp.stop(rl_->swapper());
+            Serial.println("Song off");
+            return;
+        case 'R': // render the chain to a stream file: JR<name>
+        {
+            if (tx_->isRunning() || !*arg)
+            {
+                Serial.println("ERR JR<file name>, transport stopped");
+                return;
+            }
+            char path[sizeof(cmdBuf_) + 1];
+            snprintf(path, sizeof(path), "/%s", arg);
+            StreamWriter w;
+            uint32_t t0 = millis();
+            uint32_t len = w.open(path) ? renderSong(*song, *bank, w, rl_->engine()->seed()) : 0;
+            if (len)
+                Serial.printf("Rendered %s: %lu events, %lu bars in %lu ms\n", path, (unsigned long)w.events(),
+                              (unsigned long)(len / (4 * 96)), (unsigned long)(millis() - t0));
+            else
+                Serial.println("ERR render (empty chain or write error)");
+            return;
+        }
+        default:
+            break;
+        }
+        uint32_t bars, beats, ticks;
+        tx_->songPos(bars, beats, ticks);
+        Serial.printf("Song %s, entry %u pass %u, pos %lu:%lu:%lu, late %lu\n", sp.active() ? "on" : "off",
+                      sp.entry() + 1, sp.pass() + 1, (unsigned long)bars + 1, (unsigned long)beats + 1,
+                      (unsigned long)ticks, (unsigned long)sp.late());
+        for (uint8_t i = 0; i < song->length; ++i)
+            Serial.printf("  %c%2u: slot %u x%u\n", (sp.active() && i == sp.entry()) ? '>' : ' ', i + 1,
+                          song->chain[i].pat, song->chain[i].repeats);
     }
 
-private:
-    static bool isDigit_(char c) { return c >= '0' && c <= '9'; }
+    // Trig commands (line command N): probability/condition for every note of the selected track
+    void trigCommand(const char *arg)
+    {
+        if (*arg == 'F')
+        {
+            const bool on = !rl_->engine()->fill();
+            rl_->post(AppEvent{AppEvent::Type::Fill, (uint8_t)on});
+            Serial.printf("Fill %s\n", on ? "ON" : "OFF");
+            return;
+        }
+        if (*arg == 'S')
+        {
+            uint32_t seed = strtoul(arg + 1, nullptr, 10);
+            rl_->setTrigSeed(seed);
+            Serial.printf("Trig seed %lu (from next start/locate)\n", (unsigned long)seed);
+            return;
+        }
+        char *end = nullptr;
+        unsigned long prob = strtoul(arg, &end, 10);
+        while (end && *end == ' ')
+            end++;
+        uint8_t cond = trig::Always;
+        bool okCond = true;
+        unsigned a = 0, b = 0;
+        if (!end || !*end || !strcmp(end, "-"))
+            cond = trig::Always;
+        else if (!strcmp(end, "F"))
+            cond = trig::Fill;
+        else if (!strcmp(end, "!F"))
+            cond = trig::NotFill;
+        else if (!strcmp(end, "1ST"))
+            cond = trig::First;
+        else if (!strcmp(end, "!1ST"))
+            cond = trig::NotFirst;
+        else if (sscanf(end, "%u:%u", &a, &b) == 2 && a >= 1 && a <= b && b <= 8)
+            cond = trig::every((uint8_t)a, (uint8_t)b);
+        else
+            okCond = false;
+        if (end == arg || prob > 100 || !okCond)
+        {
+            Serial.println("ERR N<prob 0..100>[ A:B|F|!F|1ST|!1ST|-], NF, NS<seed>");
+            return;
+        }
+        rl_->history().checkpoint();
+        NoteStore &ns = pat_->selected().notes;
+        size_t changed = 0;
+        for (size_t i = 0; i < ns.size(); ++i)
+        {
+            Note n = ns.get(i);
+            n.skip = (uint8_t)(100 - prob);
+            n.cond = cond;
+            changed += ns.set(i, n);
+        }
+        Serial.printf("Track %u: %u notes at %lu%% %s\n", pat_->sel + 1, (unsigned)changed, prob, *end ? end : "-");
+    }
+
+    // Ratchet commands (line command B): hits, rate (0 split, 1..3 = 1/32..1/128) and ramp for every note of the selected track
+    void ratchetCommand(const char *arg)
+    {
+        char *end = nullptr;
+        unsigned long hits = strtoul(arg, &end, 10);
+        unsigned long rate = (end && *end) ? strtoul(end, &end, 10) : 0;
+        while (end && *end == ' ')
+            end++;
+        uint8_t ramp = ratchet::Flat;
+        if (end && *end == 'U')
+            ramp = ratchet::Up;
+        else if (end && *end == 'D')
+            ramp = ratchet::Down;
+        else if (end && *end)
+            hits = 0;
+        if (end == arg || hits < 1 || hits > ratchet::MAX_HITS || rate > 3)
+        {
+            Serial.println("ERR B<hits 1..8>[ <rate 0..3>[ U|D]]");
+            return;
+        }
+        rl_->history().checkpoint();
+        const uint8_t bits = ratchet::make((uint8_t)hits, (uint8_t)rate, ramp);
+        NoteStore &ns = pat_->selected().notes;
+        size_t changed = 0;
+        for (size_t i = 0; i < ns.size(); ++i)
+        {
+            Note n = ns.get(i);
+            n.flags = (uint8_t)((n.flags & ~NF_Ratchet) | bits);
+            changed += ns.set(i, n);
+        }
+        Serial.printf("Track %u: %u notes x%lu rate %lu%s\n", pat_->sel + 1, (unsigned)changed, hits, rate,
+                      ramp == ratchet::Up ? " up" : (ramp == ratchet::Down ? " down" : ""));
+    }
+
+    // Loop-recording takes (line command V); take numbers as listed by V, oldest first
+    void takeCommand(char op, const char *arg)
+    {
+        RecordEngine *rec = rl_->recorder();
+        if (!rec)
+        {
+            Serial.println("ERR no recorder");
+            return;
+        }
+        TakeStack &ts = rec->takes();
+        char *end = nullptr;
+        const unsigned long n = strtoul(arg, &end, 10);
+        const bool hasN = end != arg;
+        const uint8_t i = (uint8_t)(n ? n - 1 : TakeStack::NONE);
+        switch (op)
+        {
+        case 'R':
+            rec->setLoopTakes(!rec->loopTakes());
+            break;
+        case 'S':
+            ts.setStacking(!ts.stacking());
+            break;
+        case 'A':
+        case 'T':
+            if (!hasN || i >= ts.count())
+            {
+                Serial.println("ERR take number");
+                return;
+            }
+            if (op == 'A')
+                ts.audition(i);
+            else
+                ts.setActive(i, !ts.take(i).active);
+            break;
+        case 'C':
+        {
+            unsigned long from = strtoul(end, &end, 10), to = strtoul(end, nullptr, 10);
+            if (!hasN || i >= ts.count() || to <= from)
+            {
+                Serial.println("ERR VC<take> <from step> <to step>");
+                return;
+            }
+            const uint32_t step = timebase::ticksPerStep(pat_->grid);
+            rl_->history().checkpoint();
+            if (!ts.comp(i, pat_->tracks[ts.take(i).trk], from * step, to * step))
+                Serial.println("ERR note pool full");
+            break;
+        }
+        case 'M':
+            rl_->history().checkpoint();
+            if (!ts.flatten(pat_->sel, pat_->selected()))
+                Serial.println("ERR note pool full");
+            break;
+        case 'X':
+            if (hasN)
+                ts.remove(i);
+            else
+                ts.clear();
+            break;
+        case '\0':
+            break;
+        default:
+            Serial.println("ERR V, VR, VS, VA<n>, VT<n>, VC<n> <from> <to>, VM, VX[<n>]");
+            return;
+        }
+        Serial.printf("Takes: loop %s, %s, %u takes, %u/%u notes, evicted %lu, dropped %lu\n",
+                      rec->loopTakes() ? "ON" : "OFF", ts.stacking() ? "stacking" : "newest plays",
+                      ts.count(), ts.used(), TakeStack::CAP, (unsigned long)ts.evicted(), (unsigned long)ts.dropped());
+        const RecordEngine::Stats &rs = rec->stats();
+        Serial.printf("  commits %lu: last %lu us, max %lu us (cap %lu us), every %lu ms or %u notes\n",
+                      (unsigned long)rs.commits, (unsigned long)rs.lastUs, (unsigned long)rs.maxUs,
+                      (unsigned long)RecordEngine::COMMIT_CAP_US, (unsigned long)(rec->gapUs() / 1000),
+                      RecordEngine::BATCH);
+        for (uint8_t k = 0; k < ts.count(); ++k)
+        {
+            const TakeStack::Take &t = ts.take(k);
+            Serial.printf("  %u: #%u track %u, %u notes%s%s\n", k + 1, t.id, t.trk + 1, t.count,
+                          t.active ? ", playing" : "", k == ts.open() ? ", recording" : "");
+        }
+    }
+
+    // Generator result cache (line command M)
+    void cacheCommand(char op, const char *arg)
+    {
+        GenerativeView *gv = static_cast<GenerativeView *>(vm_->getView(ViewType::Generative));
+        if (!gv)
+        {
+            Serial.println("ERR no generative view");
+            return;
+        }
+        GeneratorManager &gm = gv->getGeneratorManager();
+        GenCache &cache = gm.cache();
+        switch (op)
+        {
+        case 'B':
+        {
+            char *end = nullptr;
+            unsigned long bytes = strtoul(arg, &end, 10);
+            if (end == arg || bytes > GenCache::CAP * sizeof(PackedNote))
+            {
+                Serial.printf("ERR MB<bytes 0..%lu>\n", (unsigned long)(GenCache::CAP * sizeof(PackedNote)));
+                return;
+            }
+            cache.setBudget((uint32_t)bytes);
+            break;
+        }
+        case 'C':
+            cache.clear();
+            cache.resetStats();
+            break;
+        case 'O':
+            gm.setCacheEnabled(!gm.cacheEnabled());
+            break;
+        case '\0':
+            break;
+        default:
+            Serial.println("ERR M, MB<bytes>, MC, MO");
+            return;
+        }
+        const GenCache::Stats &s = cache.stats();
+        const uint32_t looked = s.hits + s.misses;
+        Serial.printf("Generator cache %s: %u entries, %lu/%lu bytes\n", gm.cacheEnabled() ? "ON" : "OFF",
+                      cache.entries(), (unsigned long)cache.usedBytes(), (unsigned long)cache.budgetBytes());
+        Serial.printf("  hits %lu, misses %lu (%lu%% hit), stored %lu, evicted %lu, too big %lu\n",
+                      (unsigned long)s.hits, (unsigned long)s.misses,
+                      (unsigned long)(looked ? s.hits * 100 / looked : 0), (unsigned long)s.stores,
+                      (unsigned long)s.evicted, (unsigned long)s.tooBig);
+    }
+
+    // Evolve mode (line command Z): small edits to the selected track every few bars
+    void evolveCommand(char op, const char *arg)
+    {
+        Evolver &evo = rl_->evolver();
+        switch (op)
+        {
+        case 'E':
+        {
+            unsigned long bars = strtoul(arg, nullptr, 10);
+            if (bars > 0xFFFF)
+            {
+                Serial.println("ERR ZE[<bars>]");
+                return;
+            }
+            GenerativeView *gv = static_cast<GenerativeView *>(vm_->getView(ViewType::Generative));
+            rl_->history().checkpoint(); // one undo step back to before the evolving started
+            evo.setMutator(gv ? gv->getGeneratorManager().getCurrentGenerator() : nullptr);
+            evo.arm(pat_->sel, (uint16_t)bars, rl_->engine()->seed() ^ (pat_->sel + 1u) * 0x9E3779B9u);
+            break;
+        }
+        case 'X':
+            evo.disarm();
+            break;
+        case 'A':
+        {
+            unsigned long v[5];
+            const char *s = arg;
+            char *end = nullptr;
+            uint8_t k = 0;
+            for (; k < 5; ++k, s = end)
+            {
+                v[k] = strtoul(s, &end, 10);
+                if (end == s || v[k] > 127)
+                    break;
+            }
+            if (k < 5)
+            {
+                Serial.println("ERR ZA<swaps> <drifts> <semitones> <rerolls> <vel range>");
+                return;
+            }
+            evo.setAmounts(evolve::Amounts{(uint8_t)v[0], (uint8_t)v[1], (uint8_t)v[2], (uint8_t)v[3], (uint8_t)v[4]});
+            break;
+        }
+        case 'C':
+        {
+            unsigned long us = strtoul(arg, nullptr, 10);
+            if (us < 5 || us > 1000)
+            {
+                Serial.println("ERR ZC<slice cap us 5..1000>");
+                return;
+            }
+            evo.setCapUs((uint16_t)us);
+            break;
+        }
+        case '\0':
+            break;
+        default:
+            Serial.println("ERR Z, ZE[<bars>], ZX, ZA<swaps> <drifts> <semitones> <rerolls> <vel range>, ZC<us>");
+            return;
+        }
+        const evolve::Amounts &a = evo.amounts();
+        const Evolver::Stats &s = evo.stats();
+        if (evo.armed())
+        {
+            if (evo.every())
+                Serial.printf("Evolve track %u every %u bars", evo.track() + 1, evo.every());
+            else
+                Serial.printf("Evolve track %u every loop", evo.track() + 1);
+            Serial.printf(", next plan %s\n", evo.ready() ? "ready" : "in progress");
+        }
+        else
+            Serial.println("Evolve off");
+        Serial.printf("  per plan: %u swaps, %u drifts of +/-%u, %u re-rolls of +/-%u\n", a.swaps, a.drifts, a.drift,
+                      a.rerolls, a.velRange);
+        Serial.printf("  plans %lu, applied %lu (%lu notes), stale %lu, missed %lu, refused %lu (over %u notes)\n",
+                      (unsigned long)s.plans, (unsigned long)s.applied, (unsigned long)s.edits, (unsigned long)s.stale,
+                      (unsigned long)s.missed, (unsigned long)s.refused, Evolver::MAX_NOTES);
+        Serial.printf("  slices %lu: last %lu us, max %lu us (cap %u us, %u notes/slice); apply last %lu us, max %lu us\n",
+                      (unsigned long)s.slices, (unsigned long)s.lastUs, (unsigned long)s.maxUs, evo.capUs(),
+                      evo.budget(), (unsigned long)s.lastApplyUs, (unsigned long)s.maxApplyUs);
+    }
+
+    // Input latency (line command Y): tap along with the beat on the keys to measure it
+    void latencyCommand(char op, const char *arg)
+    {
+        RecordEngine *rec = rl_->recorder();
+        if (!rec)
+        {
+            Serial.println("ERR no recorder");
+            return;
+        }
+        LatencyComp &lat = rec->latency();
+        switch (op)
+        {
+        case 'C':
+        {
+            if (!tx_->isRunning())
+            {
+                Serial.println("ERR start the transport, then tap along with the beat");
+                return;
+            }
+            unsigned long taps = *arg ? strtoul(arg, nullptr, 10) : 16;
+            lat.startCalibration(InputSource::Keys, (uint8_t)(taps > LatencyComp::MAX_TAPS ? LatencyComp::MAX_TAPS : taps));
+            Serial.printf("Tap %u times on the beat (any key); Y shows the result\n", lat.wanted());
+            return;
+        }
+        case 'S':
+            lat.setOffsetUs(InputSource::Keys, strtol(arg, nullptr, 10));
+            break;
+        case 'X':
+            lat.cancel();
+            break;
+        case '\0':
+            break;
+        default:
+            Serial.println("ERR Y, YC[<taps>], YS<us>, YX");
+            return;
+        }
+        Serial.printf("Latency keys %ld us", (long)lat.offsetUs(InputSource::Keys));
+        if (lat.calibrating())
+            Serial.printf(" (calibrating: %u/%u taps)", lat.taps(), lat.wanted());
+        Serial.println();
+        if (!lat.histogramTaps())
+            return;
+        Serial.printf("Residual of last calibration (%u taps, worst %ld us):\n", lat.histogramTaps(), (long)lat.worstUs());
+        const uint16_t *h = lat.histogram();
+        for (uint8_t b = 0; b < LatencyComp::BINS; ++b)
+        {
+            if (!h[b])
+                continue;
+            const int ms = b - LatencyComp::BINS / 2;
+            Serial.printf("  %s%+3d ms %3u ", b == 0 || b == LatencyComp::BINS - 1 ? ">" : " ", ms, h[b]);
+            for (uint16_t i = 0; i < h[b]; ++i)
+                Serial.print("#");
+            Serial.println();
+        }
+    }
+
+    // Groove commands (line command H): swing or a template taken from the selected track
+    void grooveCommand(const char *arg)
+    {
+        Groove &g = pat_->groove;
+        char *end = nullptr;
+        if (*arg == 'X')
+        {
+            unsigned long steps = arg[1] ? strtoul(arg + 1, &end, 10) : 16;
+            if ((end && *end) || !steps || steps > Groove::MAX_STEPS)
+            {
+                Serial.printf("ERR HX[<steps 1..%u>]\n", Groove::MAX_STEPS);
+                return;
+            }
+            rl_->history().checkpoint();
+            if (!g.extract(pat_->selected().notes, (uint8_t)steps, (uint8_t)timebase::ticksPerStep(pat_->grid)))
+            {
+                Serial.println("ERR selected track is empty");
+                return;
+            }
+            Serial.printf("Groove from track %u, %lu steps:", pat_->sel + 1, steps);
+            for (uint8_t k = 0; k < g.steps; ++k)
+                Serial.printf(" %+d/%+d", (g.shift_q8[k] + (g.shift_q8[k] < 0 ? -128 : 128)) / 256, g.vel[k]);
+            Serial.println();
+            return;
+        }
+        unsigned long pct = strtoul(arg, &end, 10);
+        unsigned long grid = (end && *end) ? strtoul(end, nullptr, 10) : 16;
+        if (end == arg || pct > 75 || (grid != 8 && grid != 16 && grid != 32))
+        {
+            Serial.println("ERR H<swing 0..75>[ <grid 8|16|32>], HX[<steps>]");
+            return;
+        }
+        rl_->history().checkpoint();
+        g.swing((uint8_t)pct, (uint8_t)timebase::ticksPerStep((uint8_t)grid));
+        if (g.active())
+            Serial.printf("Swing %lu%% on 1/%lu\n", pct, grid);
+        else
+            Serial.println("Groove off (straight)");
+    }
 
     // Handle generative view commands
 
@@ -418,6 +1261,8 @@ private:
     Viewport *vp_{nullptr};
     ViewManager *vm_{nullptr};
     PerformanceView *perf_{nullptr};
+    PatternFile *file_{nullptr};
+    SmfImporter smf_; // fixed read window + open-note table, reused per import
 
     char cmdBuf_[24]{};
     int bufLen_{0};
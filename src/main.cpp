@@ -3,6 +3,7 @@
 
 #include "model/pattern.hpp"
 #include "model/viewport.hpp"
+#include "model/note_pool.hpp"
 
 #include "core/runloop.hpp"
 #include "core/tick_scheduler.hpp"
@@ -17,6 +18,8 @@
 #include "ui/views/generative_view.hpp"
 #include "io/serial_monitor_input.hpp"
 #include "io/encoder_manager.hpp"
+#include "storage/pattern_file.hpp"
+#include "storage/stream_file.hpp"
 
 static constexpr uint16_t PPQN = 96;
 static inline uint32_t ticksPerStep(uint16_t gridDiv) { return (uint32_t(PPQN) * 4u) / gridDiv; }
@@ -41,12 +44,30 @@ const EncoderManager::PinConfig ENCODER_PINS[8] = {
     {24, 25, 31}   // ENC8
 };
 
+// Note page pool backing store; placement selected by NOTE_POOL_REGION (config.hpp)
+#if NOTE_POOL_REGION == 2
+EXTMEM NotePage notePages[cfg::NOTE_POOL_PAGES];
+static constexpr MemRegion NOTE_POOL_MEM = MemRegion::Psram;
+#elif NOTE_POOL_REGION == 1
+DMAMEM NotePage notePages[cfg::NOTE_POOL_PAGES];
+static constexpr MemRegion NOTE_POOL_MEM = MemRegion::Ocram;
+#else
+NotePage notePages[cfg::NOTE_POOL_PAGES];
+static constexpr MemRegion NOTE_POOL_MEM = MemRegion::Dtcm;
+#endif
+NotePool notePool;
+
+// Read-ahead ring for streaming playback from the SD card
+DMAMEM stream_file::Block streamRing[cfg::STREAM_RING_BLOCKS];
+
 TickScheduler sched;
 Transport transport;
 PlaybackEngine engine;
 MidiIO midi;
 RunLoop runner;
 Pattern pat;
+PatternBank bank; // song mode pattern slots
+Song song;
 Viewport vp;
 OledRenderer oled;
 ViewManager viewManager;
@@ -54,6 +75,7 @@ PerformanceView performanceView;
 GenerativeView generativeView;
 RecordEngine recorder;
 SerialMonitorInput serialIn;
+PatternFile patternFile; // pattern bank on the SD card
 
 
 static uint16_t visibleSteps = 16; // S ∈ {1,2,4,8,16,32,64}
@@ -69,6 +91,18 @@ void setup()
   Serial.println("View system: Performance (default) and Generative modes");
   Serial.println("Switch views: Control button 6");
 
+  uint16_t poolPages = cfg::NOTE_POOL_PAGES;
+#if NOTE_POOL_REGION == 2
+  if (!external_psram_size)
+  {
+    Serial.println("WARN: note pool placed in PSRAM but none fitted; notes disabled");
+    poolPages = 0;
+  }
+#endif
+  notePool.begin(notePages, poolPages, NOTE_POOL_MEM);
+  Serial.printf("Note pool: %u pages in %s (%u KB)\n", poolPages, memRegionName(NOTE_POOL_MEM),
+                (unsigned)(notePool.bytes() / 1024));
+
   oled.begin();
   midi.begin();
   sched.begin();
@@ -76,7 +110,7 @@ void setup()
   pat.grid = 16;
   pat.steps = 64;
   pat.tempo = 120.f;
-  pat.track.channel = 13;
+  pat.tracks[0].channel = 13;
 
   transport.setLoopLen(pat.ticks());
   transport.setTempo(pat.tempo);
@@ -87,12 +121,15 @@ void setup()
   vp.tickSpan = ticksPerStep(pat.grid) * visibleSteps;
 
   runner.begin(&sched, &transport, &engine, &midi, &pat);
-  recorder.begin(&pat, &transport);
+  runner.attachSong(&bank, &song);
+  runner.attachStream(streamRing, cfg::STREAM_RING_BLOCKS, cfg::STREAM_LEAD_TICKS);
+  recorder.begin(&pat, &transport, &engine, &runner.history());
+  runner.attachRecorder(&recorder);
   
   // Initialize views
   viewManager.registerView(ViewType::Performance, &performanceView);
   viewManager.registerView(ViewType::Generative, &generativeView);
-  viewManager.beginAll(pat.track.channel);
+  viewManager.beginAll(pat.selected().channel);
   viewManager.attachAll(&runner, &recorder, &transport); // Now includes ViewManager attachment
   
   // Initialize encoders
@@ -102,6 +139,19 @@ void setup()
   Serial.println("  ENC4 (Switch Gen) - ENC5-8 (Reserved)");
   
   serialIn.attach(&runner, &transport, &pat, &vp, &viewManager, &performanceView);
+
+  if (SD.begin(BUILTIN_SDCARD) && patternFile.open(cfg::PATTERN_FILE))
+  {
+    uint16_t used = 0;
+    for (uint16_t i = 0; i < patternFile.slots(); ++i)
+      used += patternFile.used(i);
+    Serial.printf("Pattern file %s: %u/%u slots used\n", cfg::PATTERN_FILE, used, patternFile.slots());
+    serialIn.attachStorage(&patternFile);
+  }
+  else
+  {
+    Serial.println("WARN: no SD card or unreadable pattern file; saving disabled");
+  }
 }
 
 void loop()
@@ -109,6 +159,9 @@ void loop()
   // Run clock & transport and generate events
   runner.service();
 
+  // Background pattern save or bank compaction, one small chunk per pass
+  patternFile.saveStep();
+
   // UI input and rendering
   viewManager.poll(midi);
   // Serial monitor ghost controls
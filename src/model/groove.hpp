@@ -0,0 +1,86 @@
+#pragma once
+#include <stdint.h>
+#include "note_store.hpp"
+
+/**
+ * Groove template: a timing offset (1/256 tick) and a velocity offset per
+ * step position, repeating every `steps` steps of `stepTicks` note ticks.
+ * A note takes the offsets of the step it is nearest to. Timeline applies
+ * the groove when it compiles a track, so playback never sees it; rev()
+ * changes with every edit so compiled tracks know to rebuild.
+ */
+struct Groove
+{
+    static constexpr uint8_t MAX_STEPS = 16;
+
+    uint8_t steps{0}; // template length; 0 = straight
+    uint8_t stepTicks{24};
+    int16_t shift_q8[MAX_STEPS]{};
+    int8_t vel[MAX_STEPS]{};
+
+    bool active() const { return steps != 0; }
+    uint32_t rev() const { return rev_; }
+    uint8_t position(uint32_t on) const { return (uint8_t)(((on + stepTicks / 2) / stepTicks) % steps); }
+
+    void clear()
+    {
+        steps = 0;
+        for (uint8_t k = 0; k < MAX_STEPS; ++k)
+            shift_q8[k] = vel[k] = 0;
+        bump();
+    }
+
+    // MPC-style swing: every second step lands at `percent` (50 = straight,
+    // up to 75) of the step pair instead of halfway
+    void swing(uint8_t percent, uint8_t ticks = 24)
+    {
+        clear();
+        if (percent <= 50 || !ticks)
+            return;
+        if (percent > 75)
+            percent = 75;
+        steps = 2;
+        stepTicks = ticks;
+        shift_q8[1] = (int16_t)((percent - 50) * 2 * ticks * 256 / 100);
+    }
+
+    // Template from a played take: per position, the average distance to the
+    // step grid and the velocity difference from the take's average.
+    // Positions without notes stay straight. False if the take is empty.
+    bool extract(const NoteStore &ns, uint8_t len, uint8_t ticks = 24)
+    {
+        if (!len || len > MAX_STEPS || !ticks || ns.empty())
+            return false;
+        int32_t dt[MAX_STEPS] = {}, dv[MAX_STEPS] = {};
+        uint32_t n[MAX_STEPS] = {};
+        int32_t velSum = 0;
+        clear();
+        steps = len;
+        stepTicks = ticks;
+        for (auto it = ns.begin(); it != ns.end(); ++it)
+        {
+            const uint8_t k = position(it.on());
+            const uint32_t grid = (it.on() + ticks / 2) / ticks * ticks;
+            const int32_t d = ((int32_t)it.on() - (int32_t)grid) * 256 + it.micro_q8();
+            dt[k] += d;
+            dv[k] += it.vel();
+            velSum += it.vel();
+            n[k]++;
+        }
+        const int32_t mean = velSum / (int32_t)ns.size();
+        for (uint8_t k = 0; k < len; ++k)
+            if (n[k])
+            {
+                shift_q8[k] = (int16_t)(dt[k] / (int32_t)n[k]);
+                const int32_t v = dv[k] / (int32_t)n[k] - mean;
+                vel[k] = (int8_t)(v < -127 ? -127 : (v > 127 ? 127 : v));
+            }
+        return true;
+    }
+
+private:
+    uint32_t rev_{0};
+    static inline uint32_t revSeq_{0};
+
+    void bump() { rev_ = ++revSeq_; }
+};
@@ -3,7 +3,8 @@
 
 enum NoteFlags : uint8_t
 {
-    NF_Mute = 1 << 0
+    NF_Mute = 1 << 0,
+    NF_Ratchet = 0xFE // bits 1..7: ratchet, see namespace ratchet
 };
 
 struct Note
@@ -11,10 +12,130 @@ struct Note
     uint32_t on,  // tick start
         duration; // ticks
 
-    int16_t micro, // sub-tick (ticks/256), signed
-        micro_q8;  // fractional ticks * 1/256 (can be negative; we delay only if >0)
+    int16_t micro_q8; // fractional ticks * 1/256, in the same ticks as `on` (can be negative; we delay only if >0)
 
     uint8_t pitch, // 0–127
         vel,       // 0–127
-        flags;     // bitset
+        flags,     // bitset
+        skip,      // chance in percent that the note is skipped (0 = always plays)
+        cond;      // loop condition, see trig (0 = every pass)
 };
+
+// Loop-count conditions for Note::cond, checked when the note is due.
+// A:B plays on pass A of every B (1-based, B <= 8): bit 7 set, bits 3..5 A-1, bits 0..2 B-1.
+// A:B follows the position (a locate into loop k is pass k); First follows what was played.
+namespace trig
+{
+    enum : uint8_t
+    {
+        Always = 0,
+        Fill = 1,    // only while fill is on
+        NotFill = 2, // only while fill is off
+        First = 3,   // first pass after start/locate
+        NotFirst = 4
+    };
+    constexpr uint8_t every(uint8_t a, uint8_t b) { return (uint8_t)(0x80 | ((a - 1) & 7) << 3 | ((b - 1) & 7)); }
+
+    // pass: 0-based loop count of the note's track; first: the first pass played since start/locate
+    inline bool passes(uint8_t cond, uint32_t pass, bool first, bool fill)
+    {
+        if (cond & 0x80)
+            return pass % ((cond & 7) + 1u) == ((cond >> 3) & 7u);
+        switch (cond)
+        {
+        case Fill: return fill;
+        case NotFill: return !fill;
+        case First: return first;
+        case NotFirst: return !first;
+        default: return true;
+        }
+    }
+}
+
+// Ratchet/retrig of a single stored note, packed into Note::flags bits 1..7:
+// bits 1..3 hits-1 (0 = plain note), bits 4..5 Rate, bits 6..7 Ramp.
+// PlaybackEngine expands the hits while playing; they are never stored.
+namespace ratchet
+{
+    enum Rate : uint8_t
+    {
+        Split = 0, // hits share the note's length evenly
+        R32 = 1,   // one hit per 1/32 (12 ticks)
+        R64 = 2,   // 1/64 (6 ticks)
+        R128 = 3   // 1/128 (3 ticks)
+    };
+    enum Ramp : uint8_t
+    {
+        Flat = 0,
+        Up = 1,  // from vel/hits up to vel
+        Down = 2 // from vel down to vel/hits
+    };
+    constexpr uint8_t MAX_HITS = 8;
+
+    constexpr uint8_t make(uint8_t hits, uint8_t rate = Split, uint8_t ramp = Flat)
+    {
+        return hits <= 1 ? 0 : (uint8_t)(((hits > MAX_HITS ? MAX_HITS : hits) - 1) << 1 | (rate & 3) << 4 | (ramp & 3) << 6);
+    }
+    constexpr uint8_t hits(uint8_t flags) { return (uint8_t)(((flags >> 1) & 7) + 1); }
+    constexpr uint8_t rate(uint8_t flags) { return (flags >> 4) & 3; }
+    constexpr uint8_t ramp(uint8_t flags) { return (flags >> 6) & 3; }
+
+    // Ticks between hits of a note lasting `duration` ticks (at least 1)
+    inline uint32_t interval(uint8_t flags, uint32_t duration)
+    {
+        const uint32_t i = rate(flags) ? 24u >> rate(flags) : duration / hits(flags);
+        return i ? i : 1;
+    }
+    // Each hit sounds for half the interval
+    inline uint32_t gate(uint32_t interval) { return interval > 1 ? interval / 2 : 1; }
+    // Velocity of hit k (0-based)
+    inline uint8_t velocity(uint8_t flags, uint8_t vel, uint8_t k)
+    {
+        const uint8_t n = hits(flags);
+        uint32_t v = vel;
+        if (ramp(flags) == Up)
+            v = (uint32_t)vel * (k + 1) / n;
+        else if (ramp(flags) == Down)
+            v = (uint32_t)vel * (n - k) / n;
+        return (uint8_t)(v ? v : 1);
+    }
+}
+
+// 8-byte record form of a Note for bulk/archival use (one word per field group).
+// Tick start is limited to 24 bits (~43k bars of 4/4 at PPQN=96), duration
+// saturates at 65535 ticks, micro_q8 is kept as a signed 8-bit sub-tick residual
+// and only NF_Mute survives (stored in the pitch byte's spare bit); skip, cond
+// and ratchets are dropped.
+struct PackedNote
+{
+    uint32_t onMicro;  // bits 0..23 tick start, bits 24..31 micro_q8 (int8)
+    uint16_t duration; // ticks (saturated)
+    uint8_t pitch;     // bits 0..6 pitch, bit 7 NF_Mute
+    uint8_t vel;
+
+    static constexpr uint32_t ON_MASK = 0x00FFFFFFu;
+
+    static PackedNote pack(const Note &n)
+    {
+        int16_t m = n.micro_q8 < -128 ? -128 : (n.micro_q8 > 127 ? 127 : n.micro_q8);
+        PackedNote p;
+        p.onMicro = (n.on & ON_MASK) | ((uint32_t)(uint8_t)(int8_t)m << 24);
+        p.duration = n.duration > 0xFFFFu ? 0xFFFFu : (uint16_t)n.duration;
+        p.pitch = (uint8_t)((n.pitch & 0x7F) | ((n.flags & NF_Mute) ? 0x80 : 0));
+        p.vel = n.vel;
+        return p;
+    }
+
+    Note unpack() const
+    {
+        Note n{};
+        n.on = onMicro & ON_MASK;
+        n.duration = duration;
+        n.micro_q8 = (int8_t)(uint8_t)(onMicro >> 24);
+        n.pitch = pitch & 0x7F;
+        n.vel = vel;
+        n.flags = (pitch & 0x80) ? NF_Mute : 0;
+        return n;
+    }
+};
+static_assert(sizeof(PackedNote) == 8, "PackedNote must stay 8 bytes");
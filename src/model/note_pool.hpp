@@ -0,0 +1,163 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Memory the page array was placed in (reporting only; placement is decided
+// where the backing array is declared, see main.cpp)
+enum class MemRegion : uint8_t { Dtcm = 0, Ocram = 1, Psram = 2 };
+
+inline const char *memRegionName(MemRegion r)
+{
+    switch (r)
+    {
+    case MemRegion::Dtcm: return "DTCM";
+    case MemRegion::Ocram: return "OCRAM";
+    case MemRegion::Psram: return "PSRAM";
+    }
+    return "?";
+}
+
+/**
+ * Fixed-size block of notes in SoA layout. Pages are the unit of allocation
+ * for NoteStore. A page can be shared read-only by several stores (snapshots);
+ * `refs` counts them and a store copies the page before writing to it.
+ */
+struct NotePage
+{
+    static constexpr uint8_t N = 32;
+
+    uint32_t on[N];
+    uint16_t dur[N];
+    uint8_t pitch[N], vel[N], flags[N];
+    int8_t micro[N];
+    uint8_t skip[N], cond[N]; // trig probability / condition (Note::skip, Note::cond)
+
+    uint16_t next; // free-list link while unallocated
+    uint8_t n;     // notes in use
+    uint8_t refs;  // stores referencing this page
+};
+
+/**
+ * Page allocator over a caller-provided array. Capacity is fixed at begin(),
+ * alloc/release are O(1) free-list operations and nothing touches the heap,
+ * so stores can grow during live recording without reallocation. Pages are
+ * reference counted: release() only frees a page when its last holder lets go.
+ */
+class NotePool
+{
+public:
+    static constexpr uint16_t NIL = 0xFFFF;
+
+    struct Stats
+    {
+        uint16_t total, used, peak;
+        uint32_t allocs, frees, failures;
+    };
+
+    void begin(NotePage *pages, uint16_t count, MemRegion region)
+    {
+        pages_ = pages;
+        count_ = count;
+        region_ = region;
+        stats_ = Stats{count, 0, 0, 0, 0, 0};
+        // Backing arrays in DMAMEM/EXTMEM are not zeroed at boot; thread the free list here
+        for (uint16_t i = 0; i < count; ++i)
+        {
+            pages_[i].next = (uint16_t)(i + 1 < count ? i + 1 : NIL);
+            pages_[i].n = 0;
+            pages_[i].refs = 0;
+        }
+        free_ = count ? 0 : NIL;
+        if (!default_)
+            default_ = this;
+    }
+
+    uint16_t alloc()
+    {
+        if (free_ == NIL)
+        {
+            stats_.failures++;
+            return NIL;
+        }
+        uint16_t id = free_;
+        free_ = pages_[id].next;
+        pages_[id].next = NIL;
+        pages_[id].n = 0;
+        pages_[id].refs = 1;
+        stats_.allocs++;
+        if (++stats_.used > stats_.peak)
+            stats_.peak = stats_.used;
+        return id;
+    }
+
+    // Share a page with one more store; false if the count would overflow
+    bool retain(uint16_t id)
+    {
+        if (id >= count_ || pages_[id].refs == 0xFF)
+            return false;
+        pages_[id].refs++;
+        return true;
+    }
+
+    // New private page with the same contents; NIL if the pool is full
+    uint16_t clone(uint16_t id)
+    {
+        uint16_t c = alloc();
+        if (c == NIL)
+            return NIL;
+        pages_[c] = pages_[id];
+        pages_[c].next = NIL;
+        pages_[c].refs = 1;
+        return c;
+    }
+
+    // Private copy of a shared page for writing (drops one reference to the
+    // original); returns id itself when it is not shared, NIL if the pool is full
+    uint16_t unshare(uint16_t id)
+    {
+        if (id >= count_ || pages_[id].refs <= 1)
+            return id;
+        uint16_t c = clone(id);
+        if (c != NIL)
+            pages_[id].refs--;
+        return c;
+    }
+
+    void release(uint16_t id)
+    {
+        if (id >= count_)
+            return;
+        if (pages_[id].refs > 1)
+        {
+            pages_[id].refs--;
+            return;
+        }
+        pages_[id].refs = 0;
+        pages_[id].next = free_;
+        pages_[id].n = 0;
+        free_ = id;
+        stats_.frees++;
+        stats_.used--;
+    }
+
+    uint8_t refs(uint16_t id) const { return id < count_ ? pages_[id].refs : 0; }
+    NotePage &page(uint16_t id) { return pages_[id]; }
+    const NotePage &page(uint16_t id) const { return pages_[id]; }
+
+    uint16_t available() const { return (uint16_t)(count_ - stats_.used); }
+    const Stats &stats() const { return stats_; }
+    MemRegion region() const { return region_; }
+    size_t bytes() const { return (size_t)count_ * sizeof(NotePage); }
+
+    // First pool that was begun; used by stores that were not given one explicitly
+    static NotePool *defaultPool() { return default_; }
+
+private:
+    NotePage *pages_{nullptr};
+    uint16_t count_{0};
+    uint16_t free_{NIL};
+    MemRegion region_{MemRegion::Dtcm};
+    Stats stats_{};
+
+    static inline NotePool *default_{nullptr};
+};
@@ -0,0 +1,509 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <iterator>
+#include <utility>
+#include "note.hpp"
+#include "note_pool.hpp"
+#include "config.hpp"
+
+/**
+ * Structure-of-arrays note storage for a track.
+ * Notes live in fixed NotePages taken from a NotePool; inside a page each Note
+ * field has its own column, so per-tick scans that only look at start/duration
+ * touch 6 bytes per note instead of a padded 16-byte struct.
+ * Duration is stored as 16 bits (saturated) and micro_q8 as a signed 8-bit
+ * sub-tick residual; everything else round-trips exactly.
+ *
+ * Pages are kept densely packed (every page but the last is full), so
+ * push_back and erase (swap with last) are O(1) and never touch the heap.
+ * The page directory is two-level: the first DIRECT pages are listed in the
+ * store itself, the rest in index pages taken from the same pool on demand,
+ * so a store costs a few dozen bytes plus memory in proportion to its notes.
+ * assign() shares pages instead of copying them (copy-on-write): a snapshot
+ * shares the direct pages and whole index pages, and a later edit copies only
+ * the page it touches (plus that page's index page, once).
+ * Iteration yields Note values decoded on the fly (no copy of the container),
+ * and the iterator exposes per-column accessors for hot paths.
+ */
+class NoteStore
+{
+public:
+    static constexpr size_t BYTES_PER_NOTE = sizeof(uint32_t) + sizeof(uint16_t) + 6 * sizeof(uint8_t);
+    static constexpr uint8_t PAGE = NotePage::N;
+    static constexpr uint8_t DIRECT = 8; // pages listed in the store itself
+    static constexpr uint16_t IDS = offsetof(NotePage, next) / sizeof(uint16_t); // page ids per index page
+    static constexpr uint8_t MAX_INDEX = cfg::TRACK_INDEX_PAGES;
+    static constexpr uint16_t MAX_PAGES = DIRECT + MAX_INDEX * IDS;
+    static_assert((size_t)MAX_PAGES * PAGE <= 0xFFFF, "note counts are 16-bit (pattern file, timeline sort)");
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Note;
+        using difference_type = ptrdiff_t;
+        using pointer = void;
+        using reference = Note;
+
+        const_iterator() = default;
+        const_iterator(const NoteStore *s, size_t i) : s_(s), i_(i) { load(); }
+
+        Note operator*() const { return decode(*pg_, slot_); }
+        const_iterator &operator++()
+        {
+            ++i_;
+            if (++slot_ == PAGE)
+                load();
+            return *this;
+        }
+        const_iterator operator++(int) { const_iterator t = *this; ++*this; return t; }
+        bool operator==(const const_iterator &o) const { return i_ == o.i_ && s_ == o.s_; }
+        bool operator!=(const const_iterator &o) const { return !(*this == o); }
+
+        // Column accessors (no Note materialization)
+        uint32_t on() const { return pg_->on[slot_]; }
+        uint32_t duration() const { return pg_->dur[slot_]; }
+        uint8_t pitch() const { return pg_->pitch[slot_]; }
+        uint8_t vel() const { return pg_->vel[slot_]; }
+        uint8_t flags() const { return pg_->flags[slot_]; }
+        int16_t micro_q8() const { return pg_->micro[slot_]; }
+        uint8_t skip() const { return pg_->skip[slot_]; }
+        uint8_t cond() const { return pg_->cond[slot_]; }
+        size_t index() const { return i_; }
+
+    private:
+        const NoteStore *s_{nullptr};
+        const NotePage *pg_{nullptr};
+        size_t i_{0};
+        uint8_t slot_{0};
+
+        void load()
+        {
+            slot_ = (uint8_t)(i_ % PAGE);
+            size_t p = i_ / PAGE;
+            pg_ = (s_ && p < s_->pages_) ? &s_->pool()->page(s_->pageId((uint16_t)p)) : nullptr;
+        }
+    };
+
+    NoteStore() = default;
+    ~NoteStore() { clear(); }
+    // Pages are owned exclusively; copying would alias them
+    NoteStore(const NoteStore &) = delete;
+    NoteStore &operator=(const NoteStore &) = delete;
+
+    // Bind to a specific pool (defaults to NotePool::defaultPool()). Only valid while empty.
+    void attach(NotePool *pool)
+    {
+        if (!pages_)
+            pool_ = pool;
+    }
+    NotePool *pool() const { return pool_ ? pool_ : NotePool::defaultPool(); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+    const_iterator at(size_t i) const { return const_iterator(this, i < size_ ? i : size_); }
+
+    // Binary searches over start ticks; only meaningful when notes were added in
+    // start order (e.g. a compiled Timeline)
+    size_t lowerBound(uint32_t tick) const { return bound(tick, false); }
+    size_t upperBound(uint32_t tick) const { return bound(tick, true); }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return (size_t)pages_ * PAGE; }
+    size_t bytes() const { return (size_t)(pages_ + indexPages()) * sizeof(NotePage); }
+    uint16_t pages() const { return pages_; }
+    // Changes on every mutation so derived data (timelines) can detect staleness;
+    // drawn from one counter shared by all stores, so values never repeat across swaps
+    uint32_t rev() const { return rev_; }
+
+    // Claim pages up front so later push_backs never hit the pool
+    bool reserve(size_t n)
+    {
+        while (capacity() < n)
+            if (!grow())
+                return false;
+        return true;
+    }
+
+    void clear()
+    {
+        NotePool *p = pool();
+        for (uint16_t i = 0; i < pages_ && i < DIRECT; ++i)
+            p->release(direct_[i]);
+        for (uint8_t k = 0; k < indexPages(); ++k)
+            dropIndex(index_[k], inIndex(k));
+        pages_ = 0;
+        size_ = 0;
+        bump();
+    }
+
+    // Copy of another store that shares its pages until either side writes;
+    // O(pages). On pool exhaustion this store ends up empty.
+    bool assign(const NoteStore &o)
+    {
+        if (&o == this)
+            return true;
+        clear();
+        NotePool *p = pool();
+        if (!p)
+            return o.empty();
+        if (o.pool() != p)
+        {
+            // Different pool: private copies, page by page
+            for (uint16_t i = 0; i < o.pages_; ++i)
+            {
+                if (!grow())
+                {
+                    clear();
+                    return false;
+                }
+                NotePage &pg = p->page(pageId(i));
+                pg = o.page(i);
+                pg.next = NIL_PAGE;
+                pg.refs = 1;
+            }
+        }
+        else
+        {
+            for (uint16_t i = 0; i < o.pages_ && i < DIRECT; ++i, ++pages_)
+                if ((direct_[i] = share(o.direct_[i])) == NIL_PAGE)
+                {
+                    clear();
+                    return false;
+                }
+            for (uint8_t k = 0; k < o.indexPages(); ++k)
+            {
+                const uint16_t n = o.inIndex(k);
+                index_[k] = p->retain(o.index_[k]) ? o.index_[k] : copyIndex(o.index_[k], n);
+                if (index_[k] == NIL_PAGE)
+                {
+                    clear();
+                    return false;
+                }
+                pages_ += n;
+            }
+        }
+        size_ = o.size_;
+        bump();
+        return true;
+    }
+
+    // O(pages) exchange of contents, revisions included; no notes are copied
+    void swap(NoteStore &o)
+    {
+        std::swap(pool_, o.pool_);
+        for (uint8_t i = 0; i < DIRECT; ++i)
+            std::swap(direct_[i], o.direct_[i]);
+        for (uint8_t k = 0; k < MAX_INDEX; ++k)
+            std::swap(index_[k], o.index_[k]);
+        std::swap(pages_, o.pages_);
+        std::swap(size_, o.size_);
+        std::swap(rev_, o.rev_);
+    }
+
+    // Returns false when the pool or the page directory is exhausted
+    bool push_back(const Note &n)
+    {
+        if (size_ == capacity() ? !grow() : !own((uint16_t)(size_ / PAGE)))
+            return false;
+        NotePage &pg = pageAt(size_);
+        encode(pg, size_ % PAGE, n);
+        pg.n++;
+        size_++;
+        bump();
+        return true;
+    }
+    bool push_back(const PackedNote &p) { return push_back(p.unpack()); }
+
+    // Insert k notes given in start order, keeping a start-ordered store in order
+    // (equal starts go after the notes already stored). One backward pass that
+    // only moves the notes after the first insertion point. Returns the number
+    // inserted: fewer than k (the earliest ones) when the pool runs out.
+    size_t merge(const Note *src, size_t k)
+    {
+        const size_t n = size_;
+        size_t m = 0;
+        while (m < k && push_back(src[m]))
+            m++;
+        size_t i = n, j = m; // slot i + j - 1 is written next
+        while (j)
+        {
+            if (i && onAt(i - 1) > src[j - 1].on)
+            {
+                set(i + j - 1, get(i - 1));
+                --i;
+            }
+            else
+            {
+                set(i + j - 1, src[j - 1]);
+                --j;
+            }
+        }
+        return m;
+    }
+
+    // O(1) removal: the last note moves into slot i (order is not preserved)
+    bool erase(size_t i)
+    {
+        if (i >= size_)
+            return false;
+        size_t last = size_ - 1;
+        if (!own((uint16_t)(i / PAGE)) || !own((uint16_t)(last / PAGE)))
+            return false;
+        if (i != last)
+            encode(pageAt(i), i % PAGE, get(last));
+        NotePage &tail = pageAt(last);
+        tail.n--;
+        size_--;
+        bump();
+        if (tail.n == 0)
+            dropLast();
+        return true;
+    }
+
+    Note get(size_t i) const { return decode(pageAt(i), i % PAGE); }
+    Note operator[](size_t i) const { return get(i); }
+    uint32_t onAt(size_t i) const { return pageAt(i).on[i % PAGE]; }
+    bool set(size_t i, const Note &n)
+    {
+        if (i >= size_ || !own((uint16_t)(i / PAGE)))
+            return false;
+        encode(pageAt(i), i % PAGE, n);
+        bump();
+        return true;
+    }
+
+    PackedNote packed(size_t i) const { return PackedNote::pack(get(i)); }
+
+    // Raw page p (columns for notes p*PAGE...), for serializers
+    const NotePage &page(uint16_t p) const { return pool()->page(pageId(p)); }
+
+    // Bulk load: claims private pages for n notes and lets readPage(NotePage &)
+    // fill each page's columns in order. On failure the store ends up empty.
+    template <class F>
+    bool fill(size_t n, F &&readPage)
+    {
+        clear();
+        if (!reserve(n))
+        {
+            clear();
+            return false;
+        }
+        for (uint16_t i = 0; i < pages_; ++i)
+        {
+            NotePage &pg = pool()->page(pageId(i));
+            if (!readPage(pg))
+            {
+                clear();
+                return false;
+            }
+            size_t left = n - (size_t)i * PAGE;
+            pg.n = (uint8_t)(left < PAGE ? left : PAGE);
+        }
+        size_ = n;
+        bump();
+        return true;
+    }
+
+private:
+    NotePool *pool_{nullptr};
+    uint16_t direct_[DIRECT]{};
+    uint16_t index_[MAX_INDEX]{}; // pages holding the ids of pages DIRECT.. in IDS-sized runs
+    uint16_t pages_{0};
+    size_t size_{0};
+    uint32_t rev_{0};
+    static inline uint32_t revSeq_{0};
+    static constexpr uint16_t NIL_PAGE = NotePool::NIL;
+
+    void bump() { rev_ = ++revSeq_; }
+
+    // Index pages reuse the column area of a NotePage as uint16_t ids
+    static uint16_t idAt(const NotePage &ix, uint16_t i)
+    {
+        uint16_t v;
+        memcpy(&v, reinterpret_cast<const uint8_t *>(&ix) + i * sizeof(v), sizeof(v));
+        return v;
+    }
+    static void setIdAt(NotePage &ix, uint16_t i, uint16_t v)
+    {
+        memcpy(reinterpret_cast<uint8_t *>(&ix) + i * sizeof(v), &v, sizeof(v));
+    }
+
+    uint8_t indexPages() const { return pages_ <= DIRECT ? 0 : (uint8_t)((pages_ - DIRECT + IDS - 1) / IDS); }
+    // Pages listed in index page k
+    uint16_t inIndex(uint8_t k) const
+    {
+        const uint32_t first = DIRECT + (uint32_t)k * IDS;
+        return pages_ <= first ? 0 : (uint16_t)(pages_ - first < IDS ? pages_ - first : IDS);
+    }
+
+    uint16_t pageId(uint16_t p) const
+    {
+        if (p < DIRECT)
+            return direct_[p];
+        return idAt(pool()->page(index_[(p - DIRECT) / IDS]), (p - DIRECT) % IDS);
+    }
+    // The index page holding p must already be private
+    void setPageId(uint16_t p, uint16_t id)
+    {
+        if (p < DIRECT)
+            direct_[p] = id;
+        else
+            setIdAt(pool()->page(index_[(p - DIRECT) / IDS]), (p - DIRECT) % IDS, id);
+    }
+
+    // One more reference to a page, or a private copy when its count is saturated
+    uint16_t share(uint16_t id)
+    {
+        NotePool *p = pool();
+        return p->retain(id) ? id : p->clone(id);
+    }
+
+    // Private index page listing the same n pages (each gains a reference); NIL on pool exhaustion
+    uint16_t copyIndex(uint16_t ix, uint16_t n)
+    {
+        NotePool *p = pool();
+        const uint16_t c = p->alloc();
+        if (c == NIL_PAGE)
+            return NIL_PAGE;
+        for (uint16_t i = 0; i < n; ++i)
+        {
+            const uint16_t id = share(idAt(p->page(ix), i));
+            if (id == NIL_PAGE)
+            {
+                dropIndex(c, i);
+                return NIL_PAGE;
+            }
+            setIdAt(p->page(c), i, id);
+        }
+        return c;
+    }
+
+    // Let go of an index page; its pages go with it when this was the last holder
+    void dropIndex(uint16_t ix, uint16_t n)
+    {
+        NotePool *p = pool();
+        if (p->refs(ix) == 1)
+            for (uint16_t i = 0; i < n; ++i)
+                p->release(idAt(p->page(ix), i));
+        p->release(ix);
+    }
+
+    // Make index page k private before changing its entries
+    bool ownIndex(uint8_t k)
+    {
+        NotePool *p = pool();
+        if (p->refs(index_[k]) <= 1)
+            return true;
+        const uint16_t c = copyIndex(index_[k], inIndex(k));
+        if (c == NIL_PAGE)
+            return false;
+        p->release(index_[k]); // still held by the other store(s)
+        index_[k] = c;
+        return true;
+    }
+
+    // Make page p private to this store before writing to it
+    bool own(uint16_t p)
+    {
+        if (p >= DIRECT && !ownIndex((uint8_t)((p - DIRECT) / IDS)))
+            return false;
+        uint16_t id = pool()->unshare(pageId(p));
+        if (id == NIL_PAGE)
+            return false;
+        setPageId(p, id);
+        return true;
+    }
+
+    size_t bound(uint32_t tick, bool upper) const
+    {
+        size_t lo = 0, hi = size_;
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            uint32_t t = onAt(mid);
+            if (upper ? (t <= tick) : (t < tick))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    bool grow()
+    {
+        NotePool *p = pool();
+        if (!p || pages_ >= MAX_PAGES)
+            return false;
+        const uint16_t at = pages_;
+        const bool newIndex = at >= DIRECT && (at - DIRECT) % IDS == 0;
+        const uint8_t k = at >= DIRECT ? (uint8_t)((at - DIRECT) / IDS) : 0;
+        if (newIndex)
+        {
+            if ((index_[k] = p->alloc()) == NIL_PAGE)
+                return false;
+        }
+        else if (at >= DIRECT && !ownIndex(k))
+            return false;
+        uint16_t id = p->alloc();
+        if (id == NotePool::NIL)
+        {
+            if (newIndex)
+                p->release(index_[k]);
+            return false;
+        }
+        setPageId(at, id);
+        pages_++;
+        return true;
+    }
+
+    // Release the last page, and its index page once empty; the index page must be private
+    void dropLast()
+    {
+        const uint16_t at = --pages_;
+        pool()->release(pageId(at));
+        if (at >= DIRECT && (at - DIRECT) % IDS == 0)
+            pool()->release(index_[(at - DIRECT) / IDS]);
+    }
+
+    NotePage &pageAt(size_t i) { return pool()->page(pageId((uint16_t)(i / PAGE))); }
+    const NotePage &pageAt(size_t i) const { return pool()->page(pageId((uint16_t)(i / PAGE))); }
+
+    static void encode(NotePage &pg, size_t s, const Note &n)
+    {
+        pg.on[s] = n.on;
+        pg.dur[s] = n.duration > 0xFFFFu ? 0xFFFFu : (uint16_t)n.duration;
+        pg.pitch[s] = n.pitch;
+        pg.vel[s] = n.vel;
+        pg.flags[s] = n.flags;
+        pg.micro[s] = (int8_t)(n.micro_q8 < -128 ? -128 : (n.micro_q8 > 127 ? 127 : n.micro_q8));
+        pg.skip[s] = n.skip > 100 ? 100 : n.skip;
+        pg.cond[s] = n.cond;
+    }
+    static Note decode(const NotePage &pg, size_t s)
+    {
+        Note n{};
+        n.on = pg.on[s];
+        n.duration = pg.dur[s];
+        n.micro_q8 = pg.micro[s];
+        n.pitch = pg.pitch[s];
+        n.vel = pg.vel[s];
+        n.flags = pg.flags[s];
+        n.skip = pg.skip[s];
+        n.cond = pg.cond[s];
+        return n;
+    }
+};
+
+// Bytes needed to hold 1k notes in each representation (for the serial memory report)
+namespace note_footprint
+{
+    constexpr size_t PER = 1000;
+    constexpr size_t aos() { return sizeof(Note) * PER; }
+    constexpr size_t soa() { return NoteStore::BYTES_PER_NOTE * PER; }
+    constexpr size_t paged() { return (sizeof(NotePage) * PER + NotePage::N - 1) / NotePage::N; }
+    constexpr size_t packed() { return sizeof(PackedNote) * PER; }
+}
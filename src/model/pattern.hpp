@@ -1,16 +1,71 @@
 #pragma once
 #include <stdint.h>
 #include "track.hpp"
+#include "groove.hpp"
 #include "../types.hpp"
 
 
 struct Pattern
 {
-    Track track;
+    static constexpr uint8_t MAX_TRACKS = 16;
+    // Longest pattern/track: 16384 bars of 1/16; keeps ticks * clockDiv within 32 bits for any grid
+    static constexpr uint32_t MAX_STEPS = 1u << 18;
 
-    uint8_t steps{64}; // default track steps
+    Track tracks[MAX_TRACKS];
+    uint8_t trackCount{1}; // tracks in use (played and shown)
+    uint8_t sel{0};        // track edited/recorded/drawn by the UI
+
+    uint32_t steps{64}; // default track steps (1..MAX_STEPS)
     uint8_t grid{16};  // 1/16 when PPQN=96 → 6 ticks; keep symbolic
     float tempo{120.f};
+    Groove groove; // applied to every track when compiled (Timeline)
 
     uint32_t ticks() const { return timebase::ticksPerStep(grid) * steps; }
+
+    // Per-track loop: own step count (0 = pattern steps) and clock divisor
+    uint32_t trackSteps(uint8_t t) const { return tracks[t].steps ? tracks[t].steps : steps; }
+    uint32_t trackTicks(uint8_t t) const { return timebase::ticksPerStep(grid) * trackSteps(t); } // in note ticks
+    uint32_t trackPlayTicks(uint8_t t) const { return trackTicks(t) * (tracks[t].clockDiv ? tracks[t].clockDiv : 1u); }
+
+    Track &selected() { return tracks[sel]; }
+    const Track &selected() const { return tracks[sel]; }
+
+    // Deep copy (all tracks); false if the note pool ran out
+    bool assign(const Pattern &o)
+    {
+        bool ok = true;
+        for (uint8_t t = 0; t < MAX_TRACKS; ++t)
+            ok = tracks[t].assign(o.tracks[t]) && ok;
+        trackCount = o.trackCount;
+        sel = o.sel;
+        steps = o.steps;
+        grid = o.grid;
+        tempo = o.tempo;
+        groove = o.groove;
+        return ok;
+    }
+    // Exchange contents without copying notes; the UI selection stays put
+    void swap(Pattern &o)
+    {
+        for (uint8_t t = 0; t < MAX_TRACKS; ++t)
+            tracks[t].swap(o.tracks[t]);
+        std::swap(trackCount, o.trackCount);
+        std::swap(steps, o.steps);
+        std::swap(grid, o.grid);
+        std::swap(tempo, o.tempo);
+        std::swap(groove, o.groove);
+        if (sel >= trackCount)
+            sel = trackCount ? trackCount - 1 : 0;
+    }
+
+    // Select a track, growing trackCount to include it
+    bool select(uint8_t idx)
+    {
+        if (idx >= MAX_TRACKS)
+            return false;
+        sel = idx;
+        if (trackCount <= idx)
+            trackCount = idx + 1;
+        return true;
+    }
 };
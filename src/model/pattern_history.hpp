@@ -0,0 +1,129 @@
+#pragma once
+#include <stdint.h>
+#include "pattern.hpp"
+#include "config.hpp"
+
+/**
+ * Undo/redo over copy-on-write Pattern snapshots.
+ * checkpoint() shares every note page of the live pattern (no notes copied),
+ * so a snapshot only grows by the pages later edits touch. undo()/redo()
+ * exchange the live pattern with a stored one (page directories only), which
+ * is safe while playing: the Timeline sees new track revisions and recompiles.
+ *
+ * Memory is bounded twice: at most UNDO_DEPTH snapshots, and the oldest ones
+ * are dropped whenever the note pool runs below `reserve` free pages.
+ */
+class PatternHistory
+{
+public:
+    static constexpr uint8_t DEPTH = cfg::UNDO_DEPTH;
+
+    void begin(Pattern *live, uint16_t reserve = cfg::UNDO_RESERVE_PAGES)
+    {
+        live_ = live;
+        reserve_ = reserve;
+    }
+
+    uint8_t undoDepth() const { return undoN_; }
+    uint8_t redoDepth() const { return redoN_; }
+    uint32_t evictions() const { return evicted_; }
+
+    // Remember the live pattern before a destructive edit; drops the redo branch
+    bool checkpoint()
+    {
+        if (!live_)
+            return false;
+        while (redoN_)
+            drop(redo_[--redoN_]);
+        if (undoN_ == DEPTH)
+            evictOldest();
+        const uint8_t s = freeSlot();
+        if (!slots_[s].assign(*live_))
+        {
+            clearSlot(s);
+            return false;
+        }
+        used_[s] = true;
+        undo_[undoN_++] = s;
+        trim();
+        return undoN_ != 0;
+    }
+
+    bool undo()
+    {
+        if (!live_ || !undoN_)
+            return false;
+        const uint8_t s = undo_[--undoN_];
+        live_->swap(slots_[s]); // the slot now holds the state being undone
+        redo_[redoN_++] = s;
+        return true;
+    }
+
+    bool redo()
+    {
+        if (!live_ || !redoN_)
+            return false;
+        const uint8_t s = redo_[--redoN_];
+        live_->swap(slots_[s]);
+        undo_[undoN_++] = s;
+        return true;
+    }
+
+    // Drop the oldest snapshots while the pool is short; call from the main loop
+    void trim()
+    {
+        const NotePool *p = NotePool::defaultPool();
+        while (p && p->available() < reserve_ && (undoN_ || redoN_))
+            evictOldest();
+    }
+
+private:
+    Pattern *live_{nullptr};
+    Pattern slots_[DEPTH];
+    bool used_[DEPTH]{};
+    uint8_t undo_[DEPTH]{}; // oldest first
+    uint8_t redo_[DEPTH]{}; // furthest first
+    uint8_t undoN_{0}, redoN_{0};
+    uint16_t reserve_{0};
+    uint32_t evicted_{0};
+
+    uint8_t freeSlot() const
+    {
+        for (uint8_t i = 0; i < DEPTH; ++i)
+            if (!used_[i])
+                return i;
+        return 0; // unreachable: callers evict first
+    }
+
+    void clearSlot(uint8_t s)
+    {
+        for (uint8_t t = 0; t < Pattern::MAX_TRACKS; ++t)
+            slots_[s].tracks[t].clear();
+    }
+
+    void drop(uint8_t s)
+    {
+        clearSlot(s);
+        used_[s] = false;
+    }
+
+    // Least recently visited version: the bottom of the undo stack, else the far end of redo
+    void evictOldest()
+    {
+        if (undoN_)
+        {
+            drop(undo_[0]);
+            for (uint8_t i = 1; i < undoN_; ++i)
+                undo_[i - 1] = undo_[i];
+            undoN_--;
+        }
+        else if (redoN_)
+        {
+            drop(redo_[0]);
+            for (uint8_t i = 1; i < redoN_; ++i)
+                redo_[i - 1] = redo_[i];
+            redoN_--;
+        }
+        evicted_++;
+    }
+};
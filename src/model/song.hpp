@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include "pattern.hpp"
+#include "config.hpp"
+
+// Patterns a song can reference by index
+struct PatternBank
+{
+    static constexpr uint8_t SIZE = cfg::BANK_PATTERNS;
+    Pattern slots[SIZE];
+};
+
+// One chain step: bank index plus how many times it loops (2 bytes)
+struct ChainEntry
+{
+    uint8_t pat;
+    uint8_t repeats; // >= 1
+};
+
+/**
+ * Song arrangement: an ordered chain of pattern bank references.
+ */
+struct Song
+{
+    static constexpr uint8_t MAX_ENTRIES = cfg::SONG_MAX_ENTRIES;
+    static constexpr uint8_t END = 0xFF;
+
+    ChainEntry chain[MAX_ENTRIES]{};
+    uint8_t length{0};
+    bool loop{true}; // wrap to the first entry after the last
+
+    bool append(uint8_t pat, uint8_t repeats)
+    {
+        if (length >= MAX_ENTRIES || pat >= PatternBank::SIZE)
+            return false;
+        chain[length++] = ChainEntry{pat, repeats ? repeats : (uint8_t)1};
+        return true;
+    }
+    void clear() { length = 0; }
+
+    uint8_t next(uint8_t e) const
+    {
+        if (e + 1 < length)
+            return e + 1;
+        return (loop && length) ? 0 : END;
+    }
+
+    // Transport ticks from the song start to the start of entry e
+    uint32_t offsetOf(uint8_t e, const PatternBank &bank) const
+    {
+        uint32_t t = 0;
+        for (uint8_t i = 0; i < e && i < length; ++i)
+            t += bank.slots[chain[i].pat].ticks() * chain[i].repeats;
+        return t;
+    }
+};
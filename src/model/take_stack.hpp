@@ -0,0 +1,214 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include "note.hpp"
+#include "pattern.hpp"
+
+/**
+ * Loop-recording takes. Every take is a run of PackedNotes in one fixed
+ * buffer (8 B a note, appended in the order they are committed) plus a small
+ * descriptor: track, active flag. Takes are kept oldest first and only the
+ * newest one is ever open for writing, so recording is a plain append.
+ *
+ * The RAM budget is the buffer itself: a take that needs room evicts whole
+ * older takes, inactive ones first, and compacts the buffer behind them.
+ *
+ * Timeline compiles a track from its notes plus its active takes; rev(t)
+ * changes only when that set changes, so inactive takes cost nothing at
+ * compile time and no take costs anything per tick. PackedNote keeps the
+ * start to 1/256 note tick (micro_q8 fits its int8), so recorded timing
+ * survives at any clock divisor.
+ */
+class TakeStack
+{
+public:
+    static constexpr uint16_t CAP = 2048;  // notes in the buffer (16 KB)
+    static constexpr uint8_t MAX_TAKES = 32;
+    static constexpr uint8_t NONE = 0xFF;
+
+    struct Take
+    {
+        uint16_t first, count; // run in the buffer
+        uint16_t id;           // never reused, shown to the user
+        uint8_t trk;
+        bool active;
+    };
+
+    // New takes of a track play alone (false) or on top of its active takes (true)
+    void setStacking(bool on) { stack_ = on; }
+    bool stacking() const { return stack_; }
+
+    uint8_t count() const { return n_; }
+    const Take &take(uint8_t i) const { return takes_[i]; }
+    Note note(uint8_t i, uint16_t k) const { return buf_[takes_[i].first + k].unpack(); }
+    uint16_t used() const { return used_; }
+    uint32_t evicted() const { return evicted_; }
+    uint32_t dropped() const { return dropped_; }
+    // Index of the take open for recording, NONE if closed
+    uint8_t open() const { return open_ ? n_ - 1 : NONE; }
+
+    // Changes whenever the notes track t gets from its active takes change
+    uint32_t rev(uint8_t t) const { return t < Pattern::MAX_TRACKS ? rev_[t] : 0; }
+    bool any(uint8_t t) const
+    {
+        for (uint8_t i = 0; i < n_; ++i)
+            if (takes_[i].trk == t && takes_[i].active)
+                return true;
+        return false;
+    }
+
+    // Visit the notes of track t's active takes (Timeline::compile)
+    template <class F>
+    void forEachActive(uint8_t t, F &&f) const
+    {
+        for (uint8_t i = 0; i < n_; ++i)
+            if (takes_[i].trk == t && takes_[i].active)
+                for (uint16_t k = 0; k < takes_[i].count; ++k)
+                    f(buf_[takes_[i].first + k].unpack());
+    }
+
+    // Start a take on track trk (closes the open one); it becomes active
+    bool begin(uint8_t trk)
+    {
+        close();
+        if (trk >= Pattern::MAX_TRACKS)
+            return false;
+        if (n_ == MAX_TAKES && !evictOne())
+            return false;
+        if (!stack_)
+            for (uint8_t i = 0; i < n_; ++i)
+                if (takes_[i].trk == trk)
+                    takes_[i].active = false;
+        takes_[n_++] = Take{used_, 0, ++ids_, trk, true};
+        open_ = true;
+        bump(trk);
+        return true;
+    }
+    void close() { open_ = false; }
+
+    // Append to the open take, evicting older takes for room
+    bool append(const Note &n)
+    {
+        if (!open_ || (used_ == CAP && !evictOne()))
+        {
+            dropped_++;
+            return false;
+        }
+        Take &t = takes_[n_ - 1];
+        buf_[used_++] = PackedNote::pack(n);
+        t.count++;
+        if (t.active)
+            bump(t.trk);
+        return true;
+    }
+
+    void setActive(uint8_t i, bool on)
+    {
+        if (i >= n_ || takes_[i].active == on)
+            return;
+        takes_[i].active = on;
+        bump(takes_[i].trk);
+    }
+    // Play take i alone on its track
+    void audition(uint8_t i)
+    {
+        if (i >= n_)
+            return;
+        for (uint8_t k = 0; k < n_; ++k)
+            if (takes_[k].trk == takes_[i].trk)
+                takes_[k].active = k == i;
+        bump(takes_[i].trk);
+    }
+    void remove(uint8_t i)
+    {
+        if (i >= n_)
+            return;
+        if (i == n_ - 1)
+            open_ = false;
+        const Take gone = takes_[i];
+        memmove(buf_ + gone.first, buf_ + gone.first + gone.count, (used_ - gone.first - gone.count) * sizeof(PackedNote));
+        used_ -= gone.count;
+        for (uint8_t k = i; k + 1 < n_; ++k)
+        {
+            takes_[k] = takes_[k + 1];
+            takes_[k].first -= gone.count;
+        }
+        n_--;
+        if (gone.active)
+            bump(gone.trk);
+    }
+    // Drop track t's takes (all tracks: NONE)
+    void clear(uint8_t t = NONE)
+    {
+        for (uint8_t i = n_; i-- > 0;)
+            if (t == NONE || takes_[i].trk == t)
+                remove(i);
+    }
+
+    // Copy take i's notes starting in [from, to) into trk, replacing what it
+    // had there (comping). Returns false if the note pool ran out.
+    bool comp(uint8_t i, Track &trk, uint32_t from, uint32_t to) const
+    {
+        if (i >= n_)
+            return false;
+        for (size_t k = trk.notes.size(); k-- > 0;)
+        {
+            const uint32_t on = trk.notes.onAt(k);
+            if (on >= from && on < to)
+                trk.notes.erase(k);
+        }
+        bool ok = true;
+        for (uint16_t k = 0; k < takes_[i].count; ++k)
+        {
+            const Note n = note(i, k);
+            if (n.on >= from && n.on < to)
+                ok = trk.notes.push_back(n) && ok;
+        }
+        return ok;
+    }
+    // Merge track t's active takes into its notes and drop them
+    bool flatten(uint8_t t, Track &trk)
+    {
+        bool ok = true;
+        forEachActive(t, [&](const Note &n) { ok = trk.notes.push_back(n) && ok; });
+        for (uint8_t i = n_; i-- > 0;)
+            if (takes_[i].trk == t && takes_[i].active)
+                remove(i);
+        return ok;
+    }
+
+private:
+    PackedNote buf_[CAP];
+    Take takes_[MAX_TAKES]{};
+    uint8_t n_{0};
+    uint16_t used_{0};
+    uint16_t ids_{0};
+    bool open_{false};
+    bool stack_{false};
+    uint32_t evicted_{0}, dropped_{0};
+    uint32_t rev_[Pattern::MAX_TRACKS]{};
+    static inline uint32_t revSeq_{0};
+
+    void bump(uint8_t t)
+    {
+        if (t < Pattern::MAX_TRACKS)
+            rev_[t] = ++revSeq_;
+    }
+
+    // Oldest inactive take, else the oldest one; never the open take
+    bool evictOne()
+    {
+        const uint8_t last = open_ ? n_ - 1 : n_;
+        uint8_t v = NONE;
+        for (uint8_t i = 0; i < last && v == NONE; ++i)
+            if (!takes_[i].active)
+                v = i;
+        if (v == NONE && last)
+            v = 0;
+        if (v == NONE)
+            return false;
+        remove(v);
+        evicted_++;
+        return true;
+    }
+};
@@ -1,16 +1,49 @@
 #pragma once
-#include <vector>
-#include "note.hpp"
+#include <utility>
+#include "note_store.hpp"
+
+// Non-destructive quantize: applied when the track is compiled (Timeline),
+// the recorded timing stays in the notes
+struct Quantize
+{
+    uint8_t strength{0}; // percent of the way to the nearest pattern step (0 = as played)
+    uint8_t window{100}; // percent of half a step: notes farther off stay as played
+
+    bool active() const { return strength != 0; }
+    bool operator!=(const Quantize &o) const { return strength != o.strength || window != o.window; }
+};
 
 struct Track
 {
-    std::vector<Note> notes;
+    NoteStore notes; // SoA columns, see note_store.hpp
 
     uint8_t channel{13}; // 1-16
+    bool mute{false};
     uint32_t steps{0};  // 0 – use pattern length
+    uint8_t clockDiv{1}; // 1 – pattern rate, 2 – half time, ...
+    Quantize quant;
 
     void clear()
     {
         notes.clear();
     }
+    // Deep copy of notes and settings; false if the note pool ran out
+    bool assign(const Track &o)
+    {
+        channel = o.channel;
+        mute = o.mute;
+        steps = o.steps;
+        clockDiv = o.clockDiv;
+        quant = o.quant;
+        return notes.assign(o.notes);
+    }
+    void swap(Track &o)
+    {
+        notes.swap(o.notes);
+        std::swap(channel, o.channel);
+        std::swap(mute, o.mute);
+        std::swap(steps, o.steps);
+        std::swap(clockDiv, o.clockDiv);
+        std::swap(quant, o.quant);
+    }
 };
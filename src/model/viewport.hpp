@@ -30,12 +30,11 @@ struct Viewport
     void zoom_ticks(float f, uint32_t max = 0, int anchor_px = W / 2)
     {
         uint32_t old = tickSpan;
-        uint32_t ns = uint32_t(tickSpan / f);
+        float nf = tickSpan / f;
+        uint32_t ns = nf > float(UINT32_MAX / 2) ? UINT32_MAX / 2 : uint32_t(nf);
         if (ns < 64)
             ns = 64;
-        if (ns > 65536)
-            ns = 65536;
-        tickSpan = ns;
+        tickSpan = ns; // upper bound is the pattern length (clamp below)
         uint64_t anchorTick = tickStart + (uint64_t)old * anchor_px / W;
         tickStart = (anchorTick > (uint64_t)tickSpan * anchor_px / W)
                         ? uint32_t(anchorTick - (uint64_t)tickSpan * anchor_px / W)
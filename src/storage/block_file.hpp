@@ -0,0 +1,121 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#ifdef ARDUINO
+#include <SD.h>
+#else
+#include <stdio.h>
+#endif
+
+/**
+ * Minimal random-access file for the storage formats: an SD card File on the
+ * Teensy, stdio on the host so the same format code can be round-trip tested
+ * and benchmarked on Linux against ordinary files.
+ */
+class BlockFile
+{
+public:
+    BlockFile() = default;
+    ~BlockFile() { close(); }
+    BlockFile(const BlockFile &) = delete;
+    BlockFile &operator=(const BlockFile &) = delete;
+
+    // rw: open for reading and writing, creating the file if it does not exist
+    bool open(const char *path, bool rw)
+    {
+        close();
+#ifdef ARDUINO
+        f_ = SD.open(path, rw ? FILE_WRITE : FILE_READ);
+        open_ = (bool)f_;
+        return open_;
+#else
+        f_ = fopen(path, rw ? "r+b" : "rb");
+        if (!f_ && rw)
+            f_ = fopen(path, "w+b");
+        return f_ != nullptr;
+#endif
+    }
+
+    bool isOpen() const
+    {
+#ifdef ARDUINO
+        return open_;
+#else
+        return f_ != nullptr;
+#endif
+    }
+
+    void close()
+    {
+#ifdef ARDUINO
+        if (open_)
+            f_.close();
+        open_ = false;
+#else
+        if (f_)
+            fclose(f_);
+        f_ = nullptr;
+#endif
+    }
+
+    bool seek(uint32_t pos)
+    {
+#ifdef ARDUINO
+        return open_ && f_.seek(pos);
+#else
+        return f_ && fseek(f_, (long)pos, SEEK_SET) == 0;
+#endif
+    }
+
+    uint32_t size()
+    {
+#ifdef ARDUINO
+        return open_ ? (uint32_t)f_.size() : 0;
+#else
+        if (!f_)
+            return 0;
+        long here = ftell(f_);
+        fseek(f_, 0, SEEK_END);
+        long end = ftell(f_);
+        fseek(f_, here, SEEK_SET);
+        return end < 0 ? 0 : (uint32_t)end;
+#endif
+    }
+
+    size_t read(void *dst, size_t n)
+    {
+#ifdef ARDUINO
+        return open_ ? f_.read(dst, n) : 0;
+#else
+        return f_ ? fread(dst, 1, n, f_) : 0;
+#endif
+    }
+
+    size_t write(const void *src, size_t n)
+    {
+#ifdef ARDUINO
+        return open_ ? f_.write((const uint8_t *)src, n) : 0;
+#else
+        return f_ ? fwrite(src, 1, n, f_) : 0;
+#endif
+    }
+
+    void flush()
+    {
+#ifdef ARDUINO
+        if (open_)
+            f_.flush();
+#else
+        if (f_)
+            fflush(f_);
+#endif
+    }
+
+private:
+#ifdef ARDUINO
+    File f_;
+    bool open_{false};
+#else
+    FILE *f_{nullptr};
+#endif
+};
@@ -0,0 +1,499 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "model/pattern.hpp"
+#include "storage/block_file.hpp"
+
+/**
+ * Pattern bank file, version 2 (little-endian, as on both the Teensy and x86).
+ *
+ *   Header        16 B
+ *   IndexEntry    12 B x SLOTS   (offset 0 = empty slot)
+ *   records...    appended; a rewritten slot points at its new record
+ *
+ * The replaced record stays behind as dead bytes until a compaction pass
+ * slides the live records down over them and pulls the end marker back (the
+ * file keeps its size on the card, but later saves reuse the space).
+ *
+ * A record is a PatternHeader followed, per track, by a TrackHeader and the
+ * track's note pages as raw column images (PAGE_BYTES each), so loading is one
+ * seek to the indexed offset and a sequential read straight into pool pages.
+ * A GrooveRecord follows the PatternHeader when its GROOVE flag is set, and
+ * a TrackExt follows every TrackHeader when TRACK_EXT is set.
+ * Version 1 records (320 B pages, no trig columns) still load: the index
+ * entry says which page image a record holds.
+ */
+namespace pattern_file
+{
+    constexpr uint32_t MAGIC = 0x42514D53; // "SMQB"
+    constexpr uint16_t VERSION = 2;
+    constexpr uint16_t SLOTS = 256;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t slots;
+        uint32_t end; // first free byte after the last record
+        uint32_t reserved;
+    };
+    struct IndexEntry
+    {
+        uint32_t offset;
+        uint32_t bytes;
+        uint16_t notes;
+        uint8_t tracks;
+        uint8_t layout; // page image version of the record (0 in version 1 files)
+    };
+    struct PatternHeader
+    {
+        float tempo;
+        uint16_t steps;
+        uint8_t grid;
+        uint8_t trackCount;
+        uint8_t sel;
+        uint8_t flags;    // PatternFlags (zero in older files)
+        uint16_t stepsHi; // steps bits 16..31 (zero in files from 16-bit builds)
+    };
+    enum PatternFlags : uint8_t
+    {
+        GROOVE = 0x01,    // a GrooveRecord follows the PatternHeader
+        TRACK_EXT = 0x02, // a TrackExt follows every TrackHeader
+    };
+    struct TrackExt
+    {
+        uint8_t quantStrength;
+        uint8_t quantWindow;
+        uint8_t reserved[2];
+    };
+    struct GrooveRecord
+    {
+        uint8_t steps;
+        uint8_t stepTicks;
+        int16_t shift_q8[Groove::MAX_STEPS];
+        int8_t vel[Groove::MAX_STEPS];
+    };
+    struct TrackHeader
+    {
+        uint16_t notes;
+        uint16_t steps;
+        uint8_t channel;
+        uint8_t mute;
+        uint8_t clockDiv;
+        uint8_t stepsHi; // steps bits 16..23
+    };
+
+    // Column data of a NotePage, without the allocator bookkeeping behind it
+    constexpr size_t PAGE_BYTES = offsetof(NotePage, next);
+    constexpr size_t V1_PAGE_BYTES = offsetof(NotePage, skip); // columns up to micro
+    constexpr uint32_t DATA_START = sizeof(Header) + SLOTS * sizeof(IndexEntry);
+    // A save that leaves more dead than live bytes, and at least this many, starts a compaction
+    constexpr uint32_t COMPACT_DEAD = 256 * 1024;
+    constexpr size_t COPY_CHUNK = 256; // compaction copy per step piece
+
+    static_assert(sizeof(Header) == 16 && sizeof(IndexEntry) == 12, "pattern file layout");
+    static_assert(sizeof(PatternHeader) == 12 && sizeof(TrackHeader) == 8, "pattern file layout");
+    static_assert(sizeof(GrooveRecord) == 50 && sizeof(TrackExt) == 4, "pattern file layout");
+    static_assert(PAGE_BYTES == 384 && V1_PAGE_BYTES == 320, "NotePage columns changed: bump VERSION");
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "pattern file is little-endian");
+}
+
+/**
+ * Indexed pattern bank on a BlockFile. The index lives in RAM after open().
+ * load() is synchronous (one seek, sequential reads). Saving is incremental:
+ * saveBegin() takes a copy-on-write snapshot of the pattern, and saveStep()
+ * writes roughly `budget` bytes per call from the main loop, so a save never
+ * holds up the tick loop for longer than one small SD write. The index entry
+ * is only rewritten after the whole record is on the card.
+ *
+ * compactBegin() runs through the same steps. Each live record, in file
+ * order, is copied down to the end of the previous one and its index entry
+ * repointed once the copy is complete; a record that would overlap its own
+ * destination goes through the free space past the end marker first, so a
+ * power cut at any point leaves every slot pointing at an intact record.
+ */
+class PatternFile
+{
+public:
+    struct Stats
+    {
+        uint32_t loads, saves, failures;
+        uint32_t bytesRead, bytesWritten;
+        uint32_t compactions;
+    };
+
+    // Open an existing bank or format a new (empty) file
+    bool open(const char *path)
+    {
+        using namespace pattern_file;
+        saving_ = false;
+        if (!f_.open(path, true))
+            return false;
+        if (f_.size() == 0)
+            return format();
+        if (!f_.seek(0) || !readAll(&hdr_, sizeof(hdr_)) || hdr_.magic != MAGIC ||
+            !hdr_.version || hdr_.version > VERSION || hdr_.slots != SLOTS || !readAll(index_, sizeof(index_)))
+        {
+            f_.close();
+            return false;
+        }
+        return true;
+    }
+    void close()
+    {
+        saving_ = false;
+        dropSnapshot();
+        f_.close();
+    }
+    bool isOpen() const { return f_.isOpen(); }
+
+    uint16_t slots() const { return pattern_file::SLOTS; }
+    bool used(uint16_t slot) const { return slot < pattern_file::SLOTS && index_[slot].offset != 0; }
+    const pattern_file::IndexEntry &entry(uint16_t slot) const { return index_[slot]; }
+    uint32_t fileEnd() const { return hdr_.end; }
+    // Bytes below the end marker no index entry points at (records replaced by later saves)
+    uint32_t deadBytes() const
+    {
+        uint32_t live = 0;
+        for (uint16_t s = 0; s < pattern_file::SLOTS; ++s)
+            live += used(s) ? index_[s].bytes : 0;
+        return hdr_.end - pattern_file::DATA_START - live;
+    }
+    const Stats &stats() const { return stats_; }
+
+    bool load(uint16_t slot, Pattern &dst)
+    {
+        using namespace pattern_file;
+        if (!used(slot) || !f_.seek(index_[slot].offset))
+            return fail();
+        PatternHeader ph;
+        if (!readAll(&ph, sizeof(ph)) || ph.trackCount > Pattern::MAX_TRACKS)
+            return fail();
+        for (uint8_t t = 0; t < Pattern::MAX_TRACKS; ++t)
+        {
+            dst.tracks[t].clear();
+            dst.tracks[t].mute = false;
+            dst.tracks[t].steps = 0;
+            dst.tracks[t].clockDiv = 1;
+            dst.tracks[t].quant = Quantize{};
+        }
+        dst.tempo = ph.tempo;
+        const uint32_t steps = ph.steps | (uint32_t)ph.stepsHi << 16;
+        dst.steps = steps && steps <= Pattern::MAX_STEPS ? steps : 64;
+        dst.grid = ph.grid;
+        dst.trackCount = ph.trackCount ? ph.trackCount : 1;
+        dst.sel = ph.sel < dst.trackCount ? ph.sel : 0;
+        dst.groove.clear();
+        if (ph.flags & GROOVE)
+        {
+            GrooveRecord gr;
+            if (!readAll(&gr, sizeof(gr)))
+                return fail();
+            if (gr.steps <= Groove::MAX_STEPS && gr.stepTicks)
+            {
+                dst.groove.steps = gr.steps;
+                dst.groove.stepTicks = gr.stepTicks;
+                memcpy(dst.groove.shift_q8, gr.shift_q8, sizeof(gr.shift_q8));
+                memcpy(dst.groove.vel, gr.vel, sizeof(gr.vel));
+            }
+        }
+        for (uint8_t t = 0; t < ph.trackCount; ++t)
+        {
+            TrackHeader th;
+            if (!readAll(&th, sizeof(th)))
+                return fail();
+            Track &trk = dst.tracks[t];
+            trk.channel = th.channel;
+            trk.mute = th.mute != 0;
+            trk.steps = th.steps | (uint32_t)th.stepsHi << 16;
+            if (trk.steps > Pattern::MAX_STEPS)
+                trk.steps = 0;
+            trk.clockDiv = th.clockDiv ? th.clockDiv : 1;
+            if (ph.flags & TRACK_EXT)
+            {
+                TrackExt te;
+                if (!readAll(&te, sizeof(te)))
+                    return fail();
+                trk.quant.strength = te.quantStrength <= 100 ? te.quantStrength : 100;
+                trk.quant.window = te.quantWindow && te.quantWindow <= 100 ? te.quantWindow : 100;
+            }
+            const bool v1 = index_[slot].layout < 2;
+            if (!trk.notes.fill(th.notes, [&](NotePage &pg)
+                                {
+                                    if (!v1)
+                                        return readAll(&pg, PAGE_BYTES);
+                                    memset(pg.skip, 0, PAGE_BYTES - V1_PAGE_BYTES); // no trigs: always play
+                                    return readAll(&pg, V1_PAGE_BYTES);
+                                }))
+                return fail();
+        }
+        stats_.loads++;
+        return true;
+    }
+
+    // Start writing `src` into `slot`; false while another save is running
+    bool saveBegin(uint16_t slot, const Pattern &src)
+    {
+        if (saving_ || !isOpen() || slot >= pattern_file::SLOTS || !snap_.assign(src))
+            return false;
+        slot_ = slot;
+        rec_ = hdr_.end;
+        pos_ = rec_;
+        t_ = 0;
+        pg_ = 0;
+        phase_ = Phase::Pattern;
+        saving_ = true;
+        return true;
+    }
+
+    // Start squeezing out the dead bytes; false while a save or compaction is running
+    bool compactBegin()
+    {
+        if (saving_ || !isOpen())
+            return false;
+        startCompact();
+        saving_ = true;
+        return true;
+    }
+
+    // Write the next part of a pending save or compaction; returns true while still busy
+    bool saveStep(size_t budget = 512)
+    {
+        if (!saving_)
+            return false;
+        if (!f_.seek(pos_))
+            return abortSave();
+        size_t done = 0;
+        while (saving_ && done < budget)
+        {
+            size_t n = piece();
+            if (n == SIZE_MAX)
+                return abortSave();
+            done += n;
+        }
+        return saving_;
+    }
+    bool busy() const { return saving_; }
+    bool compacting() const { return saving_ && (phase_ == Phase::Compact || phase_ == Phase::Move); }
+
+private:
+    enum class Phase : uint8_t { Pattern, Track, Pages, Commit, Compact, Move };
+
+    BlockFile f_;
+    pattern_file::Header hdr_{};
+    pattern_file::IndexEntry index_[pattern_file::SLOTS]{};
+    Stats stats_{};
+
+    // Pending save
+    Pattern snap_;
+    bool saving_{false};
+    Phase phase_{Phase::Pattern};
+    uint16_t slot_{0};
+    uint32_t rec_{0}, pos_{0};
+    uint8_t t_{0};
+    uint16_t pg_{0};
+    uint32_t notes_{0};
+    bool ext_{false}; // record carries TrackExt
+
+    // Pending compaction: records starting below scan_ are in place, the next one goes to dst_
+    uint32_t dst_{0}, scan_{0};
+    uint32_t stage_{0}; // end marker when the pass started: free space for overlapping moves
+    struct Move
+    {
+        uint16_t slot;
+        uint32_t from, to, bytes, done;
+    } mv_{};
+
+    bool readAll(void *dst, size_t n)
+    {
+        size_t r = f_.read(dst, n);
+        stats_.bytesRead += (uint32_t)r;
+        return r == n;
+    }
+    bool writeAll(const void *src, size_t n)
+    {
+        size_t w = f_.write(src, n);
+        stats_.bytesWritten += (uint32_t)w;
+        pos_ += (uint32_t)w;
+        return w == n;
+    }
+    bool fail()
+    {
+        stats_.failures++;
+        return false;
+    }
+
+    bool format()
+    {
+        using namespace pattern_file;
+        hdr_ = Header{MAGIC, VERSION, SLOTS, DATA_START, 0};
+        memset(index_, 0, sizeof(index_));
+        if (!f_.seek(0) || !writeAll(&hdr_, sizeof(hdr_)) || !writeAll(index_, sizeof(index_)))
+            return fail();
+        f_.flush();
+        return true;
+    }
+
+    // Write the next record piece; returns its size, SIZE_MAX on error
+    size_t piece()
+    {
+        using namespace pattern_file;
+        switch (phase_)
+        {
+        case Phase::Pattern:
+        {
+            const Groove &g = snap_.groove;
+            ext_ = false;
+            for (uint8_t t = 0; t < snap_.trackCount; ++t)
+                ext_ = ext_ || snap_.tracks[t].quant != Quantize{};
+            PatternHeader ph{snap_.tempo, (uint16_t)snap_.steps, snap_.grid, snap_.trackCount, snap_.sel,
+                             (uint8_t)((g.active() ? GROOVE : 0) | (ext_ ? TRACK_EXT : 0)),
+                             (uint16_t)(snap_.steps >> 16)};
+            notes_ = 0;
+            phase_ = snap_.trackCount ? Phase::Track : Phase::Commit;
+            if (!writeAll(&ph, sizeof(ph)))
+                return SIZE_MAX;
+            if (!g.active())
+                return sizeof(ph);
+            GrooveRecord gr{g.steps, g.stepTicks, {}, {}};
+            memcpy(gr.shift_q8, g.shift_q8, sizeof(gr.shift_q8));
+            memcpy(gr.vel, g.vel, sizeof(gr.vel));
+            return writeAll(&gr, sizeof(gr)) ? sizeof(ph) + sizeof(gr) : SIZE_MAX;
+        }
+        case Phase::Track:
+        {
+            const Track &trk = snap_.tracks[t_];
+            TrackHeader th{(uint16_t)trk.notes.size(), (uint16_t)trk.steps, trk.channel,
+                           (uint8_t)trk.mute, trk.clockDiv, (uint8_t)(trk.steps >> 16)};
+            notes_ += th.notes;
+            pg_ = 0;
+            phase_ = trk.notes.pages() ? Phase::Pages : nextTrack();
+            if (!writeAll(&th, sizeof(th)))
+                return SIZE_MAX;
+            if (!ext_)
+                return sizeof(th);
+            TrackExt te{trk.quant.strength, trk.quant.window, {0, 0}};
+            return writeAll(&te, sizeof(te)) ? sizeof(th) + sizeof(te) : SIZE_MAX;
+        }
+        case Phase::Pages:
+        {
+            const NoteStore &ns = snap_.tracks[t_].notes;
+            if (!writeAll(&ns.page(pg_), PAGE_BYTES))
+                return SIZE_MAX;
+            if (++pg_ == ns.pages())
+                phase_ = nextTrack();
+            return PAGE_BYTES;
+        }
+        case Phase::Commit:
+        {
+            // Record is complete: publish it in the index, then move the end marker
+            IndexEntry e{rec_, pos_ - rec_, (uint16_t)(notes_ > 0xFFFF ? 0xFFFF : notes_), snap_.trackCount,
+                         (uint8_t)VERSION};
+            const uint32_t end = pos_;
+            if (!f_.seek(sizeof(Header) + slot_ * sizeof(IndexEntry)) || !writeAll(&e, sizeof(e)))
+                return SIZE_MAX;
+            hdr_.end = end;
+            hdr_.version = VERSION; // a version 1 file now holds version 2 records
+            if (!f_.seek(0) || !writeAll(&hdr_, sizeof(hdr_)))
+                return SIZE_MAX;
+            f_.flush();
+            index_[slot_] = e;
+            stats_.saves++;
+            dropSnapshot();
+            const uint32_t dead = deadBytes();
+            if (dead >= COMPACT_DEAD && dead > end - DATA_START - dead)
+                startCompact();
+            else
+                saving_ = false;
+            return sizeof(e) + sizeof(hdr_);
+        }
+        case Phase::Compact:
+        {
+            // Next live record in file order
+            uint16_t slot = SLOTS;
+            for (uint16_t s = 0; s < SLOTS; ++s)
+                if (used(s) && index_[s].offset >= scan_ && (slot == SLOTS || index_[s].offset < index_[slot].offset))
+                    slot = s;
+            if (slot == SLOTS)
+            {
+                hdr_.end = dst_;
+                if (!f_.seek(0) || !writeAll(&hdr_, sizeof(hdr_)))
+                    return SIZE_MAX;
+                f_.flush();
+                saving_ = false;
+                stats_.compactions++;
+                return sizeof(hdr_);
+            }
+            const IndexEntry &e = index_[slot];
+            scan_ = e.offset + e.bytes;
+            if (e.offset == dst_)
+            {
+                dst_ = scan_;
+                return sizeof(IndexEntry);
+            }
+            // Copy straight down when the gap holds the whole record, else via the free space past the end
+            mv_ = Move{slot, e.offset, dst_ + e.bytes <= e.offset ? dst_ : stage_, e.bytes, 0};
+            phase_ = Phase::Move;
+            return sizeof(IndexEntry);
+        }
+        case Phase::Move:
+        {
+            uint8_t buf[COPY_CHUNK];
+            const size_t n = mv_.bytes - mv_.done < COPY_CHUNK ? mv_.bytes - mv_.done : COPY_CHUNK;
+            if (!f_.seek(mv_.from + mv_.done) || !readAll(buf, n) || !f_.seek(mv_.to + mv_.done) || !writeAll(buf, n))
+                return SIZE_MAX;
+            mv_.done += (uint32_t)n;
+            if (mv_.done < mv_.bytes)
+                return n;
+            // Copy is complete: a staged copy past the end claims its space before the index points at it
+            const bool staged = mv_.to == stage_;
+            if (staged)
+            {
+                hdr_.end = stage_ + mv_.bytes;
+                if (!f_.seek(0) || !writeAll(&hdr_, sizeof(hdr_)))
+                    return SIZE_MAX;
+            }
+            IndexEntry e = index_[mv_.slot];
+            e.offset = mv_.to;
+            if (!f_.seek(sizeof(Header) + mv_.slot * sizeof(IndexEntry)) || !writeAll(&e, sizeof(e)))
+                return SIZE_MAX;
+            f_.flush();
+            index_[mv_.slot] = e;
+            if (staged)
+            {
+                mv_ = Move{mv_.slot, stage_, dst_, mv_.bytes, 0};
+                return n + sizeof(e);
+            }
+            dst_ += mv_.bytes;
+            phase_ = Phase::Compact;
+            return n + sizeof(e);
+        }
+        }
+        return SIZE_MAX;
+    }
+
+    void startCompact()
+    {
+        dst_ = scan_ = pattern_file::DATA_START;
+        stage_ = hdr_.end;
+        phase_ = Phase::Compact;
+    }
+
+    Phase nextTrack() { return ++t_ < snap_.trackCount ? Phase::Track : Phase::Commit; }
+
+    bool abortSave()
+    {
+        saving_ = false;
+        dropSnapshot();
+        return fail();
+    }
+
+    // Let go of the pages shared with the saved pattern
+    void dropSnapshot()
+    {
+        for (uint8_t t = 0; t < Pattern::MAX_TRACKS; ++t)
+            snap_.tracks[t].clear();
+    }
+};
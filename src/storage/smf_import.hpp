@@ -0,0 +1,379 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "model/pattern.hpp"
+#include "storage/block_file.hpp"
+
+/**
+ * Streaming Standard MIDI File (type 0/1) importer.
+ * The file is read through a fixed WINDOW-byte buffer and each note is written
+ * into its Track's NoteStore as soon as its note-off arrives, so memory use is
+ * the window plus a 128-entry (one per pitch) open-note table, whatever the
+ * file size. Times are rescaled to 96 PPQN; the rounding residual of each note
+ * start is kept in micro_q8.
+ *
+ * Every (MTrk, channel) pair that carries notes becomes one pattern track, in
+ * order of appearance, up to Pattern::MAX_TRACKS. A note-on for a pitch that
+ * is still held on another channel of the same MTrk closes the held note.
+ */
+class SmfImporter
+{
+public:
+    static constexpr size_t WINDOW = 512;
+    static constexpr uint16_t PPQN = 96;
+
+    struct Result
+    {
+        const char *error; // nullptr on success
+        uint8_t format;
+        uint16_t chunks;   // MTrk chunks in the file
+        uint16_t division; // source ticks per quarter note
+        uint32_t events;   // channel/meta/sysex events parsed
+        uint32_t notes;    // notes stored
+        uint32_t dropped;  // notes that did not fit (pool, track limit)
+        uint32_t unmatched; // note-offs without a note-on, plus notes closed at track end
+        uint32_t lengthTicks; // end of the last note, 96 PPQN
+        float bpm;            // first tempo meta event, 0 if none
+    };
+
+    // Replace dst's tracks with the file's notes; dst's length is set to cover
+    // them (whole bars, up to Pattern::MAX_STEPS)
+    Result import(const char *path, Pattern &dst)
+    {
+        res_ = Result{};
+        if (!f_.open(path, false))
+            return failed("cannot open file");
+        rd_.begin(&f_);
+
+        uint32_t len = 0;
+        if (!chunk("MThd", len) || len < 6)
+            return failed("not a MIDI file");
+        uint16_t fmt = 0, ntrk = 0, div = 0;
+        if (!rd_.u16(fmt) || !rd_.u16(ntrk) || !rd_.u16(div) || !rd_.skip(len - 6))
+            return failed("truncated header");
+        if (fmt > 1)
+            return failed("type 2 files are not supported");
+        if (!div || (div & 0x8000))
+            return failed("SMPTE time division is not supported");
+        res_.format = (uint8_t)fmt;
+        res_.division = div;
+
+        dst_ = &dst;
+        for (uint8_t t = 0; t < Pattern::MAX_TRACKS; ++t)
+        {
+            dst.tracks[t].clear();
+            dst.tracks[t].mute = false;
+            dst.tracks[t].steps = 0;
+            dst.tracks[t].clockDiv = 1;
+        }
+        used_ = 0;
+
+        for (uint16_t i = 0; i < ntrk; ++i)
+        {
+            if (!chunk("MTrk", len))
+            {
+                if (rd_.eof())
+                    break; // fewer chunks than announced: keep what we have
+                return failed("bad track chunk");
+            }
+            res_.chunks++;
+            if (!track(len))
+                return failed("truncated track");
+        }
+        f_.close();
+
+        dst.trackCount = used_ ? used_ : 1;
+        dst.sel = 0;
+        dst.grid = 16;
+        const uint32_t bar = PPQN * 4, step = timebase::ticksPerStep(dst.grid);
+        uint32_t bars = (res_.lengthTicks + bar - 1) / bar;
+        uint32_t steps = (bars ? bars : 1) * (bar / step);
+        dst.steps = steps > Pattern::MAX_STEPS ? Pattern::MAX_STEPS : steps;
+        if (res_.bpm > 0)
+            dst.tempo = res_.bpm;
+        return res_;
+    }
+
+private:
+    // Sequential reader over a fixed window
+    class Reader
+    {
+    public:
+        void begin(BlockFile *f)
+        {
+            f_ = f;
+            pos_ = len_ = 0;
+            eof_ = false;
+        }
+        bool eof() const { return eof_; }
+        bool byte(uint8_t &b)
+        {
+            if (pos_ == len_ && !fill())
+                return false;
+            b = buf_[pos_++];
+            return true;
+        }
+        bool skip(uint32_t n)
+        {
+            while (n)
+            {
+                if (pos_ == len_ && !fill())
+                    return false;
+                uint32_t k = len_ - pos_;
+                if (k > n)
+                    k = n;
+                pos_ += k;
+                n -= k;
+            }
+            return true;
+        }
+        bool u16(uint16_t &v)
+        {
+            uint8_t a, b;
+            if (!byte(a) || !byte(b))
+                return false;
+            v = (uint16_t)(a << 8 | b);
+            return true;
+        }
+        bool u32(uint32_t &v)
+        {
+            uint16_t a, b;
+            if (!u16(a) || !u16(b))
+                return false;
+            v = (uint32_t)a << 16 | b;
+            return true;
+        }
+        // Variable-length quantity; `used` counts the bytes consumed
+        bool vlq(uint32_t &v, uint32_t &used)
+        {
+            v = 0;
+            for (uint8_t i = 0; i < 4; ++i)
+            {
+                uint8_t b;
+                if (!byte(b))
+                    return false;
+                used++;
+                v = (v << 7) | (b & 0x7F);
+                if (!(b & 0x80))
+                    return true;
+            }
+            return false;
+        }
+
+    private:
+        BlockFile *f_{nullptr};
+        uint8_t buf_[WINDOW];
+        size_t pos_{0}, len_{0};
+        bool eof_{false};
+
+        bool fill()
+        {
+            len_ = f_ ? f_->read(buf_, WINDOW) : 0;
+            pos_ = 0;
+            eof_ = len_ == 0;
+            return len_ != 0;
+        }
+    };
+
+    struct Open
+    {
+        uint32_t on; // 96 PPQN
+        int8_t micro;
+        uint8_t vel;
+        uint8_t ch; // 0xFF = free
+    };
+
+    BlockFile f_;
+    Reader rd_;
+    Result res_{};
+    Pattern *dst_{nullptr};
+    uint8_t used_{0};
+    uint8_t dest_[16]{}; // channel → pattern track for the current MTrk (0xFF = none yet)
+    Open open_[128]{};
+
+    Result failed(const char *why)
+    {
+        f_.close();
+        res_.error = why;
+        return res_;
+    }
+
+    bool chunk(const char *id, uint32_t &len)
+    {
+        for (;;)
+        {
+            uint8_t tag[4];
+            for (uint8_t i = 0; i < 4; ++i)
+                if (!rd_.byte(tag[i]))
+                    return false;
+            if (!rd_.u32(len))
+                return false;
+            if (tag[0] == id[0] && tag[1] == id[1] && tag[2] == id[2] && tag[3] == id[3])
+                return true;
+            if (!rd_.skip(len)) // unknown chunk type: skip it
+                return false;
+        }
+    }
+
+    // Source ticks → 96 PPQN, rounded, with the residual in 1/256 tick
+    uint32_t scale(uint64_t src, int8_t *micro) const
+    {
+        const uint64_t num = src * PPQN, div = res_.division;
+        const uint64_t t = (num + div / 2) / div;
+        if (micro)
+        {
+            int64_t resid = (int64_t)num - (int64_t)(t * div); // [-div/2, div/2)
+            int64_t q8 = resid * 256 / (int64_t)div;
+            *micro = (int8_t)(q8 < -128 ? -128 : (q8 > 127 ? 127 : q8));
+        }
+        return (uint32_t)t;
+    }
+
+    bool track(uint32_t len)
+    {
+        for (auto &o : open_)
+            o.ch = 0xFF;
+        for (auto &d : dest_)
+            d = 0xFF;
+
+        uint64_t now = 0;
+        uint8_t status = 0;
+        uint32_t used = 0;
+        while (used < len)
+        {
+            uint32_t delta;
+            if (!rd_.vlq(delta, used))
+                return false;
+            now += delta;
+
+            uint8_t b;
+            if (!rd_.byte(b))
+                return false;
+            used++;
+            res_.events++;
+
+            if (b == 0xFF) // meta
+            {
+                uint8_t type;
+                uint32_t n;
+                if (!rd_.byte(type))
+                    return false;
+                used++;
+                if (!rd_.vlq(n, used))
+                    return false;
+                used += n;
+                if (type == 0x2F)
+                    break; // end of track
+                if (type == 0x51 && n == 3 && res_.bpm == 0)
+                {
+                    uint8_t a, c, d;
+                    if (!rd_.byte(a) || !rd_.byte(c) || !rd_.byte(d))
+                        return false;
+                    uint32_t us = (uint32_t)a << 16 | (uint32_t)c << 8 | d;
+                    if (us)
+                        res_.bpm = 60000000.f / (float)us;
+                }
+                else if (!rd_.skip(n))
+                    return false;
+                continue;
+            }
+            if (b == 0xF0 || b == 0xF7) // sysex
+            {
+                uint32_t n;
+                if (!rd_.vlq(n, used) || !rd_.skip(n))
+                    return false;
+                used += n;
+                status = 0;
+                continue;
+            }
+
+            uint8_t d1;
+            if (b & 0x80)
+            {
+                status = b;
+                if (!rd_.byte(d1))
+                    return false;
+                used++;
+            }
+            else
+            {
+                if (!status)
+                    return false; // running status without a status byte
+                d1 = b;
+            }
+            const uint8_t kind = status & 0xF0, ch = status & 0x0F;
+            uint8_t d2 = 0;
+            if (kind != 0xC0 && kind != 0xD0)
+            {
+                if (!rd_.byte(d2))
+                    return false;
+                used++;
+            }
+            if (kind == 0x90 && d2)
+                noteOn(now, ch, d1 & 0x7F, d2);
+            else if (kind == 0x80 || kind == 0x90)
+                noteOff(now, ch, d1 & 0x7F);
+        }
+        // Close anything still held when the track ends
+        const uint32_t end = scale(now, nullptr);
+        for (uint8_t p = 0; p < 128; ++p)
+            if (open_[p].ch != 0xFF)
+            {
+                res_.unmatched++;
+                store(p, end);
+            }
+        // Skip whatever follows an early End of Track inside the chunk
+        return used >= len || rd_.skip(len - used);
+    }
+
+    void noteOn(uint64_t now, uint8_t ch, uint8_t pitch, uint8_t vel)
+    {
+        int8_t micro;
+        const uint32_t at = scale(now, &micro);
+        if (open_[pitch].ch != 0xFF)
+            store(pitch, at); // retrigger or same pitch on another channel
+        open_[pitch] = Open{at, micro, vel, ch};
+    }
+
+    void noteOff(uint64_t now, uint8_t ch, uint8_t pitch)
+    {
+        if (open_[pitch].ch != ch)
+        {
+            res_.unmatched++;
+            return;
+        }
+        store(pitch, scale(now, nullptr));
+    }
+
+    void store(uint8_t pitch, uint32_t off)
+    {
+        Open &o = open_[pitch];
+        const uint8_t ch = o.ch;
+        o.ch = 0xFF;
+        if (dest_[ch] == 0xFF)
+        {
+            if (used_ >= Pattern::MAX_TRACKS)
+            {
+                res_.dropped++;
+                return;
+            }
+            dest_[ch] = used_;
+            dst_->tracks[used_++].channel = ch + 1;
+        }
+        Note n{};
+        n.on = o.on;
+        n.duration = off > o.on ? off - o.on : 1;
+        n.micro_q8 = o.micro;
+        n.pitch = pitch;
+        n.vel = o.vel;
+        if (!dst_->tracks[dest_[ch]].notes.push_back(n))
+        {
+            res_.dropped++;
+            return;
+        }
+        res_.notes++;
+        if (o.on + n.duration > res_.lengthTicks)
+            res_.lengthTicks = o.on + n.duration;
+    }
+};
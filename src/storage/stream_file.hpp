@@ -0,0 +1,145 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "storage/block_file.hpp"
+
+/**
+ * Note stream file, version 1 (little-endian): a song-length, time-sorted
+ * event list for StreamPlayer.
+ *
+ *   Header        one block (32 B used)
+ *   Block x N     BLOCK_BYTES each, EVENTS_PER_BLOCK events sorted by `on`
+ *   index         uint32_t first tick of every block (for locate)
+ *
+ * Blocks are fixed-size and block-aligned, so block i is at
+ * BLOCK_BYTES * (i + 1) and a read is one SD sector.
+ */
+namespace stream_file
+{
+    constexpr uint32_t MAGIC = 0x53514D53; // "SMQS"
+    constexpr uint16_t VERSION = 1;
+    constexpr size_t BLOCK_BYTES = 512;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t blockBytes;
+        uint32_t blocks;
+        uint32_t events;
+        uint32_t length; // loop length in ticks
+        uint32_t index;  // file offset of the block index
+        uint32_t reserved[2];
+    };
+    struct Event
+    {
+        uint32_t on; // absolute tick
+        uint16_t duration;
+        int8_t micro; // micro_q8 residual
+        uint8_t ch;   // MIDI channel 1..16
+        uint8_t pitch;
+        uint8_t vel;
+        uint8_t reserved[2];
+    };
+
+    constexpr size_t EVENTS_PER_BLOCK = (BLOCK_BYTES - 8) / sizeof(Event);
+
+    struct Block
+    {
+        uint32_t first; // on of ev[0]
+        uint16_t count;
+        uint16_t reserved;
+        Event ev[EVENTS_PER_BLOCK];
+    };
+
+    inline uint32_t blockOffset(uint32_t b) { return (uint32_t)BLOCK_BYTES * (b + 1); }
+
+    static_assert(sizeof(Header) == 32 && sizeof(Event) == 12, "stream file layout");
+    static_assert(sizeof(Block) == BLOCK_BYTES, "stream block must fill one sector");
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "stream file is little-endian");
+}
+
+/**
+ * Writes a stream file from events added in time order. Only the block being
+ * filled is held in RAM; finish() builds the index with a second pass over
+ * the block headers, in BLOCK_BYTES chunks.
+ */
+class StreamWriter
+{
+public:
+    bool open(const char *path)
+    {
+        events_ = 0;
+        blocks_ = 0;
+        last_ = end_ = 0;
+        blk_.count = 0;
+        if (!f_.open(path, true))
+            return false;
+        stream_file::Header h{};
+        return f_.seek(0) && f_.write(&h, sizeof(h)) == sizeof(h); // placeholder until finish()
+    }
+
+    // Events must come in non-decreasing `on` order
+    bool add(const stream_file::Event &e)
+    {
+        if (!f_.isOpen() || e.on < last_)
+            return false;
+        last_ = e.on;
+        if (!blk_.count)
+            blk_.first = e.on;
+        blk_.ev[blk_.count++] = e;
+        events_++;
+        return blk_.count < stream_file::EVENTS_PER_BLOCK || flushBlock();
+    }
+
+    // Close the stream; `length` 0 = end of the last note
+    bool finish(uint32_t length = 0)
+    {
+        using namespace stream_file;
+        if (!f_.isOpen() || (blk_.count && !flushBlock()))
+            return false;
+        const uint32_t index = blockOffset(blocks_);
+        uint32_t chunk[BLOCK_BYTES / 4];
+        for (uint32_t b = 0; b < blocks_;)
+        {
+            uint32_t n = 0;
+            for (; n < BLOCK_BYTES / 4 && b < blocks_; ++n, ++b)
+                if (!f_.seek(blockOffset(b)) || f_.read(&chunk[n], 4) != 4)
+                    return false;
+            if (!f_.seek(index + (b - n) * 4) || f_.write(chunk, n * 4) != n * 4)
+                return false;
+        }
+        Header h{MAGIC, VERSION, (uint16_t)BLOCK_BYTES, blocks_, events_,
+                 length ? length : (end_ ? end_ : 1), index, {0, 0}};
+        bool ok = f_.seek(0) && f_.write(&h, sizeof(h)) == sizeof(h);
+        f_.flush();
+        f_.close();
+        return ok;
+    }
+
+    uint32_t events() const { return events_; }
+    uint32_t blocks() const { return blocks_; }
+
+private:
+    BlockFile f_;
+    stream_file::Block blk_{};
+    uint32_t events_{0}, blocks_{0};
+    uint32_t last_{0}, end_{0};
+
+    bool flushBlock()
+    {
+        for (uint16_t i = 0; i < blk_.count; ++i)
+        {
+            uint32_t e = blk_.ev[i].on + (blk_.ev[i].duration ? blk_.ev[i].duration : 1);
+            if (e > end_)
+                end_ = e;
+        }
+        for (size_t i = blk_.count; i < stream_file::EVENTS_PER_BLOCK; ++i)
+            blk_.ev[i] = stream_file::Event{};
+        bool ok = f_.seek(stream_file::blockOffset(blocks_)) && f_.write(&blk_, sizeof(blk_)) == sizeof(blk_);
+        blocks_++;
+        blk_.count = 0;
+        return ok;
+    }
+};
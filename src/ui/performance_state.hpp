@@ -12,7 +12,7 @@ enum class PerformanceMode : uint8_t
 struct PerformanceState
 {
   PerformanceMode mode = PerformanceMode::Keyboard;
-  uint8_t channel{1};                  // use Pattern.track.channel at init
+  uint8_t channel{1};                  // use Pattern.selected().channel at init
   int8_t octave{0};                     // MIDI 0–10 (clamped)
   uint8_t root{0};                      // 0=C … 11=B
   uint8_t  velocity{127}; 
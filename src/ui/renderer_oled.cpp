@@ -9,13 +9,15 @@ bool OledRenderer::begin()
     
     return true;
 }
-uint32_t OledRenderer::drawFrame(const Pattern &p, const Viewport &v, uint32_t now, uint32_t playTick, const char *hud)
+uint32_t OledRenderer::drawFrame(const Pattern &p, const Viewport &v, uint32_t now, uint32_t playTick, const char *hud,
+                                 const Timeline *tl)
 {
     uint32_t t0 = now;
+    const Timeline::TrackTimeline *tt = (tl && p.sel < tl->count()) ? &tl->track(p.sel) : nullptr;
     u8g2_.firstPage();
     do
     {
-        pianoRoll_.render(u8g2_, p.track, v, playTick);
+        pianoRoll_.render(u8g2_, p.selected(), v, playTick, tt);
         if (hud)
         {
             u8g2_.setFont(u8g2_font_5x7_tf);
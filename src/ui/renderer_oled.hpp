@@ -12,7 +12,9 @@ class OledRenderer
 
 public:
     bool begin();
-    uint32_t drawFrame(const Pattern &, const Viewport &, uint32_t microsNow, uint32_t playTick = 0, const char *hud = nullptr);
+    // tl: compiled timeline of the pattern (RunLoop::timeline()) so long tracks draw only the visible window
+    uint32_t drawFrame(const Pattern &, const Viewport &, uint32_t microsNow, uint32_t playTick = 0, const char *hud = nullptr,
+                       const Timeline *tl = nullptr);
     
     public: void rollSetOptions(const PianoRoll::Options& o){ pianoRoll_.setOptions(o); }
 
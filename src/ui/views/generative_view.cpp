@@ -5,65 +5,25 @@ void GenerativeView::onEncoderRotation(const EncoderRotationEvent& event)
     Generator* gen = generatorManager_.getCurrentGenerator();
     if (!gen) return;
     
-    switch (event.encoderId)
+    // ENC1-3 and ENC5-8 step the generator's parameters in schema order; ENC4 switches generator
+    if (event.encoderId == 3)
     {
-        case 0: // ENC1: Density parameter
-        {
-            float density = 0;
-            if (gen->getParameter("density", density))
-            {
-                density += event.delta * 5.0f; // Step by 5
-                if (density < 0) density = 0;
-                if (density > 100) density = 100;
-                generatorManager_.setParameter("density", density);
-                Serial.printf("[GenerativeView] ENC1 Density: %.0f\n", density);
-            }
-            break;
-        }
-        case 1: // ENC2: Length parameter
-        {
-            float length = 0;
-            if (gen->getParameter("length", length))
-            {
-                length += event.delta;
-                if (length < 1) length = 1;
-                if (length > 64) length = 64;
-                generatorManager_.setParameter("length", length);
-                Serial.printf("[GenerativeView] ENC2 Length: %.0f\n", length);
-            }
-            break;
-        }
-        case 2: // ENC3: Base note parameter
-        {
-            float baseNote = 0;
-            if (gen->getParameter("base_note", baseNote))
-            {
-                baseNote += event.delta;
-                if (baseNote < 0) baseNote = 0;
-                if (baseNote > 127) baseNote = 127;
-                generatorManager_.setParameter("base_note", baseNote);
-                Serial.printf("[GenerativeView] ENC3 Base Note: %.0f\n", baseNote);
-            }
-            break;
-        }
-        case 3: // ENC4: Switch generator
-        {
-            if (event.delta > 0)
-                switchToNextGenerator();
-            else if (event.delta < 0)
-                switchToPreviousGenerator();
-            break;
-        }
-        case 4: // ENC5-8: Reserved for future parameters
-        case 5:
-        case 6:
-        case 7:
-        {
-            Serial.printf("[GenerativeView] ENC%d delta: %d (not assigned)\n", 
-                         event.encoderId + 1, event.delta);
-            break;
-        }
+        if (event.delta > 0)
+            switchToNextGenerator();
+        else if (event.delta < 0)
+            switchToPreviousGenerator();
+        return;
     }
+    gen::ParamSet& ps = gen->params();
+    const uint8_t i = event.encoderId < 3 ? event.encoderId : event.encoderId - 1;
+    if (i >= ps.count())
+    {
+        Serial.printf("[GenerativeView] ENC%d delta: %d (not assigned)\n", 
+                     event.encoderId + 1, event.delta);
+        return;
+    }
+    ps.adjust(i, event.delta);
+    Serial.printf("[GenerativeView] ENC%d %s: %.2f\n", event.encoderId + 1, ps.desc(i).name, ps.get(i));
 }
 
 void GenerativeView::onEncoderButton(const EncoderButtonEvent& event)
@@ -72,9 +32,9 @@ void GenerativeView::onEncoderButton(const EncoderButtonEvent& event)
     {
         switch (event.encoderId)
         {
-            case 0: // ENC1 SW: Reset density to default
-            case 1: // ENC2 SW: Reset length to default
-            case 2: // ENC3 SW: Reset base_note to default
+            case 0: // ENC1-3 SW: Reset the generator to defaults
+            case 1:
+            case 2:
             {
                 resetToDefaults();
                 Serial.printf("[GenerativeView] ENC%d SW: Reset all to defaults\n", 
@@ -134,14 +94,14 @@ void GenerativeView::draw(Pattern& pattern, Viewport& viewport, OledRenderer& ol
     // Highlight the base note from current generator
     Generator* gen = generatorManager_.getCurrentGenerator();
     if (gen) {
-        float baseNote;
-        if (gen->getParameter("base_note", baseNote)) {
-            options.highlightPitch = (uint8_t)baseNote;
+        const uint8_t i = gen->params().find("base_note");
+        if (i != gen::ParamSet::NONE) {
+            options.highlightPitch = (uint8_t)gen->params().getInt(i);
         }
     }
     
     oled.rollSetOptions(options);
-    oled.drawFrame(pattern, viewport, now, playTick, hud);
+    oled.drawFrame(pattern, viewport, now, playTick, hud, runLoop_ ? &runLoop_->timeline() : nullptr);
 }
 
 void GenerativeView::poll(MidiIO& midi)
@@ -188,7 +148,21 @@ void GenerativeView::triggerGeneration(Pattern& pattern)
     isGenerating_ = true;
     lastGenTime_ = micros();
     
-    generatorManager_.generatePattern(pattern);
+    // Generate into the back buffer; the live pattern keeps playing until the swap boundary
+    PatternSwap *swap = runLoop_ ? &runLoop_->swapper() : nullptr;
+    Pattern *back = swap ? swap->stage() : nullptr;
+    if (back) {
+        runLoop_->history().checkpoint();
+        generatorManager_.generatePattern(*back);
+        swap->commit();
+        Serial.printf("Swap queued (%s)\n", swapQuantName(swap->quant()));
+    } else if (swap && swap->pending()) {
+        Serial.println("Swap still pending, try again after the boundary");
+    } else {
+        if (runLoop_)
+            runLoop_->history().checkpoint();
+        generatorManager_.generatePattern(pattern);
+    }
     
     isGenerating_ = false;
 }
@@ -196,11 +170,20 @@ void GenerativeView::triggerGeneration(Pattern& pattern)
 void GenerativeView::switchToNextGenerator()
 {
     generatorManager_.switchToNextGenerator();
+    followEvolve();
 }
 
 void GenerativeView::switchToPreviousGenerator()
 {
     generatorManager_.switchToPreviousGenerator();
+    followEvolve();
+}
+
+void GenerativeView::followEvolve()
+{
+    // Evolve mode picks its edits with whichever generator is active
+    if (runLoop_ && runLoop_->evolver().armed())
+        runLoop_->evolver().setMutator(generatorManager_.getCurrentGenerator());
 }
 
 void GenerativeView::resetToDefaults()
@@ -211,18 +194,17 @@ void GenerativeView::resetToDefaults()
 void GenerativeView::drawHUD(char* buffer, size_t bufferSize) const
 {
     Generator* gen = generatorManager_.getCurrentGenerator();
-    if (gen) {
-        // Get some key parameters for display
-        float density = 0, length = 0;
-        gen->getParameter("density", density);
-        gen->getParameter("length", length);
-        
-        snprintf(buffer, bufferSize, "GEN:%s D:%.0f L:%.0f %s", 
+    if (gen && gen->params().count() >= 2) {
+        // The first two parameters (ENC1/ENC2)
+        const gen::ParamSet& ps = gen->params();
+        snprintf(buffer, bufferSize, "GEN:%s %s:%.0f %s:%.0f %s", 
                  gen->getShortName(),
-                 density,
-                 length,
+                 ps.desc(0).name, ps.get(0),
+                 ps.desc(1).name, ps.get(1),
                  isGenerating_ ? "..." : "RDY");
+    } else if (gen) {
+        snprintf(buffer, bufferSize, "GEN:%s %s", gen->getShortName(), isGenerating_ ? "..." : "RDY");
     } else {
         snprintf(buffer, bufferSize, "GEN: NO GENERATOR");
     }
-}
\ No newline at end of file
+}
@@ -33,6 +33,8 @@ public:
     void switchToNextGenerator();
     void switchToPreviousGenerator();
     void resetToDefaults();
+    // Hand the active generator to evolve mode (after a switch)
+    void followEvolve();
     
     GeneratorManager& getGeneratorManager() { return generatorManager_; }
     
@@ -97,5 +97,5 @@ void PerformanceView::draw(Pattern &pat, Viewport &vp, OledRenderer &oled, MidiI
     PianoRoll::Options o = {};
     o.highlightPitch = st_.lastPitch;
     oled.rollSetOptions(o);
-    oled.drawFrame(pat, vp, now, playTick, hud);
+    oled.drawFrame(pat, vp, now, playTick, hud, rl_ ? &rl_->timeline() : nullptr);
 }
@@ -34,6 +34,7 @@ public:
     
     void attach(RunLoop* rl, RecordEngine* re, Transport* tx, class ViewManager* vm = nullptr) override
     {
+        rl_ = rl;
         mkb_.attach(rl, re, tx);
         if (vm != nullptr) {
             mkb_.attachViewManager(vm);
@@ -71,4 +72,5 @@ public:
 private:
     PerformanceState st_{};
     MatrixKB mkb_{};
+    RunLoop *rl_{nullptr};
 };
@@ -53,6 +53,11 @@ public:
      */
     IView* getCurrentView() const { return currentView_; }
 
+    /**
+     * Get a registered view by type (nullptr if none).
+     */
+    IView* getView(ViewType viewType) const { return views_[static_cast<size_t>(viewType)]; }
+
     /**
      * Switch to next view in sequence (for easy cycling).
      */
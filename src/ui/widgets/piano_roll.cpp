@@ -12,36 +12,35 @@ int16_t PianoRoll::yFromPitch(uint8_t pitch, const Viewport &v)
 }
 void PianoRoll::drawGrid(U8G2 &u8g2, const Viewport &v)
 {
-    const uint8_t steps = 24; // 1/16 @ PPQN=96
+    const uint32_t BEAT = 96, BAR = 4 * BEAT; // PPQN=96, 4/4
     const int X0 = Layout::GRID_X, X1 = X0 + Layout::GRID_W, H = Layout::H;
 
-    uint32_t step = v.tickStart / steps;
+    // Only visit lines at least 3 px apart: beats, else bars (every 2^k bars zoomed far out),
+    // so the cost stays constant however long the visible span is
+    uint32_t unit = BEAT;
+    while ((uint64_t)unit * Layout::GRID_W < (uint64_t)v.tickSpan * 3)
+        unit = unit < BAR ? BAR : unit * 2;
 
-    for (;; step++)
+    for (uint64_t tick = (v.tickStart + unit - 1) / unit * (uint64_t)unit;; tick += unit)
     {
-        int x = xFromTick(step * steps, v);
+        int x = xFromTick((uint32_t)tick, v);
 
-        if (x > X1)
+        if (x > X1 || tick > UINT32_MAX)
             break;
 
         if (x < X0)
             continue;
 
-        if (step % 16 == 0) // bar
+        if (tick % BAR == 0) // bar
         {
             for (int y = 0; y < H; y += 1)
                 u8g2.drawPixel(x, y);
         }
-        else if (step % 4 == 0) // beat
+        else // beat
         {
             for (int y = 1; y < H; y += 3)
                 u8g2.drawPixel(x, y);
         }
-        // else // sixteenth step dots
-        // {
-        //     // Minimal hint on sixteenths: bottom end-cap dot
-        //     u8g2.drawPixel(x, H - 1);
-        // }
     }
     u8g2.drawVLine(X0, 0, H);
 }
@@ -94,42 +93,57 @@ void PianoRoll::drawLanes(U8G2 &u8g2, const Viewport &v)
     }
 }
 
-void PianoRoll::drawNotes(U8G2 &u8g2, const Track &t, const Viewport &v)
+void PianoRoll::drawNote(U8G2 &u8g2, uint32_t on, uint32_t duration, uint8_t pitch, uint8_t vel, const Viewport &v)
 {
     const int GX = Layout::GRID_X, GX1 = GX + Layout::GRID_W, H = Layout::H, LH = Layout::LANE_H;
     const int lanes = H / LH;
 
-    for (const auto &n : t.notes)
-    {
-        // clip by pitch rows
-        if (n.pitch < options_.pMin || n.pitch > options_.pMax)
-            continue;
-
-        int16_t lane = int16_t(n.pitch) - int16_t(v.pitchBase);
-        if (lane < 0 || lane >= lanes)
-            continue;
-
-        int32_t x0 = xFromTick(n.on, v);
-        int32_t x1 = xFromTick(n.on + n.duration, v);
+    // clip by pitch rows
+    if (pitch < options_.pMin || pitch > options_.pMax)
+        return;
+
+    int16_t lane = int16_t(pitch) - int16_t(v.pitchBase);
+    if (lane < 0 || lane >= lanes)
+        return;
+
+    int32_t x0 = xFromTick(on, v);
+    int32_t x1 = xFromTick(on + duration, v);
+
+    if (x1 <= GX || x0 >= GX1)
+        return;
+    if (x0 < GX)
+        x0 = GX;
+    if (x1 > GX1)
+        x1 = GX1;
+
+    int16_t y = yFromPitch(pitch, v);
+    int16_t w = (int16_t)((x1 - x0) > 0 ? (x1 - x0) : 1);
+    int16_t h = (int16_t)(LH - 1);
+
+    if (vel < 64)
+        drawLightFill(u8g2, x0, y, w, h);
+    else if (vel < 100)
+        drawMediumFill(u8g2, x0, y, w, h);
+    else
+        u8g2.drawBox(x0, y, w, h); // Full velocity
+}
 
-        if (x1 <= GX || x0 >= GX1)
-            continue;
-        if (x0 < GX)
-            x0 = GX;
-        if (x1 > GX1)
-            x1 = GX1;
-
-        int16_t y = yFromPitch(n.pitch, v);
-        int16_t w = (int16_t)((x1 - x0) > 0 ? (x1 - x0) : 1);
-        int16_t h = (int16_t)(LH - 1);
-
-        if (n.vel < 64)
-            drawLightFill(u8g2, x0, y, w, h);
-        else if (n.vel < 100)
-            drawMediumFill(u8g2, x0, y, w, h);
-        else
-            u8g2.drawBox(x0, y, w, h); // Full velocity
+void PianoRoll::drawNotes(U8G2 &u8g2, const Track &t, const Viewport &v, const Timeline::TrackTimeline *tt)
+{
+    if (tt && tt->built && tt->srcRev == t.notes.rev() && tt->ev.size() == t.notes.size())
+    {
+        // Compiled copy is current and complete: visit only the notes that can
+        // overlap the view (starts sorted, none longer than maxDur)
+        const uint64_t div = tt->div ? tt->div : 1;
+        const uint64_t from = (uint64_t)v.tickStart * div, to = ((uint64_t)v.tickStart + v.tickSpan) * div;
+        const NoteStore &ev = tt->ev;
+        for (auto it = ev.at(ev.lowerBound(from > tt->maxDur ? (uint32_t)(from - tt->maxDur) : 0));
+             it != ev.end() && it.on() < to; ++it)
+            drawNote(u8g2, (uint32_t)(it.on() / div), (uint32_t)(it.duration() / div), it.pitch(), it.vel(), v);
+        return;
     }
+    for (auto it = t.notes.begin(); it != t.notes.end(); ++it)
+        drawNote(u8g2, it.on(), it.duration(), it.pitch(), it.vel(), v);
 }
 
 void PianoRoll::drawPlayhead(U8G2 &u8g2, const Viewport &v, uint32_t playTick)
@@ -139,10 +153,11 @@ void PianoRoll::drawPlayhead(U8G2 &u8g2, const Viewport &v, uint32_t playTick)
         u8g2.drawVLine(x, 0, Layout::H);
 }
 
-void PianoRoll::render(U8G2 &u8g2, const Track &t, const Viewport &v, uint32_t playTick)
+void PianoRoll::render(U8G2 &u8g2, const Track &t, const Viewport &v, uint32_t playTick,
+                       const Timeline::TrackTimeline *tt)
 {
     drawLanes(u8g2, v);
     drawGrid(u8g2, v);
-    drawNotes(u8g2, t, v);
+    drawNotes(u8g2, t, v, tt);
     drawPlayhead(u8g2, v, playTick);
 }
@@ -2,6 +2,7 @@
 #include "U8g2lib.h"
 #include "model/track.hpp"
 #include "model/viewport.hpp"
+#include "engine/timeline.hpp"
 
 struct PianoRoll
 {
@@ -18,7 +19,9 @@ struct PianoRoll
     } options_;
 
     void setOptions(const Options &o) { options_ = o; }
-    void render(U8G2 &u8g2, const Track &t, const Viewport &v, uint32_t tick = 0);
+    // tt: the track's compiled timeline, if any; used for windowed drawing while it is current
+    void render(U8G2 &u8g2, const Track &t, const Viewport &v, uint32_t tick = 0,
+                const Timeline::TrackTimeline *tt = nullptr);
 
 private:
     static int32_t xFromTick(uint32_t tick, const Viewport &v);
@@ -26,7 +29,8 @@ private:
 
     void drawGrid(U8G2 &u8g2, const Viewport &v);
     void drawLanes(U8G2 &u8g2, const Viewport &v);
-    void drawNotes(U8G2 &u8g2, const Track &t, const Viewport &v);
+    void drawNotes(U8G2 &u8g2, const Track &t, const Viewport &v, const Timeline::TrackTimeline *tt);
+    void drawNote(U8G2 &u8g2, uint32_t on, uint32_t duration, uint8_t pitch, uint8_t vel, const Viewport &v);
     void drawPlayhead(U8G2 &u8g2, const Viewport &v, uint32_t playTick);
 
     // Velocity rendering helpers
@@ -0,0 +1,115 @@
+/**
+ * Euclidean Kernel Benchmark (host)
+ *
+ * Checks the 64-bit euclid::pattern against the previous std::vector<bool>
+ * Bresenham loop for every hits/steps pair up to 64 (same steps, hit count
+ * kept) and that rotation round-trips. Then times whole pattern evaluations
+ * as the generator does them (rhythm + rotation, accent AND, three XOR
+ * layers) against the vector version: the bitset kernel has to manage
+ * millions per second.
+ *
+ * Build & Run:
+ *   pio run -e native_euclid_bench -t exec
+ *   (or: g++ -std=gnu++17 -O2 -Isrc test/euclid_bench.cpp)
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "engine/euclid.hpp"
+
+using euclid::Bits;
+
+// The generator's previous kernel
+static std::vector<bool> vectorRhythm(uint8_t hits, uint8_t steps)
+{
+    std::vector<bool> rhythm(steps, false);
+    if (hits == 0 || steps == 0)
+        return rhythm;
+    int bucket = 0;
+    for (uint8_t i = 0; i < steps; i++)
+    {
+        bucket += hits;
+        if (bucket >= steps)
+        {
+            bucket -= steps;
+            rhythm[i] = true;
+        }
+    }
+    return rhythm;
+}
+
+static volatile uint64_t sink;
+
+int main()
+{
+    bool ok = true;
+
+    uint32_t pairs = 0, bad = 0;
+    for (uint8_t steps = 1; steps <= euclid::MAX_STEPS; ++steps)
+        for (uint8_t hits = 0; hits <= steps; ++hits)
+        {
+            const Bits b = euclid::pattern(hits, steps);
+            const std::vector<bool> v = vectorRhythm(hits, steps);
+            bool same = euclid::count(b) == hits && (b & ~euclid::mask(steps)) == 0;
+            for (uint8_t i = 0; i < steps; ++i)
+                same = same && ((b >> i) & 1) == v[i];
+            for (uint8_t r = 0; r < steps && same; ++r)
+                same = euclid::rotate(euclid::rotate(b, r, steps), (uint8_t)(steps - r), steps) == b &&
+                       euclid::count(euclid::rotate(b, r, steps)) == hits;
+            bad += !same;
+            pairs++;
+        }
+    printf("Kernel vs vector<bool>: %lu hits/steps pairs, %lu differ, rotation round-trips %s\n",
+           (unsigned long)pairs, (unsigned long)bad, bad ? "WRONG" : "OK");
+    ok = ok && bad == 0;
+
+    // Whole evaluations: rhythm, accent layer, three extra voices
+    const uint32_t N = 2000000;
+    Bits acc = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < N; ++n)
+    {
+        const uint8_t steps = (uint8_t)(16 + n % 49), hits = (uint8_t)(1 + n % steps);
+        const Bits main = euclid::rotate(euclid::pattern(hits, steps), (uint8_t)(n % 7), steps);
+        const Bits accents = main & euclid::rotate(euclid::pattern((uint8_t)(hits / 2), steps), 1, steps);
+        const Bits layer = euclid::pattern((uint8_t)(n % 5 + 2), steps);
+        Bits any = main;
+        for (uint8_t v = 1; v < 4; ++v)
+            any |= euclid::combine(main, euclid::rotate(layer, v, steps), euclid::Xor);
+        acc += any ^ accents;
+    }
+    const double sBits = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    sink = acc;
+
+    // Same work on vectors (rotation and combination per step)
+    const uint32_t NV = N / 10;
+    t0 = std::chrono::steady_clock::now();
+    uint64_t hitsV = 0;
+    for (uint32_t n = 0; n < NV; ++n)
+    {
+        const uint8_t steps = (uint8_t)(16 + n % 49), hits = (uint8_t)(1 + n % steps);
+        const std::vector<bool> m = vectorRhythm(hits, steps), a = vectorRhythm((uint8_t)(hits / 2), steps),
+                                l = vectorRhythm((uint8_t)(n % 5 + 2), steps);
+        const uint8_t rot = (uint8_t)(n % 7);
+        for (uint8_t i = 0; i < steps; ++i)
+        {
+            const bool mi = m[(i + steps - rot % steps) % steps];
+            bool any = mi;
+            for (uint8_t v = 1; v < 4; ++v)
+                any = any || (mi != l[(i + steps - v) % steps]);
+            hitsV += any != (mi && a[(i + steps - 1) % steps]);
+        }
+    }
+    const double sVec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    sink = hitsV;
+
+    const double rate = N / sBits, rateV = NV / sVec;
+    printf("Pattern evaluations: %.1f M/s bitset (%.0f ns each), %.2f M/s vector<bool> (%.0f ns each)\n",
+           rate / 1e6, 1e9 / rate, rateV / 1e6, 1e9 / rateV);
+    ok = ok && rate >= 1e6;
+
+    printf(ok ? "PASS\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+/**
+ * Evolve Mode Test (host)
+ *
+ * Arms an Evolver on a 1024-note track and drives it like RunLoop: one
+ * planning slice per service pass (timed, budget adapting to the cap) and
+ * tick windows over two loops. The plan must be finished in slices of at
+ * most budget() notes, be written only on the loop wrap, change at most the
+ * planned number of notes, move hits only into steps that were empty (the
+ * track staying in start order) and keep pitch drifts and re-rolls within
+ * their ranges. A plan made against a
+ * track edited since is dropped, and the same seed gives the same edits.
+ * Writing a plan with moves and recompiling the track (what RunLoop does in
+ * the tick loop) is timed, and a track over MAX_NOTES is refused.
+ *
+ * Build & Run:
+ *   pio run -e native_evolve -t exec
+ *   (or: g++ -std=gnu++17 -O2 -Isrc test/evolve_test.cpp)
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "engine/evolve.hpp"
+#include "engine/timeline.hpp"
+
+static NotePage pages[512];
+static NotePool pool;
+static Pattern pat, copy;
+static Evolver evo;
+static Timeline tl;
+
+static constexpr uint16_t NOTES = 1024;
+
+static void fill(Track &trk)
+{
+    trk.notes.clear();
+    // Four notes on every other step of 512: half the steps stay empty
+    for (uint16_t k = 0; k < NOTES; ++k)
+    {
+        Note n{};
+        n.on = (uint32_t)(k / 4) * 2 * 24;
+        n.duration = 12;
+        n.pitch = (uint8_t)(48 + (k % 4) * 4);
+        n.vel = 100;
+        trk.notes.push_back(n);
+    }
+}
+
+// Service passes until the plan is ready; returns passes, reports the largest slice
+static uint32_t plan(double &maxUs, uint16_t &maxBudget)
+{
+    uint32_t passes = 0;
+    maxUs = 0;
+    maxBudget = 0;
+    while (!evo.ready() && passes < 10000)
+    {
+        maxBudget = evo.budget() > maxBudget ? evo.budget() : maxBudget;
+        auto t0 = std::chrono::steady_clock::now();
+        const bool worked = evo.idle(pat);
+        const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        if (worked)
+            evo.noteSliceUs((uint32_t)us);
+        maxUs = us > maxUs ? us : maxUs;
+        passes++;
+    }
+    return passes;
+}
+
+int main()
+{
+    bool ok = true;
+    pool.begin(pages, 512, MemRegion::Dtcm);
+    pat.steps = 512;
+    pat.trackCount = 1;
+    Track &trk = pat.tracks[0];
+    fill(trk);
+    copy.assign(pat);
+
+    evolve::Amounts a;
+    a.swaps = 4;
+    a.drifts = 4;
+    a.drift = 3;
+    a.rerolls = 8;
+    a.velRange = 10;
+    evo.setAmounts(a);
+    evo.setCapUs(20);
+    evo.arm(0, 0, 42);
+
+    double maxUs;
+    uint16_t maxBudget;
+    const uint32_t passes = plan(maxUs, maxBudget);
+    printf("Plan over %u notes: %lu slices, largest slice %.2f us, budget now %u notes (max %u)\n", NOTES,
+           (unsigned long)passes, maxUs, evo.budget(), maxBudget);
+    ok = ok && evo.ready() && passes >= NOTES / maxBudget && maxBudget <= Evolver::MAX_BUDGET;
+
+    // Two loops of tick windows: edits land on the wrap only
+    const uint32_t loop = pat.ticks();
+    uint32_t applied = 0, wrapAt = 0;
+    for (uint32_t t = 1; t <= 2 * loop; ++t)
+    {
+        const uint32_t prev = (t - 1) % loop, curr = t % loop;
+        if (evo.boundary(prev, curr))
+        {
+            applied += evo.apply(pat);
+            wrapAt = t;
+        }
+    }
+    const uint16_t planned = (uint16_t)(a.swaps + a.drifts + a.rerolls);
+    printf("Applied %lu notes at tick %lu (loop %lu ticks), planned %u\n", (unsigned long)applied,
+           (unsigned long)wrapAt, (unsigned long)loop, planned);
+    ok = ok && applied > 0 && applied <= planned && wrapAt == loop;
+
+    // Moves land on empty (odd) steps at the same offset, the track stays in order;
+    // drifts and re-rolls stay in range (chord tones are 4 apart, drifts at most 3)
+    uint32_t moved = 0, drifted = 0, rerolled = 0, bad = 0;
+    for (uint16_t i = 0; i < NOTES; ++i)
+    {
+        const Note n = trk.notes.get(i);
+        if ((n.on / 24) % 2)
+            moved++, bad += n.on % 24 != 0;
+        if (i)
+            bad += trk.notes.onAt(i - 1) > n.on;
+        const int chord = 48 + ((n.pitch - 48 + 2) / 4) * 4;
+        if (n.pitch != chord)
+            drifted++, bad += abs((int)n.pitch - chord) > a.drift;
+        if (n.vel != 100)
+            rerolled++, bad += abs((int)n.vel - 100) > a.velRange;
+    }
+    printf("Moved %lu, drifted %lu, re-rolled %lu, out of range or order %lu\n", (unsigned long)moved,
+           (unsigned long)drifted, (unsigned long)rerolled, (unsigned long)bad);
+    ok = ok && bad == 0 && moved > 0 && trk.notes.size() == NOTES;
+
+    // Edited under the plan: dropped, then replanned against the new notes
+    plan(maxUs, maxBudget);
+    Note n = trk.notes.get(0);
+    n.vel = 1;
+    trk.notes.set(0, n);
+    const uint32_t stale = evo.stats().stale;
+    const bool dropped = evo.apply(pat) == 0 && evo.stats().stale == stale + 1;
+    printf("Plan against an edited track: %s\n", dropped ? "dropped" : "WRONG");
+    ok = ok && dropped;
+
+    // Same seed, same edits
+    Note firstRun[NOTES];
+    for (int run = 0; run < 2; ++run)
+    {
+        fill(trk);
+        evo.arm(0, 0, 7);
+        plan(maxUs, maxBudget);
+        evo.boundary(loop - 1, 0);
+        evo.apply(pat);
+        for (uint16_t i = 0; i < NOTES; ++i)
+        {
+            const Note x = trk.notes.get(i);
+            if (run == 0)
+                firstRun[i] = x;
+            else if (x.on != firstRun[i].on || x.pitch != firstRun[i].pitch || x.vel != firstRun[i].vel)
+                ok = false, bad++;
+        }
+    }
+    printf("Same seed twice: %s\n", bad ? "DIFFERENT" : "identical");
+
+    // Boundary cost: write a plan full of moves, recompile only the evolved track
+    a.swaps = a.drifts = a.rerolls = Evolver::MAX_EDITS / 3;
+    evo.setAmounts(a);
+    double worstUs = 0, totalUs = 0;
+    uint32_t unsorted = 0;
+    const int REPS = 20;
+    for (int rep = 0; rep < REPS; ++rep)
+    {
+        fill(trk);
+        tl.build(pat);
+        evo.arm(0, 0, 100 + rep);
+        plan(maxUs, maxBudget);
+        evo.boundary(loop - 1, 0);
+        auto t0 = std::chrono::steady_clock::now();
+        const bool rebuilt = evo.apply(pat) && tl.buildTrack(pat, 0);
+        const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        worstUs = us > worstUs ? us : worstUs;
+        totalUs += us;
+        for (uint16_t i = 1; i < NOTES; ++i)
+            unsorted += trk.notes.onAt(i - 1) > trk.notes.onAt(i);
+        const NoteStore &ev = tl.track(0).ev;
+        for (size_t i = 1; i < ev.size(); ++i)
+            ok = ok && ev.onAt(i - 1) <= ev.onAt(i);
+        ok = ok && rebuilt && ev.size() == NOTES;
+    }
+    printf("Apply %u edits + recompile %u notes: %.1f us avg, %.1f us worst (track out of order %lu times)\n",
+           Evolver::MAX_EDITS, NOTES, totalUs / REPS, worstUs, (unsigned long)unsorted);
+    ok = ok && unsorted == 0;
+
+    // Longer than MAX_NOTES: refused, never planned
+    Note extra{};
+    extra.on = 1;
+    extra.pitch = 60;
+    extra.vel = 100;
+    trk.notes.push_back(extra);
+    evo.arm(0, 0, 1);
+    const uint32_t refused = evo.stats().refused;
+    plan(maxUs, maxBudget);
+    const bool tooBig = !evo.ready() && evo.stats().refused == refused + 1 && !evo.idle(pat);
+    printf("Track of %u notes: %s\n", (unsigned)trk.notes.size(), tooBig ? "refused" : "PLANNED");
+    ok = ok && tooBig;
+
+    printf(ok ? "PASS\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+/**
+ * Generator Cache Test (host)
+ *
+ * Fills a GenCache with note sets of different sizes under a small budget:
+ * the least recently used entries must go first, the arena must stay within
+ * the budget, and every entry still cached must come back note for note
+ * after the compactions. Lowering the budget evicts down to it, results
+ * larger than the budget are refused; hit/miss counts are printed. Then
+ * times a hit (copy out of the arena) for a 64-step, 4-voice pattern.
+ *
+ * Build & Run:
+ *   pio run -e native_gen_cache -t exec
+ *   (or: g++ -std=gnu++17 -O2 -Isrc test/gen_cache_test.cpp)
+ */
+
+#include <chrono>
+#include <cstdio>
+
+#include "engine/gen_cache.hpp"
+#include "model/pattern.hpp"
+
+static NotePage pages[256];
+static NotePool pool;
+static Pattern pat;
+static GenCache cache;
+
+// Distinct notes per key, so a wrong run shows
+static void make(NoteStore &ns, uint32_t id, uint16_t n)
+{
+    ns.clear();
+    for (uint16_t i = 0; i < n; ++i)
+    {
+        Note x{};
+        x.on = i * 24u;
+        x.duration = 12;
+        x.pitch = (uint8_t)((id * 7 + i) & 0x7F);
+        x.vel = (uint8_t)(1 + (id + i) % 127);
+        ns.push_back(x);
+    }
+}
+
+static bool matches(const NoteStore &ns, uint32_t id, uint16_t n)
+{
+    if (ns.size() != n)
+        return false;
+    for (uint16_t i = 0; i < n; ++i)
+    {
+        const Note x = ns.get(i);
+        if (x.on != i * 24u || x.duration != 12 || x.pitch != ((id * 7 + i) & 0x7F) || x.vel != 1 + (id + i) % 127)
+            return false;
+    }
+    return true;
+}
+
+static GenCache::Key key(uint32_t id) { return GenCache::Key{0xC0FFEEu ^ id, id, 64, 1, 16}; }
+static uint16_t sizeOf(uint32_t id) { return (uint16_t)(8 + (id * 37) % 40); }
+
+int main()
+{
+    bool ok = true;
+    pool.begin(pages, 256, MemRegion::Dtcm);
+    pat.trackCount = 2;
+    NoteStore &src = pat.tracks[0].notes, &out = pat.tracks[1].notes;
+
+    // 1 KB budget: 128 notes, a handful of entries at a time
+    cache.setBudget(1024);
+    uint32_t over = 0;
+    for (uint32_t id = 0; id < 40; ++id)
+    {
+        make(src, id, sizeOf(id));
+        cache.store(key(id), src);
+        over += cache.usedBytes() > cache.budgetBytes();
+        // Keep id 3 hot: it must survive every eviction
+        if (id > 3)
+            ok = cache.fetch(key(3), out) && ok;
+    }
+    uint32_t cached = 0, bad = 0;
+    for (uint32_t id = 0; id < 40; ++id)
+        if (cache.fetch(key(id), out))
+        {
+            cached++;
+            bad += !matches(out, id, sizeOf(id));
+        }
+    const GenCache::Stats &s = cache.stats();
+    printf("40 stores in %lu bytes: %u entries left, %lu evicted, hot entry %s, %lu wrong after compaction\n",
+           (unsigned long)cache.budgetBytes(), cache.entries(), (unsigned long)s.evicted,
+           cache.fetch(key(3), out) ? "kept" : "EVICTED", (unsigned long)bad);
+    ok = ok && over == 0 && bad == 0 && cached == cache.entries() && cache.fetch(key(3), out);
+
+    // Newest entries are the ones left (besides the hot one)
+    ok = ok && cache.fetch(key(39), out) && !cache.fetch(key(0), out);
+
+    // Shrinking the budget evicts down to it; an oversized result is refused
+    cache.setBudget(256);
+    make(src, 99, 40);
+    const bool refused = !cache.store(key(99), src) && cache.stats().tooBig == 1;
+    printf("Budget 256 bytes: %lu used, oversized result %s\n", (unsigned long)cache.usedBytes(),
+           refused ? "refused" : "STORED");
+    ok = ok && cache.usedBytes() <= 256 && refused;
+    printf("Hits %lu + misses %lu = %lu lookups\n", (unsigned long)cache.stats().hits,
+           (unsigned long)cache.stats().misses, (unsigned long)(cache.stats().hits + cache.stats().misses));
+
+    // Cost of a hit: 64 steps x 4 voices
+    cache.clear();
+    cache.setBudget(GenCache::CAP * sizeof(PackedNote));
+    make(src, 5, 256);
+    cache.store(key(5), src);
+    const int REPS = 20000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < REPS; ++r)
+        cache.fetch(key(5), out);
+    const double usHit = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / REPS;
+    printf("Hit for 256 notes: %.2f us\n", usHit);
+    ok = ok && matches(out, 5, 256);
+
+    printf(ok ? "PASS\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+/**
+ * Groove Placement Test (host)
+ *
+ * Compiles straight 16-step tracks through Timeline under a 66% swing (also
+ * on a half-time track, where the offset doubles) and under grooves
+ * extracted from played takes, and checks every note's compiled tick,
+ * micro_q8 and velocity against the offsets worked out by hand. A note
+ * pulled before step 0 must wrap to the loop end, a late one near the loop
+ * end to its start, with the compiled track still sorted. A groove edit
+ * dirties every track, and a budgeted build recompiles them over several
+ * passes, as RunLoop does.
+ *
+ * Build & Run:
+ *   pio run -e native_groove -t exec
+ *   (or: g++ -std=gnu++17 -O2 -Isrc test/groove_test.cpp)
+ */
+
+#include <cstdio>
+
+#include "engine/timeline.hpp"
+
+static NotePage pages[64];
+static NotePool pool;
+static Pattern pat;
+static Timeline tl;
+
+struct Offset
+{
+    int32_t ticks;
+    int16_t micro;
+    int8_t vel;
+};
+
+// Source tick of the note with pitch k: one per step, and k = 16 just before the loop end
+static uint32_t source(uint8_t k) { return k < 16 ? k * 24u : 380u; }
+
+static void straight(Track &trk, uint8_t div, uint8_t notes = 16)
+{
+    trk.clear();
+    trk.clockDiv = div;
+    for (uint8_t k = 0; k < notes; ++k)
+    {
+        Note n{};
+        n.on = source(k);
+        n.duration = 12;
+        n.pitch = k;
+        n.vel = 100;
+        trk.notes.push_back(n);
+    }
+}
+
+// A take played with these offsets (1/256 tick) and accents, repeating every 4 steps
+static void played(Track &trk, const int16_t off[4], const uint8_t vel[4])
+{
+    trk.clear();
+    for (uint32_t s = 0; s < 16; ++s)
+    {
+        int32_t q = (int32_t)(s * 24 * 256) + off[s % 4];
+        q = (q + 384 * 256) % (384 * 256);
+        Note n{};
+        n.on = (uint32_t)((q + 128) >> 8);
+        n.micro_q8 = (int16_t)(q - ((q + 128) >> 8 << 8));
+        n.duration = 12;
+        n.pitch = 72;
+        n.vel = vel[s % 4];
+        trk.notes.push_back(n);
+    }
+}
+
+// Every compiled note of track t lands on its source tick * div + off[nearest step % n],
+// `wraps` of them across a loop end; the track stays sorted
+static bool check(const char *name, uint8_t t, const Offset *off, uint8_t n, uint32_t wraps)
+{
+    const Timeline::TrackTimeline &tt = tl.track(t);
+    const int32_t div = tt.div, len = (int32_t)tt.len;
+    uint32_t bad = 0, wrapped = 0, prev = 0;
+    for (size_t i = 0; i < tt.ev.size(); ++i)
+    {
+        const Note x = tt.ev.get(i);
+        const Offset &o = off[(source(x.pitch) + 12) / 24 % n];
+        int32_t want = (int32_t)source(x.pitch) * div + o.ticks;
+        if (want < 0 || want >= len)
+        {
+            want = (want + len) % len;
+            wrapped++;
+        }
+        bad += x.on != (uint32_t)want || x.micro_q8 != o.micro || x.vel != 100 + o.vel || x.on < prev;
+        prev = x.on;
+    }
+    printf("%-16s %u notes, %lu wrapped, %lu misplaced\n", name, (unsigned)tt.ev.size(), (unsigned long)wrapped,
+           (unsigned long)bad);
+    return wrapped == wraps && bad == 0;
+}
+
+int main()
+{
+    bool ok = true;
+    pool.begin(pages, 64, MemRegion::Dtcm);
+    pat.steps = 16;
+    pat.trackCount = 3;
+    straight(pat.tracks[0], 1);
+    straight(pat.tracks[1], 2);
+
+    // 66% swing: odd steps 32% of a step pair late = 1966/256 ticks
+    pat.groove.swing(66);
+    tl.build(pat);
+    static const Offset SWING[2] = {{0, 0, 0}, {8, -82, 0}};
+    ok = check("Swing 66%", 0, SWING, 2, 0) && ok;
+    // Half time: offsets in transport ticks double
+    static const Offset SWING2[2] = {{0, 0, 0}, {15, 92, 0}};
+    ok = check("Swing 66% /2", 1, SWING2, 2, 0) && ok;
+
+    // Played 4 ticks early, 5.25 late, 3 early and 100/256 late, accented 100/80/90/70;
+    // the downbeat is pulled before step 0 and wraps to the loop end
+    static const uint8_t VEL[4] = {100, 80, 90, 70};
+    static const int16_t RUSHED[4] = {-4 * 256, 5 * 256 + 64, -3 * 256, 100};
+    played(pat.tracks[2], RUSHED, VEL);
+    ok = pat.groove.extract(pat.tracks[2].notes, 4) && ok;
+    tl.build(pat);
+    // Mean velocity 85: accents become +15/-5/+5/-15
+    static const Offset EXTRACTED[4] = {{-4, 0, 15}, {5, 64, -5}, {-3, 0, 5}, {0, 100, -15}};
+    ok = check("Extracted", 0, EXTRACTED, 4, 1) && ok;
+
+    // A dragged downbeat (6.25 ticks late) pushes a note 4 ticks before the loop end past it
+    static const int16_t DRAGGED[4] = {6 * 256 + 64, 0, 0, 0};
+    played(pat.tracks[2], DRAGGED, VEL);
+    ok = pat.groove.extract(pat.tracks[2].notes, 4) && ok;
+    straight(pat.tracks[0], 1, 17);
+    tl.build(pat);
+    static const Offset LATE[4] = {{6, 64, 15}, {0, 0, -5}, {0, 0, 5}, {0, 0, -15}};
+    ok = check("Extracted, late", 0, LATE, 4, 1) && ok;
+
+    // One track per build() call, as RunLoop spreads a groove edit over its passes
+    pat.groove.swing(58);
+    uint8_t passes = 0;
+    for (uint8_t calls = 0; tl.stale(pat) && calls < 10; ++calls)
+        passes += tl.build(pat, 1);
+    printf("%-16s %u tracks rebuilt in %u passes\n", "Budgeted", pat.trackCount, passes);
+    ok = passes == pat.trackCount && ok;
+
+    printf(ok ? "PASS\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+/**
+ * Markov Model Benchmark (host)
+ *
+ * Trains a markov::Model on a 1024-note take (a riff with a few variations)
+ * and times training + compile, which has to stay far inside one loop pass.
+ * Training the same take in 64-note slices must give the same model (same
+ * walk). Walks are checked for determinism per seed, and a pitch-class walk
+ * may only use transitions that occur in the take. Then times sampling.
+ *
+ * Build & Run:
+ *   pio run -e native_markov_bench -t exec
+ *   (or: g++ -std=gnu++17 -O2 -Isrc test/markov_bench.cpp)
+ */
+
+#include <chrono>
+#include <cstdio>
+
+#include "engine/markov.hpp"
+#include "model/pattern.hpp"
+
+static NotePage pages[512];
+static NotePool pool;
+static Pattern pat;
+static markov::Model model, sliced;
+static markov::Trainer trainer;
+
+static constexpr uint32_t TPS = 24;
+static constexpr uint16_t TAKE = 1024;
+
+static bool same(const NoteStore &a, const NoteStore &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        const Note x = a.get(i), y = b.get(i);
+        if (x.on != y.on || x.duration != y.duration || x.pitch != y.pitch || x.vel != y.vel)
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+    pool.begin(pages, 512, MemRegion::Dtcm);
+    pat.steps = 64;
+    pat.trackCount = 4;
+
+    // The take: an 8-note riff in C minor pentatonic, every fourth bar varied
+    static const uint8_t RIFF[8] = {48, 51, 53, 55, 58, 55, 53, 51};
+    static const uint8_t GAP[8] = {1, 1, 2, 1, 1, 2, 1, 1};
+    XorShift32 r(3);
+    bool seen[12][12] = {};
+    uint32_t t = 0;
+    uint8_t prev = 0xFF;
+    Track &take = pat.tracks[0];
+    for (uint16_t k = 0; k < TAKE; ++k)
+    {
+        Note n{};
+        n.on = t;
+        n.duration = (k & 1) ? TPS / 2 : TPS;
+        n.pitch = (uint8_t)(RIFF[k % 8] + ((k / 8) % 4 == 3 && k % 2 ? 12 : 0));
+        n.vel = (uint8_t)(90 + r.below(30));
+        take.notes.push_back(n);
+        if (prev != 0xFF)
+            seen[prev % 12][n.pitch % 12] = true;
+        prev = n.pitch;
+        t += GAP[k % 8] * TPS;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    const int REPS = 200;
+    for (int rep = 0; rep < REPS; ++rep)
+    {
+        model.reset();
+        trainer.train(model, take.notes, TPS);
+    }
+    const double usTrain = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / REPS;
+    printf("Training %u notes + compile: %.1f us (%.0f ns/note), %u interval transitions\n", TAKE, usTrain,
+           usTrain * 1000 / TAKE, model.interval.entries());
+    ok = ok && model.ready() && model.notes() == TAKE && usTrain < 2000.0;
+
+    // Same take in 64-note slices
+    sliced.reset();
+    trainer.begin(sliced, take.notes, TPS);
+    uint32_t slices = 1;
+    while (!trainer.step(64))
+        slices++;
+
+    markov::WalkParams w{};
+    w.ticks = 64 * TPS;
+    w.ticksPerStep = TPS;
+    w.order = 2;
+    w.base = 48;
+    w.range = 12;
+    NoteStore &a = pat.tracks[1].notes, &b = pat.tracks[2].notes, &c = pat.tracks[3].notes;
+    XorShift32 ra(5), rb(5), rc(6);
+    model.walk(a, w, ra);
+    model.walk(b, w, rb);
+    sliced.walk(c, w, rc);
+    const bool seeded = !a.empty() && same(a, b) && !same(a, c);
+    c.clear();
+    XorShift32 rs(5);
+    sliced.walk(c, w, rs);
+    const bool slicedSame = same(a, c);
+    printf("Walk: %u notes, same seed %s, sliced training (%lu slices) %s\n", (unsigned)a.size(),
+           seeded ? "identical" : "WRONG", (unsigned long)slices, slicedSame ? "identical" : "WRONG");
+    ok = ok && seeded && slicedSame;
+
+    // Pitch-class walk: only transitions from the take
+    w.pitchClass = true;
+    uint32_t unseen = 0, pairs = 0;
+    for (uint32_t seed = 1; seed <= 50; ++seed)
+    {
+        a.clear();
+        XorShift32 rw(seed);
+        model.walk(a, w, rw);
+        for (size_t i = 1; i < a.size(); ++i, ++pairs)
+            unseen += !seen[a.get(i - 1).pitch % 12][a.get(i).pitch % 12];
+    }
+    printf("Pitch-class walks: %lu transitions, %lu not in the take\n", (unsigned long)pairs, (unsigned long)unseen);
+    ok = ok && pairs > 0 && unseen == 0;
+
+    // Sampling rate
+    const uint32_t N = 2000000;
+    XorShift32 rn(9);
+    uint8_t h2 = markov::NONE, h1 = markov::NONE;
+    uint32_t acc = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < N; ++n)
+    {
+        const uint8_t s = model.interval.sample(h2, h1, 2, rn);
+        h2 = h1;
+        h1 = s;
+        acc += s;
+    }
+    const double nsSample = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / N;
+    printf("Second-order sample: %.1f ns (checksum %lu)\n", nsSample, (unsigned long)acc);
+    ok = ok && nsSample < 1000.0;
+
+    printf(ok ? "PASS\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
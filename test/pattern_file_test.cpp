@@ -0,0 +1,223 @@
+/**
+ * Pattern File Round-Trip Test & Benchmark (host)
+ *
+ * Saves randomized patterns into a bank file through the incremental writer,
+ * reloads them by slot and checks every note and setting survived, then
+ * reports save/load throughput of the format code against an ordinary file.
+ * Rewritten slots leave dead records behind; a compaction pass must squeeze
+ * them out and leave every slot loading as before, also after a reopen.
+ *
+ * Build & Run:
+ *   pio run -e native_pattern_file -t exec
+ *   (or: g++ -std=gnu++17 -O2 -Isrc test/pattern_file_test.cpp)
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "model/pattern.hpp"
+#include "model/note_pool.hpp"
+#include "storage/pattern_file.hpp"
+
+static constexpr const char *PATH = "pattern_file_test.bin";
+static constexpr uint16_t PATTERNS = 200;
+static constexpr uint8_t TRACKS = 8;
+static constexpr uint16_t NOTES = 256; // per track
+
+static NotePage pages[2048];
+static NotePool pool;
+static Pattern src, dst;
+
+static void randomize(Pattern &p, unsigned seed)
+{
+    srand(seed);
+    p.steps = 16 + rand() % 200;
+    p.grid = 16;
+    p.tempo = 60.f + (float)(rand() % 1200) / 10.f;
+    p.trackCount = TRACKS;
+    p.sel = rand() % TRACKS;
+    if (rand() % 2)
+        p.groove.swing(50 + rand() % 26, rand() % 2 ? 24 : 12);
+    else
+        p.groove.clear();
+    for (uint8_t t = 0; t < Pattern::MAX_TRACKS; ++t)
+        p.tracks[t].clear();
+    for (uint8_t t = 0; t < TRACKS; ++t)
+    {
+        Track &trk = p.tracks[t];
+        trk.channel = 1 + t;
+        trk.mute = rand() % 4 == 0;
+        trk.steps = rand() % 3 ? 0 : 8 + rand() % 56;
+        trk.clockDiv = 1 + rand() % 3;
+        trk.quant = rand() % 2 ? Quantize{} : Quantize{(uint8_t)(rand() % 101), (uint8_t)(1 + rand() % 100)};
+        uint16_t n = (uint16_t)(rand() % (NOTES + 1)); // includes empty and partial-page tracks
+        for (uint16_t i = 0; i < n; ++i)
+        {
+            Note x{};
+            x.on = (uint32_t)rand() % 6000;
+            x.duration = 1 + rand() % 400;
+            x.micro_q8 = (int16_t)(rand() % 255 - 127);
+            x.pitch = rand() % 128;
+            x.vel = 1 + rand() % 127;
+            x.flags = rand() % 2;
+            x.skip = rand() % 3 ? 0 : rand() % 101;
+            x.cond = rand() % 4 ? (uint8_t)trig::Always : trig::every(1, 2);
+            trk.notes.push_back(x);
+        }
+    }
+}
+
+static bool same(const Pattern &a, const Pattern &b)
+{
+    if (a.steps != b.steps || a.grid != b.grid || a.tempo != b.tempo || a.trackCount != b.trackCount || a.sel != b.sel)
+        return false;
+    const Groove &g = a.groove, &h = b.groove;
+    if (g.steps != h.steps || (g.active() && (g.stepTicks != h.stepTicks ||
+                                              memcmp(g.shift_q8, h.shift_q8, sizeof(g.shift_q8)) ||
+                                              memcmp(g.vel, h.vel, sizeof(g.vel)))))
+        return false;
+    for (uint8_t t = 0; t < a.trackCount; ++t)
+    {
+        const Track &x = a.tracks[t], &y = b.tracks[t];
+        if (x.channel != y.channel || x.mute != y.mute || x.steps != y.steps || x.clockDiv != y.clockDiv || x.quant != y.quant ||
+            x.notes.size() != y.notes.size())
+            return false;
+        for (size_t i = 0; i < x.notes.size(); ++i)
+        {
+            Note m = x.notes[i], n = y.notes[i];
+            if (m.on != n.on || m.duration != n.duration || m.micro_q8 != n.micro_q8 || m.pitch != n.pitch ||
+                m.vel != n.vel || m.flags != n.flags || m.skip != n.skip || m.cond != n.cond)
+                return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    pool.begin(pages, 2048, MemRegion::Dtcm);
+    remove(PATH);
+
+    PatternFile file;
+    if (!file.open(PATH))
+    {
+        printf("FAIL: cannot create %s\n", PATH);
+        return 1;
+    }
+
+    // Save: incremental steps, as the main loop would drive them
+    double saveUs = 0, maxStepUs = 0;
+    uint32_t steps = 0;
+    for (uint16_t s = 0; s < PATTERNS; ++s)
+    {
+        randomize(src, 1000 + s);
+        auto t0 = std::chrono::steady_clock::now();
+        if (!file.saveBegin(s, src))
+        {
+            printf("FAIL: saveBegin %u\n", s);
+            return 1;
+        }
+        for (;;)
+        {
+            auto a = std::chrono::steady_clock::now();
+            bool more = file.saveStep(512);
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - a).count();
+            if (us > maxStepUs)
+                maxStepUs = us;
+            steps++;
+            if (!more)
+                break;
+        }
+        saveUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    }
+    const uint32_t written = file.stats().bytesWritten;
+    file.close();
+
+    // Reopen (index from disk) and load in a scattered order
+    if (!file.open(PATH))
+    {
+        printf("FAIL: reopen\n");
+        return 1;
+    }
+    double loadUs = 0;
+    uint32_t bad = 0;
+    for (uint16_t k = 0; k < PATTERNS; ++k)
+    {
+        uint16_t s = (uint16_t)((k * 37u) % PATTERNS);
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = file.load(s, dst);
+        loadUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        randomize(src, 1000 + s);
+        if (!ok || !same(src, dst))
+        {
+            printf("mismatch in slot %u\n", s);
+            bad++;
+        }
+    }
+    const uint32_t read = file.stats().bytesRead;
+
+    // Rewriting a slot appends a new record and repoints the index
+    randomize(src, 77);
+    file.saveBegin(5, src);
+    while (file.saveStep())
+    {
+    }
+    bool rewrite = file.load(5, dst) && same(src, dst);
+
+    // Rewrite a few more slots (one of them twice), then compact the bank
+    static const uint16_t REWRITE[4] = {0, 120, 5, 199};
+    for (uint16_t s : REWRITE)
+    {
+        randomize(src, 2000 + s);
+        file.saveBegin(s, src);
+        while (file.saveStep())
+        {
+        }
+    }
+    const uint32_t before = file.fileEnd(), dead = file.deadBytes();
+    double compactUs = 0, maxCompactUs = 0;
+    bool compacted = file.compactBegin();
+    while (compacted)
+    {
+        auto a = std::chrono::steady_clock::now();
+        bool more = file.saveStep(512);
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - a).count();
+        compactUs += us;
+        maxCompactUs = us > maxCompactUs ? us : maxCompactUs;
+        if (!more)
+            break;
+    }
+    compacted = compacted && file.deadBytes() == 0 && file.fileEnd() == before - dead && file.stats().compactions == 1;
+    file.close();
+    uint32_t lost = 0;
+    if (!file.open(PATH) || file.deadBytes() != 0)
+        compacted = false;
+    for (uint16_t s = 0; s < PATTERNS; ++s)
+    {
+        bool again = false;
+        for (uint16_t r : REWRITE)
+            again = again || r == s;
+        randomize(src, again ? 2000 + s : 1000 + s);
+        if (!file.load(s, dst) || !same(src, dst))
+            lost++;
+    }
+    file.close();
+    remove(PATH);
+
+    printf("Patterns: %u x %u tracks, file %lu KB\n", PATTERNS, TRACKS, (unsigned long)(written / 1024));
+    printf("Save: %.1f MB/s, %.1f us/pattern, %lu steps, worst step %.1f us\n",
+           written / saveUs, saveUs / PATTERNS, (unsigned long)steps, maxStepUs);
+    printf("Load: %.1f MB/s, %.1f us/pattern\n", read / loadUs, loadUs / PATTERNS);
+    printf("Compact: %lu of %lu KB dead, %.0f us, worst step %.1f us, %lu slots lost\n",
+           (unsigned long)(dead / 1024), (unsigned long)(before / 1024), compactUs, maxCompactUs, (unsigned long)lost);
+
+    if (bad || !rewrite || !compacted || lost)
+    {
+        printf("FAIL: %lu mismatches%s%s\n", (unsigned long)bad, rewrite ? "" : ", rewrite",
+               compacted ? "" : ", compaction");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * Playback Engine Benchmark (host)
+ *
+ * Plays a 16-track x 256-note pattern through the cursor/heap PlaybackEngine
+ * and through the previous scan-every-note loop, checks both emit the same
+ * note-ons and reports the per-tick cost of each.
+ *
+ * Build & Run:
+ *   pio run -e native_playback_bench -t exec
+ *   (or: g++ -std=gnu++17 -O2 -Isrc test/playback_bench.cpp)
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "model/pattern.hpp"
+#include "model/note_pool.hpp"
+#include "engine/timeline.hpp"
+#include "engine/playback_engine.hpp"
+
+static constexpr uint8_t TRACKS = 16;
+static constexpr uint16_t NOTES = 256;
+static constexpr uint32_t LOOPS = 40;
+
+static NotePage pages[1024];
+static NotePool pool;
+static Pattern pat;
+
+// The pre-Timeline algorithm: scan every note of every track each tick
+static void naiveTick(uint32_t prev, uint32_t curr, const Pattern &p, std::vector<MidiEvent> &out)
+{
+    const uint32_t L = p.ticks();
+    auto inside = [&](uint32_t x) -> bool
+    { return (prev < curr) ? (x > prev && x <= curr) : (x > prev || x <= curr); };
+    for (uint8_t t = 0; t < p.trackCount; ++t)
+    {
+        const Track &trk = p.tracks[t];
+        for (auto it = trk.notes.begin(); it != trk.notes.end(); ++it)
+        {
+            uint32_t on = it.on() % L, off = (it.on() + it.duration()) % L;
+            if (inside(on))
+                out.push_back(MidiEvent{trk.channel, it.pitch(), it.vel(), true, 0});
+            if (inside(off))
+                out.push_back(MidiEvent{trk.channel, it.pitch(), 0, false, 0});
+        }
+    }
+}
+
+int main()
+{
+    pool.begin(pages, 1024, MemRegion::Dtcm);
+    srand(1234);
+
+    pat.grid = 16;
+    pat.steps = 255;
+    pat.trackCount = TRACKS;
+    const uint32_t L = pat.ticks();
+    for (uint8_t t = 0; t < TRACKS; ++t)
+    {
+        pat.tracks[t].channel = t + 1;
+        for (uint16_t i = 0; i < NOTES; ++i)
+        {
+            Note n{};
+            n.on = 1 + (uint32_t)rand() % (L - 1); // avoid tick 0 (naive loop skips it on the first pass)
+            n.duration = 6 + rand() % 48;
+            n.pitch = 36 + rand() % 48;
+            n.vel = 1 + rand() % 127;
+            pat.tracks[t].notes.push_back(n);
+        }
+    }
+
+    Timeline tl;
+    tl.build(pat);
+    PlaybackEngine eng;
+    std::vector<MidiEvent> out;
+    out.reserve(4096);
+
+    const uint32_t ticks = L * LOOPS;
+    size_t onsEngine = 0, onsNaive = 0, maxOut = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t k = 0; k < ticks; ++k)
+    {
+        uint32_t prev = k % L, curr = (k + 1) % L;
+        eng.processTick(prev, curr, tl, 120.f, out);
+        for (const auto &m : out)
+            onsEngine += m.on;
+        if (out.size() > maxOut)
+            maxOut = out.size();
+        out.clear();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (uint32_t k = 0; k < ticks; ++k)
+    {
+        naiveTick(k % L, (k + 1) % L, pat, out);
+        for (const auto &m : out)
+            onsNaive += m.on;
+        out.clear();
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double nsEngine = std::chrono::duration<double, std::nano>(t1 - t0).count() / ticks;
+    double nsNaive = std::chrono::duration<double, std::nano>(t2 - t1).count() / ticks;
+
+    printf("Pattern: %u tracks x %u notes, %lu ticks/loop, %lu loops\n",
+           TRACKS, NOTES, (unsigned long)L, (unsigned long)LOOPS);
+    printf("Engine: %8.1f ns/tick  (%zu note-ons, peak %zu events/tick, %u sounding)\n",
+           nsEngine, onsEngine, maxOut, eng.sounding());
+    printf("Naive:  %8.1f ns/tick  (%zu note-ons)\n", nsNaive, onsNaive);
+    printf("Speedup: %.1fx\n", nsNaive / nsEngine);
+
+    if (onsEngine != onsNaive)
+    {
+        printf("FAIL: note-on count mismatch\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,140 @@
+/**
+ * Ratchet Test (host)
+ *
+ * A 32-step hi-hat with 4x ratchets stores 32 notes and must play 128 hits
+ * per loop at the right ticks, with the velocity ramp applied; its per-tick
+ * cost is compared with the same roll entered as 128 notes. Then 16 tracks of
+ * 8x 1/128 rolls ask for far more than the MIDI UART carries: output in every
+ * one-second window must stay within the engine's ratchet budget, with the
+ * excess repeats dropped.
+ *
+ * Build & Run:
+ *   pio run -e native_ratchet -t exec
+ *   (or: g++ -std=gnu++17 -O2 -Isrc test/ratchet_test.cpp)
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "engine/playback_engine.hpp"
+
+static NotePage pages[256];
+static NotePool pool;
+static Pattern pat;
+static Timeline tl;
+
+static constexpr uint32_t LOOPS = 200;
+static constexpr float BPM = 120.f;
+
+struct Hit
+{
+    uint32_t tick;
+    uint8_t ch, vel;
+};
+
+static void hat(uint8_t t, uint32_t steps, uint32_t step, uint8_t rat)
+{
+    Track &trk = pat.tracks[t];
+    trk.clear();
+    trk.channel = t + 1;
+    for (uint32_t s = 0; s < steps; ++s)
+    {
+        Note n{};
+        n.on = s * step;
+        n.duration = step;
+        n.pitch = 42;
+        n.vel = 100;
+        n.flags = rat;
+        trk.notes.push_back(n);
+    }
+}
+
+// Play `loops` passes; returns note-ons and counts every message sent per tick
+static std::vector<Hit> play(PlaybackEngine &eng, uint32_t loops, std::vector<uint16_t> *msgs, double &nsPerTick)
+{
+    std::vector<MidiEvent> out;
+    std::vector<Hit> hits;
+    out.reserve(256);
+    const uint32_t len = pat.ticks();
+    auto t0 = std::chrono::steady_clock::now();
+    uint32_t prev = 0;
+    for (uint32_t n = 0; n + 1 < loops * len; ++n)
+    {
+        const uint32_t curr = (prev + 1) % len;
+        eng.processTick(prev, curr, tl, BPM, out);
+        for (const MidiEvent &m : out)
+            if (m.on)
+                hits.push_back(Hit{n, m.ch, m.vel});
+        if (msgs)
+            msgs->push_back((uint16_t)out.size());
+        out.clear();
+        prev = curr;
+    }
+    nsPerTick = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / (loops * len);
+    return hits;
+}
+
+int main()
+{
+    bool ok = true;
+    pool.begin(pages, 256, MemRegion::Dtcm);
+
+    // 32 x 1/16 hat, 4 hits per step ramping down
+    pat.steps = 32;
+    pat.trackCount = 1;
+    hat(0, 32, 24, ratchet::make(4, ratchet::Split, ratchet::Down));
+    tl.build(pat);
+    double nsRatchet, nsNotes;
+    PlaybackEngine a;
+    std::vector<Hit> h = play(a, LOOPS, nullptr, nsRatchet);
+    bool timing = h.size() == 128 * LOOPS;
+    for (size_t i = 0; timing && i < h.size(); ++i)
+    {
+        // Window n plays tick n + 1 (tick 0 in the first window)
+        const uint32_t tick = h[i].tick ? h[i].tick + 1 : 0;
+        const uint8_t k = (uint8_t)(i % 4);
+        timing = tick % 768 == (i / 4) % 32 * 24 + k * 6 && h[i].vel == 100 * (4 - k) / 4;
+        if (!timing)
+            printf("  hit %zu at %lu vel %u\n", i, (unsigned long)tick, h[i].vel);
+    }
+    printf("32-step hat x4: %zu stored notes, %zu hits in %lu loops, timing/ramp %s\n", pat.tracks[0].notes.size(),
+           h.size(), (unsigned long)LOOPS, timing ? "OK" : "WRONG");
+    ok = ok && timing && pat.tracks[0].notes.size() == 32;
+
+    // Same roll as 128 stored notes
+    hat(0, 128, 6, 0);
+    tl.build(pat);
+    PlaybackEngine b;
+    std::vector<Hit> h2 = play(b, LOOPS, nullptr, nsNotes);
+    printf("  per tick: %.1f ns ratcheted, %.1f ns as 128 notes (%zu hits)\n", nsRatchet, nsNotes, h2.size());
+
+    // Sixteen 8x 1/128 rolls on every 1/16: ~32 B/tick asked, ~13 B/tick allowed at 120 BPM
+    pat.steps = 16;
+    pat.trackCount = 16;
+    for (uint8_t t = 0; t < 16; ++t)
+        hat(t, 16, 24, ratchet::make(8, ratchet::R128));
+    tl.build(pat);
+    PlaybackEngine c;
+    std::vector<uint16_t> msgs;
+    double nsDense;
+    std::vector<Hit> h3 = play(c, 50, &msgs, nsDense);
+    const uint32_t window = (uint32_t)(1000000 / usPerTick(Tempo{BPM, 96})); // ticks per second
+    uint32_t sum = 0, peak = 0;
+    for (size_t i = 0; i < msgs.size(); ++i)
+    {
+        sum += msgs[i];
+        if (i >= window)
+            sum -= msgs[i - window];
+        if (sum > peak)
+            peak = sum;
+    }
+    const uint32_t limit = PlaybackEngine::RATCHET_BYTES_PER_SEC + 8 * 3; // budget + burst
+    const bool capped = peak * 3 <= limit && c.ratchetDropped() > 0;
+    printf("Dense rolls: peak %lu B/s (limit %lu, UART 3125), %zu hits played, %lu repeats dropped, %.1f ns/tick\n",
+           (unsigned long)(peak * 3), (unsigned long)limit, h3.size(), (unsigned long)c.ratchetDropped(), nsDense);
+    ok = ok && capped && c.rollOverflow() == 0;
+
+    printf(ok ? "PASS\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+/**
+ * Recording Timing Test (host)
+ *
+ * Plays 40 notes at odd sub-tick positions into a track running at a clock
+ * divisor of 4 (a 16-step loop of 1536 transport ticks) through Transport
+ * and RecordEngine, commits them, compiles the timeline and compares each
+ * compiled start (tick + micro_q8) with the transport position the note was
+ * played at. The residual is stored in 1/256 note tick, so the error must
+ * stay under div/256 of a transport tick; clipped to int8 in transport
+ * ticks it would reach (div - 1) / 2 ticks.
+ * Then plays a fast run through idle(), as RunLoop commits: the notes must
+ * go in by the batch, at most one commit per MIN_GAP_US, and none lost.
+ *
+ * Build & Run:
+ *   pio run -e native_record -t exec
+ *   (or: g++ -std=gnu++17 -O2 -Isrc test/record_test.cpp)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "engine/record_engine.hpp"
+#include "engine/timeline.hpp"
+
+static NotePage pages[64];
+static NotePool pool;
+static Pattern pat;
+static Timeline tl;
+static Transport tx;
+static RecordEngine rec;
+
+static constexpr uint8_t DIV = 4;
+static constexpr uint8_t NOTES = 40;
+
+int main()
+{
+    bool ok = true;
+    pool.begin(pages, 64, MemRegion::Dtcm);
+    pat.steps = 16;
+    pat.trackCount = 1;
+    pat.tracks[0].clockDiv = DIV;
+    const uint32_t loop = pat.trackPlayTicks(0);
+    tx.setLoopLen(loop);
+    tx.setTempo(120.f);
+    tx.start();
+    rec.begin(&pat, &tx);
+    rec.arm(true);
+
+    // One note every 37 ms, 0..999 us into the millisecond, released 20 ms later
+    int64_t played[NOTES];
+    uint32_t us = 0;
+    uint8_t k = 0;
+    TickWindow w;
+    for (uint32_t ms = 1; ms < 37 * NOTES + 40; ++ms)
+    {
+        us = ms * 1000;
+        tx.on1ms(us);
+        while (tx.next(w))
+            ;
+        if (ms % 37 == 0 && k < NOTES)
+        {
+            const uint32_t at = us + (k * 263) % 1000;
+            uint8_t frac;
+            const int32_t ahead = tx.offsetAt(at, frac);
+            played[k] = (int64_t)((tx.playTick() + ahead + loop) % loop) * 256 + frac;
+            rec.onLiveNoteOn(k, 100, at);
+            k++;
+        }
+        if (ms % 37 == 20 && k)
+            rec.onLiveNoteOff(k - 1, us);
+        rec.commit();
+    }
+    tl.build(pat);
+
+    // Compiled start vs played position, both in 1/256 transport tick, across the loop point
+    const Timeline::TrackTimeline &tt = tl.track(0);
+    const int64_t span = (int64_t)loop * 256;
+    int64_t worst = 0;
+    for (size_t i = 0; i < tt.ev.size(); ++i)
+    {
+        const Note x = tt.ev.get(i);
+        int64_t err = ((int64_t)x.on * 256 + x.micro_q8 - played[x.pitch]) % span;
+        if (err > span / 2)
+            err -= span;
+        if (err < -span / 2)
+            err += span;
+        worst = llabs(err) > worst ? llabs(err) : worst;
+    }
+    printf("Clock divisor %u: %u of %u notes recorded, worst start error %lld/256 tick (limit %u/256)\n", DIV,
+           (unsigned)tt.ev.size(), NOTES, (long long)worst, DIV);
+    ok = ok && tt.ev.size() == NOTES && rec.dropped() == 0 && worst < DIV;
+
+    // A note every millisecond for 100 ms, committed from the service pass
+    const uint32_t before = rec.committed(), t0 = us;
+    uint32_t commits = 0;
+    for (uint32_t ms = 1; ms <= 100 + RecordEngine::MIN_GAP_US / 1000; ++ms)
+    {
+        us = t0 + ms * 1000;
+        tx.on1ms(us);
+        while (tx.next(w))
+            ;
+        if (ms <= 100)
+        {
+            rec.onLiveNoteOn((uint8_t)(64 + ms % 32), 100, us);
+            rec.onLiveNoteOff((uint8_t)(64 + ms % 32), us + 500);
+        }
+        if (rec.idle(us))
+        {
+            rec.noteCommitUs(0);
+            commits++;
+        }
+    }
+    const uint32_t burst = rec.committed() - before;
+    printf("Burst: %lu of 100 notes in %lu commits (gap %lu ms)\n", (unsigned long)burst, (unsigned long)commits,
+           (unsigned long)(RecordEngine::MIN_GAP_US / 1000));
+    ok = ok && burst == 100 && rec.dropped() == 0 && commits <= 100 / (RecordEngine::MIN_GAP_US / 1000) + 1;
+
+    printf(ok ? "PASS\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+/**
+ * SMF Import Test & Benchmark (host)
+ *
+ * Writes a type 1 Standard MIDI File with 16 channel tracks and ~50k events
+ * (running status, note-on velocity 0 as note-off, controllers, sysex, meta),
+ * imports it and checks every note against the generated list; then imports
+ * a small type 0 file split across channels. Reports import time and the
+ * importer's fixed memory footprint.
+ *
+ * Build & Run:
+ *   pio run -e native_smf_import -t exec
+ *   (or: g++ -std=gnu++17 -O2 -Isrc test/smf_import_test.cpp)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "model/pattern.hpp"
+#include "model/note_pool.hpp"
+#include "storage/smf_import.hpp"
+
+static constexpr const char *PATH = "smf_import_test.mid";
+static constexpr uint16_t DIVISION = 480;
+static constexpr uint8_t CHANNELS = 16;
+static constexpr uint32_t NOTES = 1550; // per channel: 16 x 1550 x 2 ≈ 50k events
+
+static NotePage pages[1024];
+static NotePool pool;
+static Pattern dst;
+static SmfImporter smf;
+
+struct Expect
+{
+    uint32_t on, dur;
+    int16_t micro;
+    uint8_t pitch, vel;
+};
+static std::vector<Expect> expect[CHANNELS];
+
+struct Writer
+{
+    std::vector<uint8_t> b;
+    void u8(uint8_t v) { b.push_back(v); }
+    void u16(uint16_t v) { u8(v >> 8), u8(v & 0xFF); }
+    void u32(uint32_t v) { u16(v >> 16), u16(v & 0xFFFF); }
+    void vlq(uint32_t v)
+    {
+        uint8_t tmp[4];
+        int n = 0;
+        do
+            tmp[n++] = v & 0x7F;
+        while (v >>= 7);
+        while (n--)
+            u8(tmp[n] | (n ? 0x80 : 0));
+    }
+    void chunk(const char *id, const Writer &body)
+    {
+        b.insert(b.end(), id, id + 4);
+        u32((uint32_t)body.b.size());
+        b.insert(b.end(), body.b.begin(), body.b.end());
+    }
+};
+
+static uint32_t scaled(uint32_t src, int16_t *micro)
+{
+    uint32_t t = (uint32_t)(((uint64_t)src * 96 * 2 + DIVISION) / (2 * DIVISION));
+    if (micro)
+        *micro = (int16_t)(((int64_t)src * 96 - (int64_t)t * DIVISION) * 256 / DIVISION);
+    return t;
+}
+
+static uint32_t events = 0;
+
+// One MTrk per channel; note-offs use running status with velocity 0 half the time
+static void channelTrack(Writer &out, uint8_t ch, unsigned seed)
+{
+    struct Ev
+    {
+        uint32_t at;
+        uint8_t st, d1, d2;
+    };
+    std::vector<Ev> evs;
+    srand(seed);
+    uint32_t t = 0;
+    for (uint32_t i = 0; i < NOTES; ++i)
+    {
+        t += 30 + rand() % 200;
+        uint32_t dur = 1 + rand() % 400;
+        uint8_t pitch = (uint8_t)(24 + (i * 7 + rand() % 5) % 96);
+        // Keep at most one open note per pitch: skip pitches still sounding
+        bool busy = false;
+        for (auto &e : expect[ch])
+            if (e.pitch == pitch && scaled(t, nullptr) < e.on + e.dur + 2)
+                busy = true;
+        if (busy)
+            continue;
+        uint8_t vel = (uint8_t)(1 + rand() % 127);
+        evs.push_back({t, (uint8_t)(0x90 | ch), pitch, vel});
+        bool zeroOff = rand() & 1;
+        evs.push_back({t + dur, (uint8_t)((zeroOff ? 0x90 : 0x80) | ch), pitch, zeroOff ? (uint8_t)0 : (uint8_t)64});
+        if (rand() % 50 == 0)
+            evs.push_back({t, (uint8_t)(0xB0 | ch), 1, (uint8_t)(rand() % 128)});
+        int16_t micro;
+        uint32_t on = scaled(t, &micro);
+        expect[ch].push_back({on, std::max<uint32_t>(1, scaled(t + dur, nullptr) - on), micro, pitch, vel});
+    }
+    std::stable_sort(evs.begin(), evs.end(), [](const Ev &a, const Ev &b)
+                     { return a.at < b.at; });
+
+    Writer w;
+    uint32_t last = 0;
+    uint8_t running = 0;
+    for (const Ev &e : evs)
+    {
+        w.vlq(e.at - last);
+        last = e.at;
+        if (e.st != running)
+            w.u8(e.st), running = e.st;
+        w.u8(e.d1), w.u8(e.d2);
+        events++;
+        if (events % 997 == 0) // sysex cancels running status
+        {
+            w.vlq(0), w.u8(0xF0), w.vlq(3), w.u8(0x7E), w.u8(0x01), w.u8(0xF7);
+            running = 0;
+            events++;
+        }
+    }
+    w.vlq(0), w.u8(0xFF), w.u8(0x2F), w.u8(0);
+    events++;
+    out.chunk("MTrk", w);
+}
+
+static bool writeFile(const Writer &w)
+{
+    FILE *f = fopen(PATH, "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(w.b.data(), 1, w.b.size(), f) == w.b.size();
+    return fclose(f) == 0 && ok;
+}
+
+static bool sameNotes(const Track &trk, std::vector<Expect> want)
+{
+    std::vector<Expect> got;
+    for (size_t i = 0; i < trk.notes.size(); ++i)
+    {
+        Note n = trk.notes[i];
+        got.push_back({n.on, n.duration, n.micro_q8, n.pitch, n.vel});
+    }
+    auto by = [](const Expect &a, const Expect &b)
+    { return a.on != b.on ? a.on < b.on : a.pitch < b.pitch; };
+    std::sort(got.begin(), got.end(), by);
+    std::sort(want.begin(), want.end(), by);
+    if (got.size() != want.size())
+        return false;
+    for (size_t i = 0; i < got.size(); ++i)
+        if (got[i].on != want[i].on || got[i].dur != want[i].dur || got[i].micro != want[i].micro ||
+            got[i].pitch != want[i].pitch || got[i].vel != want[i].vel)
+            return false;
+    return true;
+}
+
+int main()
+{
+    pool.begin(pages, 1024, MemRegion::Dtcm);
+
+    // Type 1: conductor track (tempo, name) + one track per channel
+    Writer file, hdr, conductor;
+    hdr.u16(1), hdr.u16(1 + CHANNELS), hdr.u16(DIVISION);
+    file.chunk("MThd", hdr);
+    conductor.vlq(0), conductor.u8(0xFF), conductor.u8(0x03), conductor.vlq(4);
+    conductor.b.insert(conductor.b.end(), {'t', 'e', 's', 't'});
+    conductor.vlq(0), conductor.u8(0xFF), conductor.u8(0x51), conductor.vlq(3);
+    conductor.u8(0x07), conductor.u8(0xA1), conductor.u8(0x20); // 500000 us = 120 BPM
+    conductor.vlq(0), conductor.u8(0xFF), conductor.u8(0x2F), conductor.u8(0);
+    events += 3;
+    file.chunk("MTrk", conductor);
+    for (uint8_t ch = 0; ch < CHANNELS; ++ch)
+        channelTrack(file, ch, 500 + ch);
+    if (!writeFile(file))
+    {
+        printf("FAIL: cannot write %s\n", PATH);
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    SmfImporter::Result r = smf.import(PATH, dst);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+    uint32_t want = 0;
+    for (auto &e : expect)
+        want += (uint32_t)e.size();
+    bool ok = !r.error && r.format == 1 && r.chunks == 1 + CHANNELS && r.events == events && r.notes == want &&
+              !r.dropped && !r.unmatched && dst.trackCount == CHANNELS && dst.tempo == 120.f;
+    if (r.error)
+        printf("error: %s\n", r.error);
+    for (uint8_t ch = 0; ok && ch < CHANNELS; ++ch)
+        if (dst.tracks[ch].channel != ch + 1 || !sameNotes(dst.tracks[ch], expect[ch]))
+        {
+            printf("mismatch on channel %u\n", ch + 1);
+            ok = false;
+        }
+
+    printf("Type 1: %lu KB, %lu events, %lu notes on %u tracks, pool %u/%u pages\n",
+           (unsigned long)(file.b.size() / 1024), (unsigned long)r.events, (unsigned long)r.notes,
+           dst.trackCount, (unsigned)pool.stats().used, (unsigned)pool.stats().total);
+    printf("Import: %.0f us (%.1f ns/event), importer state %lu bytes\n", us, us * 1000.0 / r.events,
+           (unsigned long)sizeof(SmfImporter));
+
+    // Type 0: one chunk, three channels interleaved, plus a note left hanging
+    for (auto &e : expect)
+        e.clear();
+    Writer f0, h0, trk;
+    h0.u16(0), h0.u16(1), h0.u16(DIVISION);
+    f0.chunk("MThd", h0);
+    const uint8_t chans[3] = {9, 0, 3}; // order of first appearance → track order
+    for (uint8_t i = 0; i < 12; ++i)
+    {
+        uint8_t ch = chans[i % 3];
+        trk.vlq(i % 3 ? 0 : 240), trk.u8(0x90 | ch), trk.u8(60 + i), trk.u8(100);
+        trk.vlq(120), trk.u8(0x80 | ch), trk.u8(60 + i), trk.u8(0);
+    }
+    trk.vlq(0), trk.u8(0x90), trk.u8(40), trk.u8(90);    // never released
+    trk.vlq(480), trk.u8(0xFF), trk.u8(0x2F), trk.u8(0); // closed at the end of track
+    f0.chunk("MTrk", trk);
+    writeFile(f0);
+    SmfImporter::Result r0 = smf.import(PATH, dst);
+    bool ok0 = !r0.error && r0.format == 0 && dst.trackCount == 3 && r0.notes == 13 && r0.unmatched == 1 &&
+               dst.tracks[0].channel == 10 && dst.tracks[1].channel == 1 && dst.tracks[2].channel == 4 &&
+               dst.tracks[0].notes.size() == 4 && dst.tracks[1].notes.size() == 5 &&
+               dst.tracks[1].notes[4].duration == 96 && dst.tracks[0].notes[0].duration == 24;
+    printf("Type 0: %lu notes on %u tracks, %lu unmatched, %u steps\n", (unsigned long)r0.notes,
+           dst.trackCount, (unsigned long)r0.unmatched, dst.steps);
+    remove(PATH);
+
+    if (!ok || !ok0 || us > 1e6)
+    {
+        printf("FAIL%s%s%s\n", ok ? "" : ": type 1", ok0 ? "" : ": type 0", us > 1e6 ? ": too slow" : "");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
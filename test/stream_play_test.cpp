@@ -0,0 +1,208 @@
+/**
+ * Stream Playback Test (host, simulated time)
+ *
+ * Writes a 1M-event stream file, then plays it tick by tick through
+ * StreamPlayer with one idle fill() per tick, as the main loop would:
+ * every note-on must come out once, in order, on its tick, with no underruns,
+ * and the loop wrap must continue from the ring without a locate. Then starves
+ * the reader to check that underruns are counted and the reader catches up with the playhead, and
+ * locates to random ticks against the in-memory event list. A jump nobody
+ * located for must not seek inside the window: it counts an underrun and the
+ * next fill() picks up at the playhead.
+ *
+ * Build & Run:
+ *   pio run -e native_stream_play -t exec
+ *   (or: g++ -std=gnu++17 -O2 -Isrc test/stream_play_test.cpp)
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "engine/stream_player.hpp"
+#include "storage/stream_file.hpp"
+
+static constexpr const char *PATH = "stream_play_test.sms";
+static constexpr uint32_t EVENTS = 1000000;
+static constexpr uint8_t RING = 16;
+static constexpr uint32_t LEAD = 4 * 4 * 96; // four bars
+
+static stream_file::Block ring[RING];
+static std::vector<stream_file::Event> ref;
+
+static void generate()
+{
+    srand(1234);
+    ref.reserve(EVENTS);
+    uint32_t t = 0;
+    for (uint32_t i = 0; i < EVENTS; ++i)
+    {
+        t += (rand() % 8 == 0) ? 0 : rand() % 4; // chords and gaps
+        stream_file::Event e{};
+        e.on = t;
+        e.duration = (uint16_t)(1 + rand() % 48);
+        e.micro = (int8_t)(rand() % 64);
+        e.ch = (uint8_t)(1 + rand() % 16);
+        e.pitch = (uint8_t)(rand() % 128);
+        e.vel = (uint8_t)(1 + rand() % 127);
+        ref.push_back(e);
+    }
+}
+
+int main()
+{
+    generate();
+    remove(PATH);
+    StreamWriter w;
+    auto t0 = std::chrono::steady_clock::now();
+    bool wrote = w.open(PATH);
+    for (const auto &e : ref)
+        wrote = wrote && w.add(e);
+    wrote = wrote && w.finish();
+    double writeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    if (!wrote)
+    {
+        printf("FAIL: cannot write %s\n", PATH);
+        return 1;
+    }
+
+    StreamPlayer sp;
+    sp.begin(ring, RING, LEAD);
+    if (!sp.open(PATH) || sp.events() != EVENTS)
+    {
+        printf("FAIL: open\n");
+        return 1;
+    }
+    const uint32_t len = sp.length();
+
+    // Full pass plus the start of the next one, one window and one idle fill per tick
+    std::vector<MidiEvent> out;
+    out.reserve(256);
+    uint32_t idx = 0, bad = 0, ons = 0, offs = 0;
+    uint32_t prev = 0;
+    const uint32_t extra = 5000;
+    t0 = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < len + extra; ++n)
+    {
+        uint32_t curr = (prev + 1) % len;
+        sp.processTick(prev, curr, 120.f, out);
+        for (const MidiEvent &m : out)
+        {
+            if (!m.on)
+            {
+                offs++;
+                continue;
+            }
+            ons++;
+            const stream_file::Event &e = ref[idx % EVENTS];
+            // Window (prev, curr]; the first one after a start also plays tick prev
+            if (m.pitch != e.pitch || m.ch != e.ch || m.vel != e.vel || (e.on != curr && !(n == 0 && e.on == 0)))
+                bad++;
+            idx++;
+        }
+        out.clear();
+        sp.fill(curr);
+        prev = curr;
+    }
+    double playMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    const StreamPlayer::Stats st = sp.stats();
+
+    uint32_t firstPass = EVENTS, secondPass = 0;
+    for (const auto &e : ref)
+        secondPass += e.on <= extra;
+    bool played = bad == 0 && ons == firstPass + secondPass && st.underruns == 0 && st.dropped == 0 && st.locates == 1;
+    printf("Stream: %lu events, %lu blocks, %lu ticks (%lu bars), written in %.0f ms\n", (unsigned long)EVENTS,
+           (unsigned long)sp.blocks(), (unsigned long)len, (unsigned long)(len / 384), writeMs);
+    printf("Play: %lu note-ons, %lu offs, %lu mismatches, underruns %lu, dropped %lu, locates %lu, min lead %lu ticks, "
+           "%.1f ns/tick\n",
+           (unsigned long)ons, (unsigned long)offs, (unsigned long)bad, (unsigned long)st.underruns,
+           (unsigned long)st.dropped, (unsigned long)st.locates, (unsigned long)st.minLead,
+           playMs * 1e6 / (len + extra));
+
+    // Starved reader: one block every 64 ticks, no lead bursts, cannot keep up with ~0.7 events/tick
+    sp.allOff(out);
+    out.clear();
+    sp.begin(ring, RING, 0);
+    sp.open(PATH);
+    prev = 0;
+    for (uint32_t n = 0; n + 1 < len; ++n)
+    {
+        sp.processTick(prev, prev + 1, 120.f, out);
+        out.clear();
+        if (n % 64 == 0)
+            sp.fill(prev + 1, 1);
+        prev++;
+    }
+    const StreamPlayer::Stats ss = sp.stats();
+    bool starved = ss.underruns > 0 && ss.resyncs > 0 && ss.played + ss.dropped <= EVENTS && ss.played > EVENTS / 10;
+    printf("Starved: underruns %lu, resyncs %lu, dropped %lu, played %lu\n", (unsigned long)ss.underruns,
+           (unsigned long)ss.resyncs, (unsigned long)ss.dropped, (unsigned long)ss.played);
+
+    // Locate: the first note-on after a jump is the first event at or after the target
+    uint32_t locBad = 0;
+    srand(99);
+    t0 = std::chrono::steady_clock::now();
+    for (int k = 0; k < 1000; ++k)
+    {
+        uint32_t at = (uint32_t)(((uint64_t)rand() * 7919u) % (len - 2));
+        sp.allOff(out);
+        out.clear();
+        sp.locate(at); // as on a transport locate, outside the tick loop
+        sp.processTick(at, at + 1, 120.f, out);
+        size_t lo = 0, hi = ref.size();
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            if (ref[mid].on < at)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        size_t want = 0;
+        for (size_t i = lo; i < ref.size() && ref[i].on <= at + 1; ++i)
+            want++;
+        size_t got = 0;
+        for (const MidiEvent &m : out)
+            got += m.on;
+        bool first = want == 0 || (!out.empty() && out[0].on && out[0].pitch == ref[lo].pitch && out[0].ch == ref[lo].ch);
+        if (got != want || !first)
+            locBad++;
+    }
+    double locUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / 1000;
+    printf("Locate: 1000 jumps, %lu wrong, %.1f us each\n", (unsigned long)locBad, locUs);
+
+    // Unannounced jump: the window only flags it, the following fill() seeks
+    const StreamPlayer::Stats before = sp.stats();
+    sp.allOff(out);
+    out.clear();
+    sp.processTick(len / 2, len / 2 + 1, 120.f, out);
+    const bool flagged = out.empty() && sp.stats().underruns == before.underruns + 1 && sp.stats().locates == before.locates;
+    sp.fill(len / 2 + 1);
+    uint32_t caught = 0;
+    for (uint32_t t = len / 2 + 1; t < len / 2 + 2000; ++t)
+    {
+        out.clear();
+        sp.processTick(t, t + 1, 120.f, out);
+        for (const MidiEvent &m : out)
+            caught += m.on;
+        sp.fill(t + 1);
+    }
+    size_t expect = 0;
+    for (const auto &e : ref)
+        expect += e.on > len / 2 + 1 && e.on <= len / 2 + 2000;
+    const bool resynced = flagged && sp.stats().resyncs == before.resyncs + 1 && caught == expect;
+    printf("Jump: underrun %s, resynced %s, %lu of %lu note-ons after it\n", flagged ? "flagged" : "missed",
+           resynced ? "at the next fill" : "late", (unsigned long)caught, (unsigned long)expect);
+    sp.close();
+    remove(PATH);
+
+    if (!played || !starved || locBad || !resynced)
+    {
+        printf("FAIL%s%s%s%s\n", played ? "" : ": playback", starved ? "" : ": starvation", locBad ? ": locate" : "",
+               resynced ? "" : ": jump");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * Loop Take Test (host)
+ *
+ * Records 40 passes of 96 notes each into a TakeStack: the buffer must stay
+ * within its fixed size by evicting the oldest takes (inactive ones before
+ * active ones) without touching the take being recorded. Then a track with
+ * 20 muted takes must compile to the same timeline as the track alone (build
+ * time printed for both) and must not rebuild while they change; auditioning one take
+ * merges exactly its notes in start order. Comping a range and flattening
+ * the active takes must land the right notes in the track.
+ *
+ * Build & Run:
+ *   pio run -e native_take -t exec
+ *   (or: g++ -std=gnu++17 -O2 -Isrc test/take_test.cpp)
+ */
+
+#include <chrono>
+#include <cstdio>
+
+#include "engine/timeline.hpp"
+#include "model/take_stack.hpp"
+
+static NotePage pages[512];
+static NotePool pool;
+static Pattern pat;
+static Timeline tl;
+static TakeStack ts;
+
+static constexpr uint16_t PASS_NOTES = 96;
+
+// One pass: a note every 4 ticks, pitch marks the pass, played slightly late
+static void pass(uint8_t trk, uint8_t p)
+{
+    ts.begin(trk);
+    for (uint16_t k = 0; k < PASS_NOTES; ++k)
+    {
+        Note n{};
+        n.on = (uint32_t)(PASS_NOTES - 1 - k) * 4; // committed out of order
+        n.duration = 2;
+        n.micro_q8 = 40;
+        n.pitch = (uint8_t)(p & 0x7F);
+        n.vel = 100;
+        ts.append(n);
+    }
+}
+
+static bool sorted(const NoteStore &ev)
+{
+    for (size_t i = 1; i < ev.size(); ++i)
+        if (ev.onAt(i - 1) > ev.onAt(i))
+            return false;
+    return true;
+}
+
+static double buildNs(const TakeStack *takes)
+{
+    const int REPS = 200;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < REPS; ++r)
+    {
+        tl.clear();
+        tl.build(pat, Timeline::MAX_TRACKS, takes);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / REPS;
+}
+
+int main()
+{
+    bool ok = true;
+    pool.begin(pages, 512, MemRegion::Dtcm);
+    pat.steps = 16;
+    pat.trackCount = 1;
+    Track &trk = pat.tracks[0];
+    for (uint32_t s = 0; s < 16; ++s)
+    {
+        Note n{};
+        n.on = s * 24;
+        n.duration = 12;
+        n.pitch = 36;
+        n.vel = 100;
+        trk.notes.push_back(n);
+    }
+
+    // Eviction under the buffer budget; keep take 1 of track 0 active so it goes last
+    ts.setStacking(true);
+    for (uint8_t p = 0; p < 40; ++p)
+    {
+        pass(p == 0 ? 0 : 1, p);
+        if (p > 0)
+            ts.setActive(ts.open(), false);
+    }
+    bool bounded = ts.used() <= TakeStack::CAP && ts.count() <= TakeStack::MAX_TAKES;
+    const TakeStack::Take &last = ts.take(ts.count() - 1);
+    bounded = bounded && ts.open() == ts.count() - 1 && last.count == PASS_NOTES && last.id == 40;
+    bounded = bounded && ts.take(0).trk == 0 && ts.take(0).active && ts.dropped() == 0;
+    printf("40 passes x %u notes: %u takes kept, %u/%u notes, %lu evicted, first kept #%u (active), %s\n",
+           PASS_NOTES, ts.count(), ts.used(), TakeStack::CAP, (unsigned long)ts.evicted(), ts.take(0).id,
+           bounded ? "OK" : "WRONG");
+    ok = ok && bounded;
+
+    // Track 0 with 20 muted takes vs none
+    ts.clear();
+    for (uint8_t p = 0; p < 20; ++p)
+        pass(0, p);
+    for (uint8_t i = 0; i < ts.count(); ++i)
+        ts.setActive(i, false);
+    const double nsTakes = buildNs(&ts), nsPlain = buildNs(nullptr);
+    tl.clear();
+    tl.build(pat, Timeline::MAX_TRACKS, &ts);
+    bool muted = ts.count() == 20 && tl.track(0).ev.size() == 16 && !tl.stale(pat, &ts);
+    ts.append(Note{});
+    muted = muted && !tl.stale(pat, &ts); // the muted take being recorded grew: nothing to rebuild
+    ts.close();
+    printf("20 muted takes: %zu events, build %.0f ns (track alone %.0f ns), no rebuild on muted edits: %s\n",
+           tl.track(0).ev.size(), nsTakes, nsPlain, muted ? "OK" : "WRONG");
+    ok = ok && muted;
+
+    // Audition take 5: its notes merge in, stretched like the track's
+    ts.audition(4);
+    bool aud = tl.stale(pat, &ts);
+    tl.build(pat, Timeline::MAX_TRACKS, &ts);
+    const NoteStore &ev = tl.track(0).ev;
+    uint32_t fromTake = 0;
+    for (size_t i = 0; i < ev.size(); ++i)
+        fromTake += ev.get(i).pitch == ts.note(4, 0).pitch && ev.get(i).micro_q8 == 40;
+    aud = aud && ev.size() == 16 + PASS_NOTES && fromTake == PASS_NOTES && sorted(ev);
+    printf("Audition take 5: %zu events (%lu from the take), sorted %s\n", ev.size(), (unsigned long)fromTake,
+           aud ? "OK" : "WRONG");
+    ok = ok && aud;
+
+    // Comp steps 4..8 of take 5 into the track, then flatten take 6 on top
+    ts.comp(4, trk, 4 * 24, 8 * 24);
+    uint32_t base = 0, comped = 0;
+    for (size_t i = 0; i < trk.notes.size(); ++i)
+        (trk.notes.get(i).pitch == 36 ? base : comped)++;
+    bool comp = base == 12 && comped == 24;
+    ts.audition(5);
+    const uint8_t before = ts.count();
+    comp = comp && ts.flatten(0, trk) && trk.notes.size() == 12 + 24 + PASS_NOTES && ts.count() == before - 1;
+    printf("Comp steps 4-8: %lu track + %lu comped notes; flatten: %zu notes, %u takes left %s\n",
+           (unsigned long)base, (unsigned long)comped, trk.notes.size(), ts.count(), comp ? "OK" : "WRONG");
+    ok = ok && comp;
+
+    printf(ok ? "PASS\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+/**
+ * Trig Probability / Condition Test (host)
+ *
+ * Checks the xorshift generator's percent() distribution (chi-square over
+ * 100 buckets), then plays a pattern through PlaybackEngine with notes at
+ * 25/50/90% probability and 1:2, 3:4, fill and first-pass conditions:
+ * hit rates must match, a replay with the same seed must produce the
+ * identical event stream, and a different seed a different one. A locate
+ * into a later loop of a 4-step track must keep the A:B phase of the
+ * position and still play First once, also across a timeline rebuild.
+ *
+ * Build & Run:
+ *   pio run -e native_trig -t exec
+ *   (or: g++ -std=gnu++17 -O2 -Isrc test/trig_test.cpp)
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "core/xorshift.hpp"
+#include "engine/playback_engine.hpp"
+
+static NotePage pages[256];
+static NotePool pool;
+static Pattern pat, poly;
+static Timeline tl, ptl;
+
+static constexpr uint32_t LOOPS = 2000;
+
+struct Hit
+{
+    uint32_t tick;
+    uint8_t ch, pitch;
+};
+
+// Track t holds one note per 1/16 step, all with the same trig
+static void track(uint8_t t, uint8_t skip, uint8_t cond)
+{
+    Track &trk = pat.tracks[t];
+    trk.channel = t + 1;
+    for (uint32_t s = 0; s < 16; ++s)
+    {
+        Note n{};
+        n.on = s * 24;
+        n.duration = 12;
+        n.pitch = 60;
+        n.vel = 100;
+        n.skip = skip;
+        n.cond = cond;
+        trk.notes.push_back(n);
+    }
+}
+
+// Play LOOPS pattern passes from a stop; fill turns on for the second half
+static std::vector<Hit> play(uint32_t seed, uint32_t counts[Pattern::MAX_TRACKS], double &nsPerTick)
+{
+    PlaybackEngine eng;
+    eng.setSeed(seed);
+    std::vector<MidiEvent> out;
+    std::vector<Hit> hits;
+    out.reserve(64);
+    const uint32_t len = pat.ticks();
+    for (uint8_t t = 0; t < Pattern::MAX_TRACKS; ++t)
+        counts[t] = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    uint32_t prev = 0;
+    for (uint32_t n = 0; n + 1 < LOOPS * len; ++n) // stop before the window that wraps into pass LOOPS
+    {
+        const uint32_t curr = (prev + 1) % len;
+        eng.setFill(n + 1 >= LOOPS / 2 * len); // from the window holding the first tick of the fill half
+        eng.processTick(prev, curr, tl, 120.f, out);
+        for (const MidiEvent &m : out)
+            if (m.on)
+            {
+                hits.push_back(Hit{n, m.ch, m.pitch});
+                counts[m.ch - 1]++;
+            }
+        out.clear();
+        prev = curr;
+    }
+    nsPerTick = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / (LOOPS * len);
+    return hits;
+}
+
+// Locate into pattern loop 3 of a 4-step (96-tick) track, play two pattern loops with a rebuild halfway;
+// returns the ticks at which track t played
+static std::vector<uint32_t> locate(uint8_t t, uint32_t &firstPass)
+{
+    PlaybackEngine eng;
+    std::vector<MidiEvent> out;
+    std::vector<uint32_t> at;
+    const uint32_t len = poly.ticks(), pos = 3 * len + 10;
+    uint32_t prev = pos;
+    for (uint32_t n = 0; n < 2 * len; ++n)
+    {
+        if (n == len)
+        {
+            Note x = poly.tracks[2].notes.get(0);
+            x.vel--;
+            poly.tracks[2].notes.set(0, x);
+            ptl.build(poly);
+        }
+        const uint32_t curr = prev + 1;
+        eng.processTick(prev, curr, ptl, 120.f, out);
+        for (const MidiEvent &m : out)
+            if (m.on && m.ch == t + 1)
+                at.push_back(curr);
+        out.clear();
+        prev = curr;
+    }
+    firstPass = (pos + 96 - 1) / 96; // located past the only note: the next pass is the first played
+    return at;
+}
+
+int main()
+{
+    bool ok = true;
+
+    // Distribution of percent()
+    XorShift32 r(12345);
+    const uint32_t DRAWS = 1000000;
+    uint32_t bucket[100] = {};
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < DRAWS; ++i)
+        bucket[r.percent()]++;
+    double drawNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / DRAWS;
+    double chi = 0, exp = DRAWS / 100.0;
+    for (uint32_t b : bucket)
+        chi += (b - exp) * (b - exp) / exp;
+    // 99 degrees of freedom: p = 0.001 at ~148.2
+    const bool uniform = chi < 148.2;
+    printf("percent(): chi-square %.1f over 100 buckets (limit 148.2), %.2f ns/draw\n", chi, drawNs);
+    ok = ok && uniform;
+
+    pool.begin(pages, 256, MemRegion::Dtcm);
+    pat.steps = 16;
+    pat.trackCount = 8;
+    track(0, 75, trig::Always);        // 25%
+    track(1, 50, trig::Always);        // 50%
+    track(2, 10, trig::Always);        // 90%
+    track(3, 0, trig::every(1, 2));    // passes 0, 2, 4...
+    track(4, 0, trig::every(3, 4));    // passes 2, 6, 10...
+    track(5, 0, trig::Fill);           // second half only
+    track(6, 0, trig::First);          // first pass only
+    track(7, 50, trig::every(2, 2));   // 50% of odd passes
+    tl.build(pat);
+
+    uint32_t c1[Pattern::MAX_TRACKS], c2[Pattern::MAX_TRACKS], c3[Pattern::MAX_TRACKS];
+    double ns1, ns2, ns3;
+    std::vector<Hit> a = play(7, c1, ns1), b = play(7, c2, ns2), c = play(8, c3, ns3);
+
+    const double notes = 16.0 * LOOPS;
+    struct Expect
+    {
+        const char *name;
+        double rate, tol;
+    } expect[8] = {{"25%", 0.25, 0.01}, {"50%", 0.5, 0.01}, {"90%", 0.9, 0.01}, {"1:2", 0.5, 0},
+                   {"3:4", 0.25, 0},   {"fill", 0.5, 0},   {"1st", 1 / (double)LOOPS, 0}, {"50% 2:2", 0.25, 0.01}};
+    for (uint8_t t = 0; t < 8; ++t)
+    {
+        const double rate = c1[t] / notes;
+        const bool good = std::fabs(rate - expect[t].rate) <= expect[t].tol + 1e-9;
+        printf("  track %u %-8s %6lu/%.0f = %.4f (want %.4f)%s\n", t + 1, expect[t].name, (unsigned long)c1[t], notes,
+               rate, expect[t].rate, good ? "" : "  <-- off");
+        ok = ok && good;
+    }
+
+    bool same = a.size() == b.size();
+    for (size_t i = 0; same && i < a.size(); ++i)
+        same = a[i].tick == b[i].tick && a[i].ch == b[i].ch;
+    bool differs = a.size() != c.size();
+    for (size_t i = 0; !differs && i < a.size(); ++i)
+        differs = a[i].tick != c[i].tick || a[i].ch != c[i].ch;
+    printf("Replay: seed 7 twice %s (%zu note-ons), seed 8 %s; %.1f ns/tick\n", same ? "identical" : "DIFFERENT",
+           a.size(), differs ? "differs" : "IDENTICAL", ns1);
+    ok = ok && same && differs;
+
+    // Locate: A:B keeps the position's phase, First plays once on the first pass played
+    poly.steps = 16;
+    poly.trackCount = 3;
+    for (uint8_t t = 0; t < 3; ++t)
+    {
+        Track &trk = poly.tracks[t];
+        trk.channel = t + 1;
+        trk.steps = t < 2 ? 4 : 0;
+        Note n{};
+        n.duration = 12;
+        n.pitch = 60;
+        n.vel = 100;
+        n.cond = t == 0 ? (uint8_t)trig::First : (t == 1 ? trig::every(2, 4) : (uint8_t)trig::Always);
+        trk.notes.push_back(n);
+    }
+    ptl.build(poly);
+    uint32_t firstPass;
+    const std::vector<uint32_t> first = locate(0, firstPass), ab = locate(1, firstPass);
+    bool phase = !ab.empty();
+    for (uint32_t x : ab)
+        phase = phase && x % 96 == 0 && (x / 96) % 4 == 1;
+    printf("Locate to pattern loop 3 (track pass %lu): First played %zu time(s)%s, 2:4 on %zu passes %s\n",
+           (unsigned long)firstPass, first.size(), first.size() == 1 && first[0] == firstPass * 96 ? "" : " WRONG",
+           ab.size(), phase ? "in phase" : "OUT OF PHASE");
+    ok = ok && first.size() == 1 && first[0] == firstPass * 96 && phase && ab.size() == 2 * 4 / 4;
+
+    printf(ok ? "PASS\n" : "FAIL\n");
+    return ok ? 0 : 1;
+}